@@ -0,0 +1,333 @@
+#include "annotationindex.h"
+#include "annotationwriter.h"
+#include <QFileInfo>
+#include <QRunnable>
+#include <QThread>
+#include <algorithm>
+#include <climits>
+
+// rows a worker claims at a time, also the granularity of the progress reports
+static const int ChunkSize = 64;
+
+class AnnotationIndexTask : public QRunnable
+{
+public:
+    AnnotationIndexTask(AnnotationIndex *index, int serial, int classCount):
+        _index(index),
+        _serial(serial),
+        _classCount(classCount)
+    {
+    }
+
+    void run() override
+    {
+        // indexing must not slow down decoding the image on screen
+        QThread::currentThread()->setPriority(QThread::LowPriority);
+
+        int begin;
+        QStringList paths;
+        while (_index->nextChunk(_serial, &begin, &paths)) {
+            QVector<AnnotationIndex::Entry> entries;
+            entries.reserve(paths.count());
+            foreach (const QString &path, paths) {
+                QVector<YoloBox> labels;
+                YoloLabel::parse(AnnotationWriter::instance()->read(AnnotationIndex::labelFileName(path)),
+                                 _classCount, &labels);
+                entries.append(AnnotationIndex::entry(labels, _classCount));
+            }
+            _index->setEntries(_serial, begin, entries);
+        }
+    }
+
+private:
+    AnnotationIndex *_index;
+    int _serial;
+    int _classCount;
+};
+
+AnnotationIndex::AnnotationIndex(QObject *parent):
+    QObject(parent),
+    _serial(0)
+{
+    _pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+AnnotationIndex::~AnnotationIndex()
+{
+    cancel();
+    _pool.waitForDone();
+}
+
+QString AnnotationIndex::labelFileName(const QString &imagePath)
+{
+    QFileInfo info(imagePath);
+    return info.path() + "/" + info.completeBaseName() + ".txt";
+}
+
+void AnnotationIndex::build(const QStringList &imagePaths, int classCount)
+{
+    cancel();
+    int serial = _serial.load();
+    {
+        QMutexLocker locker(&_mutex);
+        _paths = imagePaths;
+        _rows.clear();
+        _labelRows.clear();
+        for (int i = 0; i < imagePaths.count(); i++) {
+            _rows.insert(imagePaths.at(i), i);
+            _labelRows.insert(labelFileName(imagePaths.at(i)), i);
+        }
+        _entries = QVector<Entry>(imagePaths.count());
+        _classRows.clear();
+        _classCount = classCount;
+        _next = 0;
+        _indexed = 0;
+        _isReady = imagePaths.isEmpty();
+    }
+
+    if (imagePaths.isEmpty()) {
+        emit ready();
+        return;
+    }
+    emit progress(0, imagePaths.count());
+    for (int i = 0; i < _pool.maxThreadCount(); i++) {
+        _pool.start(new AnnotationIndexTask(this, serial, classCount));
+    }
+}
+
+void AnnotationIndex::cancel()
+{
+    _serial.fetchAndAddOrdered(1);
+    _pool.clear();
+}
+
+bool AnnotationIndex::isReady() const
+{
+    QMutexLocker locker(&_mutex);
+    return _isReady;
+}
+
+int AnnotationIndex::imageCount() const
+{
+    QMutexLocker locker(&_mutex);
+    return _entries.count();
+}
+
+int AnnotationIndex::row(const QString &imagePath) const
+{
+    QMutexLocker locker(&_mutex);
+    return _rows.value(imagePath, -1);
+}
+
+int AnnotationIndex::boxCount(int row) const
+{
+    QMutexLocker locker(&_mutex);
+    if (row < 0 || row >= _entries.count())
+        return -1;
+    return _entries.at(row).boxCount;
+}
+
+QBitArray AnnotationIndex::classes(int row) const
+{
+    QMutexLocker locker(&_mutex);
+    if (row < 0 || row >= _entries.count())
+        return QBitArray();
+    return _entries.at(row).classes;
+}
+
+QVector<int> AnnotationIndex::rowsWithClass(int classIndex) const
+{
+    QMutexLocker locker(&_mutex);
+    return _classRows.value(classIndex);
+}
+
+void AnnotationIndex::update(const QString &imagePath, const QVector<YoloBox> &labels)
+{
+    QMutexLocker locker(&_mutex);
+    int row = _rows.value(imagePath, -1);
+    if (row < 0)
+        return;
+
+    Entry updated = entry(labels, _classCount);
+    updated.isUpdated = true;
+
+    // only the classes that changed move in their sorted row lists
+    if (_isReady) {
+        const QBitArray &old = _entries.at(row).classes;
+        for (int c = 0; c < _classCount; c++) {
+            if (old.testBit(c) == updated.classes.testBit(c))
+                continue;
+            QVector<int> &rows = _classRows[c];
+            QVector<int>::iterator it = std::lower_bound(rows.begin(), rows.end(), row);
+            if (updated.classes.testBit(c))
+                rows.insert(it, row);
+            else
+                rows.erase(it);
+        }
+        setCount(row, updated.boxCount);
+    }
+    _entries[row] = updated;
+}
+
+int AnnotationIndex::nextUnlabeled(int row, bool isForward) const
+{
+    QMutexLocker locker(&_mutex);
+    if (!_isReady || _leafCount == 0)
+        return -1;
+    return findCount(1, 0, _leafCount - 1, row, isForward, false, 1);
+}
+
+int AnnotationIndex::nextWithClass(int classIndex, int row, bool isForward) const
+{
+    QMutexLocker locker(&_mutex);
+    if (!_isReady || classIndex < 0 || classIndex >= _classRows.count())
+        return -1;
+
+    const QVector<int> &rows = _classRows.at(classIndex);
+    if (isForward) {
+        QVector<int>::const_iterator it = std::upper_bound(rows.constBegin(), rows.constEnd(), row);
+        return it != rows.constEnd() ? *it : -1;
+    }
+    QVector<int>::const_iterator it = std::lower_bound(rows.constBegin(), rows.constEnd(), row);
+    return it != rows.constBegin() ? *(it - 1) : -1;
+}
+
+int AnnotationIndex::nextWithMoreBoxes(int count, int row, bool isForward) const
+{
+    QMutexLocker locker(&_mutex);
+    if (!_isReady || _leafCount == 0)
+        return -1;
+    return findCount(1, 0, _leafCount - 1, row, isForward, true, count);
+}
+
+void AnnotationIndex::reload(const QString &labelFile)
+{
+    QString imagePath;
+    int classCount;
+    {
+        QMutexLocker locker(&_mutex);
+        int row = _labelRows.value(labelFile, -1);
+        if (row < 0)
+            return;
+        imagePath = _paths.at(row);
+        classCount = _classCount;
+    }
+
+    QVector<YoloBox> labels;
+    YoloLabel::parse(AnnotationWriter::instance()->read(labelFile), classCount, &labels);
+    update(imagePath, labels);
+}
+
+bool AnnotationIndex::nextChunk(int serial, int *begin, QStringList *paths)
+{
+    QMutexLocker locker(&_mutex);
+    if (serial != _serial.load() || _next >= _paths.count())
+        return false;
+
+    *begin = _next;
+    *paths = _paths.mid(_next, ChunkSize);
+    _next += paths->count();
+    return true;
+}
+
+void AnnotationIndex::setEntries(int serial, int begin, const QVector<Entry> &entries)
+{
+    QMutexLocker locker(&_mutex);
+    if (serial != _serial.load())
+        return;
+
+    for (int i = 0; i < entries.count(); i++) {
+        if (!_entries.at(begin + i).isUpdated)
+            _entries[begin + i] = entries.at(i);
+    }
+    _indexed += entries.count();
+
+    int indexed = _indexed;
+    int total = _entries.count();
+    if (indexed == total) {
+        buildClassRows();
+        buildCountTree();
+        _isReady = true;
+    }
+    locker.unlock();
+
+    emit progress(indexed, total);
+    if (indexed == total)
+        emit ready();
+}
+
+AnnotationIndex::Entry AnnotationIndex::entry(const QVector<YoloBox> &labels, int classCount)
+{
+    Entry entry;
+    entry.boxCount = labels.count();
+    entry.classes = QBitArray(classCount);
+    foreach (const YoloBox &label, labels) {
+        if (label.classIndex >= 0 && label.classIndex < classCount)
+            entry.classes.setBit(label.classIndex);
+    }
+    return entry;
+}
+
+void AnnotationIndex::buildClassRows()
+{
+    // rows are visited in order, so every list comes out sorted
+    _classRows = QVector<QVector<int>>(_classCount);
+    for (int row = 0; row < _entries.count(); row++) {
+        const QBitArray &classes = _entries.at(row).classes;
+        for (int c = 0; c < _classCount; c++) {
+            if (classes.testBit(c))
+                _classRows[c].append(row);
+        }
+    }
+}
+
+void AnnotationIndex::buildCountTree()
+{
+    // leaves past the last row and rows without a count never match a search
+    _leafCount = 1;
+    while (_leafCount < _entries.count())
+        _leafCount *= 2;
+    _minCounts = QVector<int>(2 * _leafCount, INT_MAX);
+    _maxCounts = QVector<int>(2 * _leafCount, -1);
+
+    for (int row = 0; row < _entries.count(); row++) {
+        int count = _entries.at(row).boxCount;
+        _minCounts[_leafCount + row] = count < 0 ? INT_MAX : count;
+        _maxCounts[_leafCount + row] = count;
+    }
+    for (int node = _leafCount - 1; node > 0; node--) {
+        _minCounts[node] = qMin(_minCounts.at(2 * node), _minCounts.at(2 * node + 1));
+        _maxCounts[node] = qMax(_maxCounts.at(2 * node), _maxCounts.at(2 * node + 1));
+    }
+}
+
+void AnnotationIndex::setCount(int row, int count)
+{
+    int node = _leafCount + row;
+    _minCounts[node] = count < 0 ? INT_MAX : count;
+    _maxCounts[node] = count;
+    for (node /= 2; node > 0; node /= 2) {
+        _minCounts[node] = qMin(_minCounts.at(2 * node), _minCounts.at(2 * node + 1));
+        _maxCounts[node] = qMax(_maxCounts.at(2 * node), _maxCounts.at(2 * node + 1));
+    }
+}
+
+int AnnotationIndex::findCount(int node, int low, int high, int row, bool isForward, bool isAbove, int count) const
+{
+    // ranges on the wrong side of the row, or without any match, are skipped whole
+    if (isForward ? high <= row : low >= row)
+        return -1;
+    if (isAbove ? _maxCounts.at(node) <= count : _minCounts.at(node) >= count)
+        return -1;
+    if (low == high)
+        return low;
+
+    // the half nearest to the row is searched first
+    int middle = (low + high) / 2;
+    int found = isForward ? findCount(2 * node, low, middle, row, isForward, isAbove, count)
+                          : findCount(2 * node + 1, middle + 1, high, row, isForward, isAbove, count);
+    if (found >= 0)
+        return found;
+    return isForward ? findCount(2 * node + 1, middle + 1, high, row, isForward, isAbove, count)
+                     : findCount(2 * node, low, middle, row, isForward, isAbove, count);
+}
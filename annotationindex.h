@@ -0,0 +1,99 @@
+#ifndef ANNOTATIONINDEX_H
+#define ANNOTATIONINDEX_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QBitArray>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include "yololabel.h"
+
+/**
+ * @brief The AnnotationIndex class knows the boxes of every image of the
+ *        open folder without visiting them.
+ *
+ * build() parses the label files on a pool of workers, each one claiming
+ * a chunk of rows at a time. Per image it keeps the box count and the set
+ * of classes, and once every row is indexed, the sorted list of rows per
+ * class. Progress is reported while building.
+ *
+ * The jumps to the next image with a class, without boxes or with more
+ * than a number of boxes are answered in logarithmic time, from the sorted
+ * class rows and from a segment tree over the box counts that keeps the
+ * minimum and maximum of every range.
+ *
+ * Images saved afterwards are updated in place through update(), label
+ * files changed by other programs through reload().
+ */
+class AnnotationIndex : public QObject
+{
+    Q_OBJECT
+public:
+    AnnotationIndex(QObject *parent = 0);
+    ~AnnotationIndex();
+
+    void build(const QStringList &imagePaths, int classCount);
+    void cancel();
+    bool isReady() const;
+
+    int imageCount() const;
+    int row(const QString &imagePath) const;
+    // -1 while the row is not indexed yet
+    int boxCount(int row) const;
+    QBitArray classes(int row) const;
+    QVector<int> rowsWithClass(int classIndex) const;
+
+    // the nearest matching row after or before the given one, -1 if there is none
+    int nextUnlabeled(int row, bool isForward) const;
+    int nextWithClass(int classIndex, int row, bool isForward) const;
+    int nextWithMoreBoxes(int count, int row, bool isForward) const;
+
+    static QString labelFileName(const QString &imagePath);
+
+public slots:
+    void update(const QString &imagePath, const QVector<YoloBox> &labels);
+    void reload(const QString &labelFile);
+
+signals:
+    void progress(int indexed, int total);
+    void ready();
+
+private:
+    friend class AnnotationIndexTask;
+
+    struct Entry {
+        int boxCount = -1;
+        QBitArray classes;
+        // saved since the build started, a worker must not overwrite it
+        bool isUpdated = false;
+    };
+
+    bool nextChunk(int serial, int *begin, QStringList *paths);
+    void setEntries(int serial, int begin, const QVector<Entry> &entries);
+    static Entry entry(const QVector<YoloBox> &labels, int classCount);
+    void buildClassRows();
+    void buildCountTree();
+    void setCount(int row, int count);
+    int findCount(int node, int low, int high, int row, bool isForward, bool isAbove, int count) const;
+
+    mutable QMutex _mutex;
+    QThreadPool _pool;
+    QAtomicInt _serial;
+    QStringList _paths;
+    QHash<QString, int> _rows;
+    QHash<QString, int> _labelRows;
+    QVector<Entry> _entries;
+    QVector<QVector<int>> _classRows;
+    QVector<int> _minCounts;
+    QVector<int> _maxCounts;
+    int _leafCount = 0;
+    int _classCount = 0;
+    int _next = 0;
+    int _indexed = 0;
+    bool _isReady = false;
+};
+
+#endif // ANNOTATIONINDEX_H
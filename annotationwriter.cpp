@@ -0,0 +1,114 @@
+#include "annotationwriter.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QtDebug>
+
+AnnotationWriter::AnnotationWriter()
+{
+    start(QThread::LowPriority);
+}
+
+AnnotationWriter::~AnnotationWriter()
+{
+    // the queue is drained before the thread finishes
+    {
+        QMutexLocker locker(&_mutex);
+        _isQuitting = true;
+        _queued.wakeAll();
+    }
+    wait();
+}
+
+AnnotationWriter *AnnotationWriter::instance()
+{
+    static AnnotationWriter writer;
+    return &writer;
+}
+
+void AnnotationWriter::write(const QString &fileName, const QByteArray &content)
+{
+    QMutexLocker locker(&_mutex);
+    if (!_pending.contains(fileName))
+        _queue.append(fileName);
+    _pending.insert(fileName, content);
+    _queued.wakeOne();
+}
+
+bool AnnotationWriter::pendingContent(const QString &fileName, QByteArray *content) const
+{
+    QMutexLocker locker(&_mutex);
+    if (_pending.contains(fileName)) {
+        if (content)
+            *content = _pending.value(fileName);
+        return true;
+    }
+    if (_writing == fileName) {
+        if (content)
+            *content = _writingContent;
+        return true;
+    }
+
+    return false;
+}
+
+QByteArray AnnotationWriter::read(const QString &fileName) const
+{
+    // a snapshot still waiting to be written is newer than the file
+    QByteArray content;
+    if (!pendingContent(fileName, &content)) {
+        QFile file(fileName);
+        if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+            content = file.readAll();
+    }
+    return content;
+}
+
+void AnnotationWriter::flush()
+{
+    QMutexLocker locker(&_mutex);
+    while (!_queue.isEmpty() || !_writing.isEmpty())
+        _idle.wait(&_mutex);
+}
+
+void AnnotationWriter::run()
+{
+    forever {
+        QMutexLocker locker(&_mutex);
+        while (_queue.isEmpty() && !_isQuitting)
+            _queued.wait(&_mutex);
+        if (_queue.isEmpty())
+            break;
+
+        _writing = _queue.takeFirst();
+        _writingContent = _pending.take(_writing);
+        QString fileName = _writing;
+        QByteArray content = _writingContent;
+        locker.unlock();
+
+        bool ok = writeFile(fileName, content);
+
+        locker.relock();
+        _writing.clear();
+        _writingContent.clear();
+        if (_queue.isEmpty())
+            _idle.wakeAll();
+        locker.unlock();
+
+        if (ok)
+            emit fileWritten(fileName, content);
+        else
+            emit writeFailed(fileName);
+    }
+}
+
+bool AnnotationWriter::writeFile(const QString &fileName, const QByteArray &content)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)
+            || file.write(content) != content.size() || !file.commit()) {
+        qWarning() << "Cannot write" << fileName << file.errorString();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef ANNOTATIONWRITER_H
+#define ANNOTATIONWRITER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
+
+/**
+ * @brief The AnnotationWriter class writes label files on a background
+ *        thread.
+ *
+ * Callers hand over a snapshot of the file content. Snapshots of a file
+ * that is still queued replace the queued one, so only the latest content
+ * is written. Files are replaced through QSaveFile, which writes a
+ * temporary file, syncs it to disk and renames it over the label file.
+ *
+ * Readers look up pending content first, a file is never read while a
+ * newer version of it is still on its way to disk. Every file written is
+ * reported, so watchers can tell these writes from other programs'.
+ */
+class AnnotationWriter : public QThread
+{
+    Q_OBJECT
+public:
+    static AnnotationWriter *instance();
+    ~AnnotationWriter();
+
+    void write(const QString &fileName, const QByteArray &content);
+    bool pendingContent(const QString &fileName, QByteArray *content = nullptr) const;
+    // the pending content, or else the file on disk, empty when there is neither
+    QByteArray read(const QString &fileName) const;
+    void flush();
+
+signals:
+    // emitted on the writer thread
+    void fileWritten(QString fileName, QByteArray content);
+    void writeFailed(QString fileName);
+
+protected:
+    void run() override;
+
+private:
+    AnnotationWriter();
+    static bool writeFile(const QString &fileName, const QByteArray &content);
+
+    mutable QMutex _mutex;
+    QWaitCondition _queued;
+    QWaitCondition _idle;
+    // files in the order they were queued, with their latest content
+    QStringList _queue;
+    QHash<QString, QByteArray> _pending;
+    QString _writing;
+    QByteArray _writingContent;
+    bool _isQuitting = false;
+};
+
+#endif // ANNOTATIONWRITER_H
@@ -0,0 +1,53 @@
+#include "boxitempool.h"
+#include <QGraphicsScene>
+#include <QSettings>
+
+BoxItemPool::BoxItemPool()
+{
+    QSettings settings;
+    _capacity = qMax(0, settings.value("boxes/poolSize", 4096).toInt());
+}
+
+BoxItemPool *BoxItemPool::instance()
+{
+    static BoxItemPool pool;
+    return &pool;
+}
+
+BoxItem *BoxItemPool::acquire(QRectF sceneRect, QSize imageSize, QStringList &typeNameList, QString typeName)
+{
+    _live++;
+    if (_free.isEmpty()) {
+        _allocated++;
+        return new BoxItem(sceneRect, imageSize, typeNameList, typeName);
+    }
+
+    BoxItem *box = _free.takeLast();
+    box->reset(sceneRect, imageSize, typeNameList, typeName);
+    return box;
+}
+
+void BoxItemPool::release(BoxItem *box)
+{
+    if (box == nullptr)
+        return;
+
+    _live--;
+    if (box->scene() != nullptr)
+        box->scene()->removeItem(box);
+    // the next owner registers its own connections and event filter
+    box->disconnect();
+    box->setSelected(false);
+
+    if (_free.count() >= _capacity) {
+        delete box;
+        return;
+    }
+    _free.append(box);
+}
+
+void BoxItemPool::clear()
+{
+    qDeleteAll(_free);
+    _free.clear();
+}
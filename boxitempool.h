@@ -0,0 +1,46 @@
+#ifndef BOXITEMPOOL_H
+#define BOXITEMPOOL_H
+
+#include <QVector>
+#include "boxitem.h"
+
+/**
+ * @brief The BoxItemPool class recycles box items across image switches.
+ *
+ * Released boxes are taken out of their scene, disconnected and kept with
+ * their text items and context menu, acquire() hands them out again before
+ * constructing new ones. The pool is only used from the GUI thread and must
+ * be cleared while the application object still exists.
+ */
+class BoxItemPool
+{
+public:
+    static BoxItemPool *instance();
+
+    BoxItem *acquire(QRectF sceneRect, QSize imageSize, QStringList &typeNameList, QString typeName);
+    void release(BoxItem *box);
+    void clear();
+
+    int live() const
+    {
+        return _live;
+    }
+    int pooled() const
+    {
+        return _free.count();
+    }
+    qint64 allocated() const
+    {
+        return _allocated;
+    }
+
+private:
+    BoxItemPool();
+
+    QVector<BoxItem *> _free;
+    int _capacity;
+    int _live = 0;
+    qint64 _allocated = 0;
+};
+
+#endif // BOXITEMPOOL_H
@@ -1,179 +1,275 @@
-#include "commands.h"
-
-/******************************************************************************
-** AddBoxCommand
-*/
-
-AddBoxCommand::AddBoxCommand(QGraphicsScene *scene, QList<BoxItem *> *boxList, QUndoCommand *parent)
-    : QUndoCommand(parent)
-{
-    _scene = scene;
-    _boxList  = boxList;
-//    _boxList = new QList<BoxItem *>();
-//    for (int i=0; i<boxList.count(); i++) {
-//        BoxItem *box = qgraphicsitem_cast<BoxItem *>(boxList.at(i));
-//        _boxList->append(box);
-//    }
-}
-
-AddBoxCommand::AddBoxCommand(QGraphicsScene *scene, BoxItem *box, QUndoCommand *parent)
-    : QUndoCommand(parent)
-{
-    _scene = scene;
-    _box = box;
-//    _boxList = new QList<BoxItem *>();
-//    for (int i=0; i<boxList.count(); i++) {
-//        BoxItem *box = qgraphicsitem_cast<BoxItem *>(boxList.at(i));
-//        _boxList->append(box);
-//    }
-}
-
-void AddBoxCommand::undo()
-{
-    if (_box) {
-        _scene->removeItem(_box);
-        QApplication::setOverrideCursor(_box->oldCursor());
-    }
-    if (_boxList) {
-        for (int i=0; i<_boxList->count(); i++) {
-            BoxItem *item = _boxList->at(i);
-            _scene->removeItem(item);
-            QApplication::setOverrideCursor(item->oldCursor());
-        }
-    }
-}
-
-void AddBoxCommand::redo()
-{ 
-    //    QCursor c = Qt::CrossCursor;
-    //    _box->setOldCursor(c);
-    if (_boxList) {
-        for (int i=0; i<_boxList->count(); i++) {
-            BoxItem *item = _boxList->at(i);
-            if (!item->rect().isNull())
-                _scene->addItem(item);
-        }
-        reinterpret_cast<CustomScene *>(_scene)->selectBoxItems(_boxList, true);
-        //    for (int i=0; i<_boxList->count(); i++) {
-        //        BoxItem *item = _boxList->at(i);
-        //        if (!item->rect().isNull())
-        //            _scene->addItem(item);
-        //    }
-//        reinterpret_cast<CustomScene *>(_scene)->selectBoxItems(_boxList, true);
-    }
-
-    if (_box) {
-        if (!_box->rect().isNull()) {
-            _scene->addItem(_box);
-            _box->setSelected(true);
-        }
-    }
-}
-
-/******************************************************************************
-** RemoveBoxItemCommand
-*/
-
-RemoveBoxesCommand::RemoveBoxesCommand(QGraphicsScene *scene, QList<QGraphicsItem *> boxList,
-                                        QUndoCommand *parent)
-    : QUndoCommand(parent)
-{
-    _scene = scene;
-    _boxList = new QList<BoxItem *>();
-    for (int i=0; i<boxList.count(); i++) {
-        BoxItem *box = qgraphicsitem_cast<BoxItem *>(boxList.at(i));
-        _boxList->append(box);
-    }
-}
-
-void RemoveBoxesCommand::undo()
-{
-    for (int i=0; i<_boxList->count(); i++) {
-        BoxItem *item = _boxList->at(i);
-        if (!item->rect().isNull())
-            _scene->addItem(item);
-    }
-    reinterpret_cast<CustomScene *>(_scene)->selectBoxItems(_boxList, true);
-}
-
-void RemoveBoxesCommand::redo()
-{
-    for (int i=0; i<_boxList->count(); i++) {
-        BoxItem *item = _boxList->at(i);
-        _scene->removeItem(item);
-        QApplication::setOverrideCursor(item->oldCursor());
-    }
-}
-
-/******************************************************************************
-** SetTargetTypeCommand
-*/
-
-//SetTargetTypeCommand::SetTargetTypeCommand(QGraphicsScene *scene, BoxItem *box, const QString &typeName,
-//                                             QUndoCommand *parent)
-SetTargetTypeCommand::SetTargetTypeCommand(QGraphicsScene *scene, QList<BoxItem *> *boxList, const QString &typeName,
-                                             QUndoCommand *parent)
-    : QUndoCommand(parent)
-{
-    _scene = scene;
-//    _box = box;
-    _boxList = new QList<BoxItem *>();
-    for (int i=0; i<boxList->count(); i++) {
-        BoxItem *box = boxList->at(i);
-        _boxList->append(box);
-    }
-    _oldNameList = new QStringList();
-    for (int i=0; i<boxList->count(); i++) {
-        _oldNameList->append(boxList->at(i)->typeName());
-    }
-//    _oldName = _box->typeName();
-    _newName = typeName;
-}
-
-void SetTargetTypeCommand::undo()
-{
-//    reinterpret_cast<ViewScene *>(_scene)->selectBoxItems(_box, true);
-//    _box->setTypeName(_oldName);
-    for (int i=0; i<_boxList->count(); i++) {
-        BoxItem *item = _boxList->at(i);
-        item->setTypeName(_oldNameList->at(i));
-    }
-    reinterpret_cast<CustomScene *>(_scene)->selectBoxItems(_boxList, true);
-}
-
-void SetTargetTypeCommand::redo()
-{
-//    reinterpret_cast<ViewScene *>(_scene)->selectBoxItems(_box, true);
-//    _box->setTypeName(_newName);
-    for (int i=0; i<_boxList->count(); i++) {
-        BoxItem *item = _boxList->at(i);
-        item->setTypeName(_newName);
-    }
-    reinterpret_cast<CustomScene *>(_scene)->selectBoxItems(_boxList, true);
-}
-
-/******************************************************************************
-** MoveBoxCommand
-*/
-
-MoveBoxCommand::MoveBoxCommand(QGraphicsScene *scene, BoxItem *box, const QRectF &newRect, const QRectF &oldRect,
-                                             QUndoCommand *parent)
-    : QUndoCommand(parent)
-{
-    _scene = scene;
-    _box = box;
-    _oldRect = oldRect;
-    _newRect = newRect;
-}
-
-void MoveBoxCommand::undo()
-{
-    reinterpret_cast<CustomScene *>(_scene)->selectBoxItems(_box, true);
-    _box->setRect(_oldRect);
-}
-
-void MoveBoxCommand::redo()
-{
-    reinterpret_cast<CustomScene *>(_scene)->selectBoxItems(_box, true);
-    _box->setRect(_newRect);
-}
+#include "commands.h"
+#include "customscene.h"
+#include "editjournal.h"
+
+static qint64 recordsSize(const QVector<BoxRecord> &records)
+{
+    qint64 bytes = records.count() * sizeof(BoxRecord);
+    foreach (const BoxRecord &record, records) {
+        bytes += record.typeName.size() * sizeof(QChar);
+    }
+    return bytes;
+}
+
+static QVector<JournalBox> journalBoxes(const CustomScene *scene, const QVector<BoxRecord> &records)
+{
+    QVector<JournalBox> boxes;
+    boxes.reserve(records.count());
+    foreach (const BoxRecord &record, records) {
+        JournalBox box;
+        box.id = record.id;
+        box.classIndex = scene->classIndex(record.typeName);
+        box.rect = record.rect;
+        boxes.append(box);
+    }
+    return boxes;
+}
+
+static QVector<int> recordIds(const QVector<BoxRecord> &records)
+{
+    QVector<int> ids;
+    ids.reserve(records.count());
+    foreach (const BoxRecord &record, records) {
+        ids.append(record.id);
+    }
+    return ids;
+}
+
+BoxRecord BoxRecord::fromItem(const BoxItem *box)
+{
+    BoxRecord record;
+    record.id = box->id();
+    record.rect = box->rect();
+    record.typeName = box->typeName();
+    record.cursor = box->oldCursor().shape();
+    return record;
+}
+
+/******************************************************************************
+*/
+
+void BoxCommand::undo()
+{
+    if (_scene->isReplaying())
+        return;
+    // the baseline of the label file is journaled before its first change
+    int file = _scene->journalFile();
+    unapply();
+    journal(file, true);
+}
+
+void BoxCommand::redo()
+{
+    if (_scene->isReplaying())
+        return;
+    int file = _scene->journalFile();
+    apply();
+    journal(file, false);
+}
+
+QList<BoxItem *> BoxCommand::boxItems(const QVector<BoxRecord> &records) const
+{
+    QList<BoxItem *> boxList;
+    foreach (const BoxRecord &record, records) {
+        BoxItem *box = _scene->boxItem(record.id);
+        if (box != nullptr)
+            boxList.append(box);
+    }
+    return boxList;
+}
+
+/******************************************************************************
+*/
+
+AddBoxCommand::AddBoxCommand(CustomScene *scene, const QVector<BoxRecord> &boxes, QUndoCommand *parent)
+    : BoxCommand(scene, parent),
+      _boxes(boxes)
+{
+}
+
+BoxCommand *AddBoxCommand::clone(CustomScene *scene) const
+{
+    return new AddBoxCommand(scene, _boxes);
+}
+
+qint64 AddBoxCommand::sizeInBytes() const
+{
+    return sizeof(*this) + recordsSize(_boxes);
+}
+
+void AddBoxCommand::unapply()
+{
+    foreach (const BoxRecord &record, _boxes) {
+        _scene->removeBoxItem(record.id);
+        QApplication::setOverrideCursor(QCursor(record.cursor));
+    }
+}
+
+void AddBoxCommand::apply()
+{
+    foreach (const BoxRecord &record, _boxes) {
+        _scene->createBoxItem(record);
+    }
+    QList<BoxItem *> boxList = boxItems(_boxes);
+    _scene->selectBoxItems(&boxList, true);
+}
+
+void AddBoxCommand::journal(int file, bool isUndo) const
+{
+    if (isUndo)
+        EditJournal::instance()->removeBoxes(file, recordIds(_boxes));
+    else
+        EditJournal::instance()->addBoxes(file, journalBoxes(_scene, _boxes));
+}
+
+/******************************************************************************
+*/
+
+RemoveBoxesCommand::RemoveBoxesCommand(CustomScene *scene, const QVector<BoxRecord> &boxes,
+                                       QUndoCommand *parent)
+    : BoxCommand(scene, parent),
+      _boxes(boxes)
+{
+}
+
+BoxCommand *RemoveBoxesCommand::clone(CustomScene *scene) const
+{
+    return new RemoveBoxesCommand(scene, _boxes);
+}
+
+qint64 RemoveBoxesCommand::sizeInBytes() const
+{
+    return sizeof(*this) + recordsSize(_boxes);
+}
+
+void RemoveBoxesCommand::unapply()
+{
+    foreach (const BoxRecord &record, _boxes) {
+        _scene->createBoxItem(record);
+    }
+    QList<BoxItem *> boxList = boxItems(_boxes);
+    _scene->selectBoxItems(&boxList, true);
+}
+
+void RemoveBoxesCommand::apply()
+{
+    foreach (const BoxRecord &record, _boxes) {
+        _scene->removeBoxItem(record.id);
+        QApplication::setOverrideCursor(QCursor(record.cursor));
+    }
+}
+
+void RemoveBoxesCommand::journal(int file, bool isUndo) const
+{
+    if (isUndo)
+        EditJournal::instance()->addBoxes(file, journalBoxes(_scene, _boxes));
+    else
+        EditJournal::instance()->removeBoxes(file, recordIds(_boxes));
+}
+
+/******************************************************************************
+*/
+
+SetTargetTypeCommand::SetTargetTypeCommand(CustomScene *scene, const QVector<int> &ids, const QStringList &oldNames,
+                                           const QString &typeName, QUndoCommand *parent)
+    : BoxCommand(scene, parent),
+      _ids(ids),
+      _oldNames(oldNames),
+      _newName(typeName)
+{
+}
+
+BoxCommand *SetTargetTypeCommand::clone(CustomScene *scene) const
+{
+    return new SetTargetTypeCommand(scene, _ids, _oldNames, _newName);
+}
+
+qint64 SetTargetTypeCommand::sizeInBytes() const
+{
+    qint64 bytes = sizeof(*this) + _ids.count() * sizeof(int) + _newName.size() * sizeof(QChar);
+    foreach (const QString &name, _oldNames) {
+        bytes += sizeof(QString) + name.size() * sizeof(QChar);
+    }
+    return bytes;
+}
+
+void SetTargetTypeCommand::unapply()
+{
+    QList<BoxItem *> boxList;
+    for (int i=0; i<_ids.count(); i++) {
+        BoxItem *item = _scene->boxItem(_ids.at(i));
+        if (item != nullptr) {
+            item->setTypeName(_oldNames.at(i));
+            boxList.append(item);
+        }
+    }
+    _scene->selectBoxItems(&boxList, true);
+}
+
+void SetTargetTypeCommand::apply()
+{
+    QList<BoxItem *> boxList;
+    for (int i=0; i<_ids.count(); i++) {
+        BoxItem *item = _scene->boxItem(_ids.at(i));
+        if (item != nullptr) {
+            item->setTypeName(_newName);
+            boxList.append(item);
+        }
+    }
+    _scene->selectBoxItems(&boxList, true);
+}
+
+void SetTargetTypeCommand::journal(int file, bool isUndo) const
+{
+    QVector<int> classIndexes;
+    classIndexes.reserve(_ids.count());
+    for (int i=0; i<_ids.count(); i++) {
+        classIndexes.append(_scene->classIndex(isUndo ? _oldNames.at(i) : _newName));
+    }
+    EditJournal::instance()->setClasses(file, _ids, classIndexes);
+}
+
+/******************************************************************************
+*/
+
+MoveBoxCommand::MoveBoxCommand(CustomScene *scene, int id, const QRectF &newRect, const QRectF &oldRect,
+                               QUndoCommand *parent)
+    : BoxCommand(scene, parent),
+      _id(id),
+      _oldRect(oldRect),
+      _newRect(newRect)
+{
+}
+
+BoxCommand *MoveBoxCommand::clone(CustomScene *scene) const
+{
+    return new MoveBoxCommand(scene, _id, _newRect, _oldRect);
+}
+
+qint64 MoveBoxCommand::sizeInBytes() const
+{
+    return sizeof(*this);
+}
+
+void MoveBoxCommand::unapply()
+{
+    BoxItem *box = _scene->boxItem(_id);
+    if (box == nullptr)
+        return;
+    _scene->selectBoxItems(box, true);
+    box->setRect(_oldRect);
+}
+
+void MoveBoxCommand::apply()
+{
+    BoxItem *box = _scene->boxItem(_id);
+    if (box == nullptr)
+        return;
+    _scene->selectBoxItems(box, true);
+    box->setRect(_newRect);
+}
+
+void MoveBoxCommand::journal(int file, bool isUndo) const
+{
+    EditJournal::instance()->moveBox(file, _id, isUndo ? _oldRect : _newRect);
+}
@@ -1,87 +1,128 @@
-#ifndef COMMANDS_H
-#define COMMANDS_H
-
-//#include <QGraphicsScene>
-#include <boxitem.h>
-#include <QUndoCommand>
-#include <customscene.h>
-
-class AddBoxCommand : public QUndoCommand
-{
-public:
-    AddBoxCommand(QGraphicsScene *scene, QList<BoxItem *> *boxList, QUndoCommand *parent = 0);
-    AddBoxCommand(QGraphicsScene *scene, BoxItem *box, QUndoCommand *parent = 0);
-    ~AddBoxCommand()
-    {
-        if (_boxList) {
-            delete _boxList;
-        }
-    }
-    void undo() override;
-    void redo() override;
-
-private:
-    QGraphicsScene *_scene;
-    QList<BoxItem *> *_boxList = nullptr;
-    BoxItem *_box = nullptr;
-};
-
-class RemoveBoxesCommand : public QUndoCommand
-{
-public:
-    RemoveBoxesCommand(QGraphicsScene *scene, QList<QGraphicsItem *> boxList, QUndoCommand *parent = 0);
-    ~RemoveBoxesCommand()
-    {
-        if (_boxList) {
-            delete _boxList;
-        }
-    }
-    void undo() override;
-    void redo() override;
-
-private:
-    QGraphicsScene *_scene;
-    QList<BoxItem *> *_boxList = nullptr;
-};
-
-class SetTargetTypeCommand : public QUndoCommand
-{
-public:
-    SetTargetTypeCommand(QGraphicsScene *scene, QList<BoxItem *> *boxList, const QString &typeName,
-                            QUndoCommand *parent = 0);
-
-    ~SetTargetTypeCommand()
-    {
-        if (_boxList) {
-            delete _boxList;
-        }
-        if (_oldNameList) {
-            delete _oldNameList;
-        }
-    }
-    void undo() override;
-    void redo() override;
-
-private:
-    QGraphicsScene *_scene;
-    QString _oldName, _newName;
-    QList<BoxItem *> *_boxList = nullptr;
-    QStringList *_oldNameList = nullptr;
-};
-
-class MoveBoxCommand : public QUndoCommand
-{
-public:
-    MoveBoxCommand(QGraphicsScene *scene, BoxItem *box, const QRectF &newRect, const QRectF &oldRect,
-                                             QUndoCommand *parent=0);
-
-    void undo() override;
-    void redo() override;
-private:
-    QGraphicsScene *_scene;
-    BoxItem *_box;
-    QRectF _oldRect;
-    QRectF _newRect;
-};
-
-#endif // COMMANDS_H
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+//#include <QGraphicsScene>
+#include <boxitem.h>
+#include <QUndoCommand>
+#include <QVector>
+
+class CustomScene;
+
+// the value of a box as the undo commands store it, boxes are referred to by id
+struct BoxRecord
+{
+    int id = 0;
+    QRectF rect;
+    QString typeName;
+    Qt::CursorShape cursor = Qt::ArrowCursor;
+
+    static BoxRecord fromItem(const BoxItem *box);
+};
+
+/**
+ * @brief The BoxCommand class is the base of the box editing commands.
+ *
+ * Commands keep box ids and values only, so they outlive the box items and
+ * can be kept in the undo history of an image that is no longer shown.
+ * While the scene replays a restored history undo() and redo() do nothing,
+ * the label file already reflects them. Otherwise the change they make is
+ * appended to the edit journal.
+ */
+class BoxCommand : public QUndoCommand
+{
+public:
+    BoxCommand(CustomScene *scene, QUndoCommand *parent = 0):
+        QUndoCommand(parent),
+        _scene(scene)
+    {
+    }
+
+    void undo() override;
+    void redo() override;
+    virtual BoxCommand *clone(CustomScene *scene) const = 0;
+    virtual qint64 sizeInBytes() const = 0;
+
+protected:
+    virtual void unapply() = 0;
+    virtual void apply() = 0;
+    virtual void journal(int file, bool isUndo) const = 0;
+    QList<BoxItem *> boxItems(const QVector<BoxRecord> &records) const;
+
+    CustomScene *_scene;
+};
+
+class AddBoxCommand : public BoxCommand
+{
+public:
+    AddBoxCommand(CustomScene *scene, const QVector<BoxRecord> &boxes, QUndoCommand *parent = 0);
+
+    BoxCommand *clone(CustomScene *scene) const override;
+    qint64 sizeInBytes() const override;
+
+protected:
+    void unapply() override;
+    void apply() override;
+    void journal(int file, bool isUndo) const override;
+
+private:
+    QVector<BoxRecord> _boxes;
+};
+
+class RemoveBoxesCommand : public BoxCommand
+{
+public:
+    RemoveBoxesCommand(CustomScene *scene, const QVector<BoxRecord> &boxes, QUndoCommand *parent = 0);
+
+    BoxCommand *clone(CustomScene *scene) const override;
+    qint64 sizeInBytes() const override;
+
+protected:
+    void unapply() override;
+    void apply() override;
+    void journal(int file, bool isUndo) const override;
+
+private:
+    QVector<BoxRecord> _boxes;
+};
+
+class SetTargetTypeCommand : public BoxCommand
+{
+public:
+    SetTargetTypeCommand(CustomScene *scene, const QVector<int> &ids, const QStringList &oldNames,
+                         const QString &typeName, QUndoCommand *parent = 0);
+
+    BoxCommand *clone(CustomScene *scene) const override;
+    qint64 sizeInBytes() const override;
+
+protected:
+    void unapply() override;
+    void apply() override;
+    void journal(int file, bool isUndo) const override;
+
+private:
+    QVector<int> _ids;
+    QStringList _oldNames;
+    QString _newName;
+};
+
+class MoveBoxCommand : public BoxCommand
+{
+public:
+    MoveBoxCommand(CustomScene *scene, int id, const QRectF &newRect, const QRectF &oldRect,
+                   QUndoCommand *parent = 0);
+
+    BoxCommand *clone(CustomScene *scene) const override;
+    qint64 sizeInBytes() const override;
+
+protected:
+    void unapply() override;
+    void apply() override;
+    void journal(int file, bool isUndo) const override;
+
+private:
+    int _id;
+    QRectF _oldRect;
+    QRectF _newRect;
+};
+
+#endif // COMMANDS_H
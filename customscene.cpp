@@ -1,516 +1,896 @@
-#include "customscene.h"
-#include <QtDebug>
-#include <QScrollBar>
-
-CustomScene::CustomScene(QObject* parent):
-    QGraphicsScene(parent),
-    _image(nullptr),
-    _pixmapItem(nullptr),
-    _boxItem(nullptr),
-    _isDrawing(false),
-    _undoStack(new QUndoStack),
-    _clickedPos(QPointF(0,0))
-{
-}
-
-void CustomScene::clearAll()
-{
-    saveBoxItemsToFile();
-
-    if (_image != nullptr) {
-        delete _image;
-        _image = nullptr;
-    }
-    if (_pixmapItem != nullptr) {
-        delete _pixmapItem;
-        _pixmapItem = nullptr;
-    }
-    if (_boxItemMimeData) {
-        delete _boxItemMimeData;
-    }
-
-    foreach (QGraphicsItem *item, this->items()) {
-        if ((item->type() == QGraphicsItem::UserType+1) ||
-                (item->type() == QGraphicsPixmapItem::Type) ) {
-            this->removeItem(item);
-            delete item;
-        }
-    }
-
-    if (_undoStack != nullptr) {
-        _undoStack->clear();
-        delete _undoStack;
-        _undoStack = nullptr;
-    }
-
-    this->items().clear();
-    this->clear();
-}
-
-void CustomScene::loadImage(QString filename)
-{
-    // Get image format
-    FREE_IMAGE_FORMAT fif = FreeImage_GetFileType(filename.toLocal8Bit(), 0);
-    if(fif == FIF_UNKNOWN)
-        fif = FreeImage_GetFIFFromFilename(filename.toLocal8Bit());
-    if(fif == FIF_UNKNOWN)
-        return;
-
-    // Load image if possible
-    FIBITMAP *dib = nullptr;
-    if(FreeImage_FIFSupportsReading(fif)) {
-        dib = FreeImage_Load(fif, filename.toLocal8Bit());
-        if(dib == nullptr)
-            return;
-    } else
-        return;
-
-    // Convert to 24bits and save to memory as JPEG
-    FIMEMORY *stream = FreeImage_OpenMemory();
-    // FreeImage can only save 24-bit highcolor or 8-bit greyscale/palette bitmaps as JPEG
-    FIBITMAP *dib1 = FreeImage_ConvertTo24Bits(dib);
-    FreeImage_SaveToMemory(FIF_JPEG, dib1, stream);
-
-    // Load JPEG data
-    BYTE *mem_buffer = nullptr;
-    DWORD size_in_bytes = 0;
-    FreeImage_AcquireMemory(stream, &mem_buffer, &size_in_bytes);
-
-    // Load raw data into QImage and return
-    QByteArray array = QByteArray::fromRawData((char*)mem_buffer, (int)size_in_bytes);
-
-    _image = new QImage();
-    _image->loadFromData(array);
-    //_image = new QImage(filename);
-    _pixmapItem = new QGraphicsPixmapItem(QPixmap::fromImage(*_image));
-    _pixmapItem->setTransformationMode(Qt::SmoothTransformation);
-    this->addItem(_pixmapItem);
-
-    emit imageLoaded(_image->size());
-    setSceneRect(_image->rect());
-
-    // load box items
-    QFileInfo info(filename);
-    _boxItemFileName = info.path() + "/" + info.completeBaseName() + ".txt";
-    loadBoxItemsFromFile();
-
-    array.clear();
-    FreeImage_CloseMemory(stream);
-    FreeImage_Unload(dib);
-    FreeImage_Unload(dib1);
-}
-
-void CustomScene::loadBoxItemsFromFile()
-{
-    QFile file(_boxItemFileName);
-    file.open(QIODevice::ReadOnly | QIODevice::Text);
-
-    QPoint zero(0, 0);
-    QRect fatherRect(zero, _image->size());
-    qreal x,y,w,h;
-    int index;
-
-    QTextStream in(&file);
-    while (!in.atEnd()) {
-        QStringList info = in.readLine().split(" ");
-        if(info.size() >= 5) {
-            index = info.at(0).toInt();
-            w = info.at(3).toFloat() * _image->width();
-            h = info.at(4).toFloat() * _image->height();
-            x = info.at(1).toFloat() * _image->width() - w/2;
-            y = info.at(2).toFloat() * _image->height() - h/2;
-
-            BoxItem *b = new BoxItem(fatherRect, _image->size(), _typeNameList, _typeNameList.at(index));
-            b->setRect(x,y,w,h);
-            this->registerItem(b);
-            if (!b->rect().isNull())
-                this->addItem(b);
-        }
-    }
-    file.close();
-}
-
-void CustomScene::registerItem(BoxItem *b)
-{
-    connect(b, SIGNAL(typeNameChanged(QString)), this, SLOT(changeBoxTypeName(QString)));
-    connect(b, SIGNAL(boxSelected(QRect, QString)), this, SIGNAL(boxSelected(QRect, QString)));
-    connect(b, SIGNAL(boxSelected(QRect, QString)), this, SLOT(selectedBoxItemInfo(QRect,QString)));
-    connect(b, SIGNAL(stretchCompleted(QRectF, QRectF)), this, SLOT(moveBox(QRectF, QRectF)));
-    connect(b, SIGNAL(moveCompleted(QRectF, QRectF)), this, SLOT(moveBox(QRectF, QRectF)));
-    b->installEventFilter(this);
-}
-
-void CustomScene::saveBoxItemsToFile()
-{
-    QFile file(_boxItemFileName);
-    file.open(QIODevice::WriteOnly | QIODevice::Text);
-    qreal label[4];
-    QTextStream out(&file);
-
-    foreach (QGraphicsItem *item, this->items()) {
-        if (item->type() == QGraphicsItem::UserType+1) {
-            BoxItem *b = qgraphicsitem_cast<BoxItem *>(item);
-            b->rect(label);
-            QString s;
-            s.sprintf("%d %f %f %f %f\n",
-                      _typeNameList.indexOf(b->typeName()),
-                      label[0],label[1],label[2],label[3]);
-            out << s;
-        }
-    }
-    file.close();
-}
-
-void CustomScene::deleteBoxItems()
-{
-    QList<QGraphicsItem *> boxList;
-    foreach (QGraphicsItem *item, this->selectedItems()) {
-        if (item->type() == QGraphicsItem::UserType+1) {
-            boxList.append(item);
-        }
-    }
-
-    if (boxList.count() > 0) {
-        _undoStack->push(new RemoveBoxesCommand(this, boxList));
-        QApplication::setOverrideCursor(qgraphicsitem_cast<BoxItem *>(boxList.at(0))->oldCursor());
-    }
-    boxList.clear();
-}
-
-void CustomScene::selectBoxItems(bool op)
-{
-    // selecting box items
-    foreach (QGraphicsItem *item, this->items()) {
-        if (item->type() == QGraphicsItem::UserType+1) {
-            item->setSelected(op);
-        }
-    }
-}
-
-void CustomScene::selectBoxItems(BoxItem *box, bool op)
-{
-    foreach (QGraphicsItem *item, this->items()) {
-        if (item->type() == QGraphicsItem::UserType+1) {
-            item->setSelected(item==qgraphicsitem_cast<QGraphicsItem *>(box));
-        }
-    }
-}
-
-void CustomScene::selectBoxItems(QList<BoxItem *> *boxList, bool op)
-{
-    foreach (QGraphicsItem *item, this->items()) {
-        if (item->type() == QGraphicsItem::UserType+1) {
-            item->setSelected(boxList->contains(qgraphicsitem_cast<BoxItem *>(item)));
-        }
-    }
-}
-
-void CustomScene::drawBoxItem(bool op)
-{
-    _isDrawing = op;
-    _isPanning = false;
-}
-
-void CustomScene::panImage(bool op)
-{
-    _isDrawing = false;
-    _isPanning = op;
-    selectBoxItems(false);
-}
-
-void CustomScene::mousePressEvent(QGraphicsSceneMouseEvent *event)
-{
-    switch (event->buttons()) {
-    case Qt::LeftButton:
-        _leftTopPoint = event->scenePos();
-        if (_isDrawing && event->modifiers() != Qt::ControlModifier) { // drawing box item
-
-            // no box selected
-            int count = 0;
-            foreach (QGraphicsItem *item, this->selectedItems()) {
-                if (item->type() == QGraphicsItem::UserType + 1) {
-                    if (item->isSelected()) {
-                        count++;
-                    }
-                }
-            }
-            if (count <= 0) {
-                QGraphicsScene::mousePressEvent(event);
-                return;
-            }
-
-            // selected box do not contain pressed pos
-            count = 0;
-            foreach (QGraphicsItem *item, this->items()) {
-                if (item->type() == QGraphicsItem::UserType + 1) {
-                    if (item->isSelected() && !item->contains(_leftTopPoint)) {
-                        item->setSelected(false);
-                        count++;
-                    }
-                }
-            }
-            if (count >0) {
-                QGraphicsScene::mousePressEvent(event);
-                return;
-            }
-
-            // selected box contain pressed pos
-            foreach (QGraphicsItem *item, this->items()) {
-                if ((item->type() == QGraphicsItem::UserType + 1 && item->contains(_leftTopPoint))) {
-                    _isMoving = true;
-                    QGraphicsScene::mousePressEvent(event);
-                    return;
-                }
-            }
-        } else if (event->modifiers() == Qt::ControlModifier) { // selecting multiple box items
-            foreach (QGraphicsItem *item, this->items()) {
-                if ((item->type() == QGraphicsItem::UserType + 1 && item->contains(_leftTopPoint))) {
-                    item->setSelected(true);
-                    break;
-                }
-            }
-            QGraphicsScene::mousePressEvent(event);
-        } else {// selecting single box item
-            foreach (QGraphicsItem *item, this->items()) {
-                if ((item->type() == QGraphicsItem::UserType + 1 && item->contains(_leftTopPoint))) {
-                    selectBoxItems(qgraphicsitem_cast<BoxItem *>(item), true);
-                    _isMoving = true;
-                    QGraphicsScene::mousePressEvent(event);
-                    break;
-                }
-            }
-        }
-        break;
-    case Qt::RightButton:
-        QGraphicsScene::mousePressEvent(event);
-        break;
-    default:
-        break;
-    }
-    QGraphicsScene::mousePressEvent(event);
-}
-
-void CustomScene::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
-{
-    if (event->buttons() & Qt::LeftButton) {
-        _isMouseMoved = true;
-
-        // add new box item
-        if(_isDrawing && (this->selectedItems().count() <= 0 || _boxItem) && !_isMoving && !_isPanning) {
-            if(!_boxItem) {
-                _boxItem = new BoxItem(this->sceneRect(), _image->size(), _typeNameList, _typeName);
-                this->registerItem(_boxItem);
-                this->addItem(_boxItem);
-            }
-            _boxItem->setSelected(true);
-            _rightBottomPoint = event->scenePos();
-            QRect roi(qMin(_rightBottomPoint.x(), _leftTopPoint.x()),
-                      qMin(_rightBottomPoint.y(), _leftTopPoint.y()),
-                      qAbs(_rightBottomPoint.x() - _leftTopPoint.x()),
-                      qAbs(_rightBottomPoint.y() - _leftTopPoint.y()));
-            int l = sceneRect().left(), r = sceneRect().right(),
-                    t = sceneRect().top(), b = sceneRect().bottom();
-            if (roi.right() < l || roi.left() > r ||
-                    roi.top() > b || roi.bottom() < t )
-                return;
-
-            roi.setTop(qMax(t, roi.top()));
-            roi.setLeft(qMax(l, roi.left()));
-            roi.setBottom(qMin(b, roi.bottom()));
-            roi.setRight(qMin(r, roi.right()));
-
-            _boxItem->setRect(roi);
-        }
-
-        if (_isMoving) {
-            QGraphicsScene::mouseMoveEvent(event);
-        }
-    }
-    emit cursorMoved(event->scenePos());
-
-    if(!(_isDrawing && this->selectedItems().count()<=0))
-        QGraphicsScene::mouseMoveEvent(event);
-}
-
-void CustomScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
-{
-    if (_isMouseMoved) {
-        if (_isDrawing) {
-            if (_boxItem) {
-                this->removeItem(_boxItem);
-                if ( _boxItem->rect().width() > 5 && (_boxItem->rect().height() > 5 ) ) {
-                    QCursor c = Qt::CrossCursor;
-                    _boxItem->setOldCursor(c);
-                    _undoStack->push(new AddBoxCommand(this, _boxItem));
-                }
-                _boxItem = nullptr;
-                return;
-            }
-        }
-        if (_isMoving) {
-            _isMoving = false;
-            QGraphicsScene::mouseReleaseEvent(event);
-        }
-
-        _isMouseMoved = false;
-        return;
-    } else {
-        if (_boxItemMimeData)
-            _clickedPos = event->scenePos();
-    }
-
-    QGraphicsScene::mouseReleaseEvent(event);
-}
-
-void CustomScene::keyPressEvent(QKeyEvent *keyEvent)
-{
-    if(keyEvent->key() == Qt::Key_Delete) {
-        deleteBoxItems();
-    } else if(keyEvent->key() == Qt::Key_A && keyEvent->modifiers() == Qt::ControlModifier) {
-        selectBoxItems(true);
-    }else {
-        QGraphicsScene::keyPressEvent(keyEvent);
-    }
-}
-
-void CustomScene::keyReleaseEvent(QKeyEvent *keyEvent)
-{
-    QGraphicsScene::keyReleaseEvent(keyEvent);
-}
-
-void CustomScene::changeBoxTypeName(QString name)
-{
-    _typeName = name;
-    QList<BoxItem *> *boxList = new QList<BoxItem *>();
-    foreach (QGraphicsItem *item, this->selectedItems()) {
-        if (item->type() == QGraphicsItem::UserType+1) {
-            BoxItem *b = qgraphicsitem_cast<BoxItem *>(item);
-            boxList->append(b);
-        }
-    }
-
-    if (boxList->count() > 0) {
-        _undoStack->push(new SetTargetTypeCommand(this, boxList, name));
-    }
-    delete boxList;
-}
-
-void CustomScene::moveBox(QRectF newRect, QRectF oldRect)
-{
-    BoxItem *item = reinterpret_cast<BoxItem *>(QObject::sender());
-    if (item != nullptr) {
-        _undoStack->push(new MoveBoxCommand(this, item, newRect, oldRect));
-    }
-}
-
-
-void CustomScene::copy()
-{
-    if (selectedItems().count() <=0 )
-        return;
-
-    if (_boxItemMimeData) {
-        delete _boxItemMimeData;
-    }
-    _boxItemMimeData = new BoxItemMimeData(selectedItems());
-    QApplication::clipboard()->setMimeData(_boxItemMimeData);
-
-    _pastePos.clear();
-    for (int i=0; i<selectedItems().count(); i++)
-        _pastePos.append(QPointF(0,0));
-    _clickedPos = QPointF(0,0);
-}
-
-void CustomScene::paste()
-{
-    QMimeData *m = const_cast<QMimeData *>(QApplication::clipboard()->mimeData()) ;
-    BoxItemMimeData *data = dynamic_cast<BoxItemMimeData*>(m);
-    if (data){
-        clearSelection();
-
-        QList<QPointF> offset;
-        QList<QRectF> itemRects;
-        QRectF unitedRect(0,0,0,0);
-
-        for (int i=0; i<data->items().count(); i++) {
-            BoxItem *b = qgraphicsitem_cast<BoxItem*>(data->items().at(i));
-            itemRects.append(b->rect());
-            unitedRect = unitedRect.united(b->rect());
-        }
-        if (!unitedRect.isNull()) {
-            for (int i=0; i<itemRects.count(); i++) {
-                offset.append(itemRects[i].topLeft() - unitedRect.topLeft());
-            }
-        }
-
-        for (int i=0; i<_pastePos.count(); i++) {
-            if (_pastePos[i].isNull()) {
-                _pastePos[i] = QPointF(itemRects[i].x(), itemRects[i].y());
-            }
-        }
-        if (!_clickedPos.isNull()) {
-            unitedRect.moveCenter(_clickedPos);
-            for (int i=0; i<_pastePos.count(); i++) {
-                _pastePos[i] = unitedRect.topLeft() + offset[i];
-            }
-            _clickedPos = QPointF(0,0);
-        }
-        itemRects.clear();
-        offset.clear();
-
-        int count = 0;
-        QList<BoxItem*> *copyList = new QList<BoxItem *>();
-        foreach (QGraphicsItem* item, data->items()) {
-            if (item->type() == QGraphicsItem::UserType + 1) {
-                BoxItem *b = qgraphicsitem_cast<BoxItem*>(item);
-                if (_clickedPos.isNull())
-                    _pastePos[count] += QPointF(10, 10);
-                QRectF rect(_pastePos[count].x(), _pastePos[count].y(), b->rect().width(), b->rect().height());
-                BoxItem *copy = b->copy();
-                copy->setRect(rect);
-                copy->setSelected(true);
-                this->registerItem(copy);
-                copyList->append(copy);
-
-                count++;
-            }
-        }
-        if (copyList->count() > 0) {
-            _undoStack->push(new AddBoxCommand(this, copyList));
-        }
-//        if (copyList)
-//            delete copyList;
-    }
-}
-
-void CustomScene::cut()
-{
-    QList<QGraphicsItem*> copyList;
-    foreach (QGraphicsItem *item , selectedItems()) {
-        if (item->type() == QGraphicsItem::UserType + 1) {
-            BoxItem *b = qgraphicsitem_cast<BoxItem*>(item);
-            BoxItem *copy = b->copy();
-            copyList.append(copy);
-        }
-    }
-    if (copyList.count() > 0){
-        deleteBoxItems();
-        if (_boxItemMimeData) {
-            delete _boxItemMimeData;
-        }
-        _boxItemMimeData = new BoxItemMimeData(copyList);
-        QApplication::clipboard()->setMimeData(_boxItemMimeData);
-
-        _pastePos.clear();
-        for (int i=0; i<copyList.count(); i++)
-            _pastePos.append(QPointF(0,0));
-        _clickedPos = QPointF(0,0);
-    }
-    copyList.clear();
-}
-
-void CustomScene::clipboardDataChanged()
-{
-//    QObject::sender()
-//   pasteAction->setEnabled(true);
-}
+#include "customscene.h"
+#include "loadprofiler.h"
+#include "boxitempool.h"
+#include "annotationwriter.h"
+#include "yololabel.h"
+#include "editjournal.h"
+#include <QCryptographicHash>
+#include <QtDebug>
+#include <QScrollBar>
+
+CustomScene::CustomScene(QObject* parent):
+    QGraphicsScene(parent),
+    _image(nullptr),
+    _pixmapItem(nullptr),
+    _boxItem(nullptr),
+    _isDrawing(false),
+    _undoStack(new QUndoStack),
+    _clickedPos(QPointF(0,0))
+{
+}
+
+void CustomScene::clearAll()
+{
+    saveBoxItemsToFile();
+
+    if (_image != nullptr) {
+        delete _image;
+        _image = nullptr;
+    }
+    if (_pixmapItem != nullptr) {
+        delete _pixmapItem;
+        _pixmapItem = nullptr;
+    }
+    if (_sampleItem != nullptr) {
+        delete _sampleItem;
+        _sampleItem = nullptr;
+    }
+    if (_pages != nullptr) {
+        delete _pages;
+        _pages = nullptr;
+    }
+    if (_boxItemMimeData) {
+        delete _boxItemMimeData;
+    }
+
+    releaseBoxItems();
+    foreach (QGraphicsItem *item, this->items()) {
+        if (item->type() == QGraphicsPixmapItem::Type) {
+            this->removeItem(item);
+            delete item;
+        }
+    }
+
+    if (_undoStack != nullptr) {
+        _undoStack->clear();
+        delete _undoStack;
+        _undoStack = nullptr;
+    }
+
+    this->items().clear();
+    this->clear();
+}
+
+void CustomScene::reset()
+{
+    // keep the scene, its connections and the undo stack for the next image,
+    // only the items of the current one go
+    saveBoxItemsToFile();
+    storeHistory();
+    _undoStack->clear();
+
+    _boxItem = nullptr;
+    _isMoving = false;
+    _isMouseMoved = false;
+    releaseBoxItems();
+
+    if (_sampleItem != nullptr) {
+        delete _sampleItem;
+        _sampleItem = nullptr;
+    }
+    if (_tiledImageItem != nullptr) {
+        delete _tiledImageItem;
+        _tiledImageItem = nullptr;
+    }
+    if (_pages != nullptr) {
+        delete _pages;
+        _pages = nullptr;
+    }
+    _page = 0;
+    _requestedPage = 0;
+
+    // the pixmap item is reused by the next loadImage(), its pyramid is shared with the image cache
+    if (_pixmapItem != nullptr)
+        _pixmapItem->setVisible(false);
+    if (_image != nullptr) {
+        delete _image;
+        _image = nullptr;
+    }
+
+    _imageFileName.clear();
+    _boxItemFileName.clear();
+    _imageSize = QSize();
+}
+
+void CustomScene::loadImage(const QString &filename, const ImagePyramid &image, QSize imageSize)
+{
+    if (image.isNull())
+        return;
+    _image = new QImage(image.image());
+    _imageSize = imageSize.isValid() ? imageSize : _image->size();
+
+    // zoomed out, the item paints a reduced level of the pyramid
+    if (_pixmapItem == nullptr) {
+        _pixmapItem = new ImageItem(image);
+        this->addItem(_pixmapItem);
+    } else {
+        _pixmapItem->setPyramid(image);
+        _pixmapItem->setVisible(true);
+    }
+    fitPixmapToImage();
+
+    // box coordinates always refer to the full resolution image
+    emit imageLoaded(_imageSize);
+    setSceneRect(QRect(QPoint(0, 0), _imageSize));
+
+    // load box items
+    initBoxItems(filename);
+    initSampleItem(image);
+    initPages(filename, image.pageCount());
+}
+
+bool CustomScene::loadTiledImage(const QString &filename)
+{
+    TiledImage *source = new TiledImage();
+    if (!source->open(filename)) {
+        delete source;
+        return false;
+    }
+    _imageSize = source->size();
+
+    // only the tiles intersecting the view are read, at the level matching the zoom
+    _tiledImageItem = new TiledImageItem(source);
+    this->addItem(_tiledImageItem);
+
+    emit imageLoaded(_imageSize);
+    setSceneRect(QRect(QPoint(0, 0), _imageSize));
+
+    initBoxItems(filename);
+    return true;
+}
+
+void CustomScene::initBoxItems(const QString &filename)
+{
+    QFileInfo info(filename);
+    _imageFileName = filename;
+    _boxItemFileName = info.path() + "/" + info.completeBaseName() + ".txt";
+    loadBoxItemsFromFile();
+    restoreHistory();
+}
+
+void CustomScene::replaceImage(const ImagePyramid &image)
+{
+    // the loader only ever decodes the first page
+    if (image.isNull() || _pixmapItem == nullptr || _page != 0)
+        return;
+
+    *_image = image.image();
+    _pixmapItem->setPyramid(image);
+    fitPixmapToImage();
+    initSampleItem(image);
+
+    // previews and thumbnails do not know the page count, the full image does
+    if (_pages == nullptr)
+        initPages(_imageFileName, image.pageCount());
+}
+
+void CustomScene::initSampleItem(const ImagePyramid &image)
+{
+    if (image.samples().isNull() || image.samples().size() != _imageSize)
+        return;
+
+    // high bit depth samples are painted through the window instead of the 8-bit rendering
+    if (_sampleItem != nullptr)
+        delete _sampleItem;
+    _sampleItem = new SampleImageItem(image.samples());
+    _sampleItem->setZValue(-1);
+    this->addItem(_sampleItem);
+    _pixmapItem->setVisible(false);
+
+    emit samplesLoaded();
+}
+
+void CustomScene::initPages(const QString &filename, int pageCount)
+{
+    // the count comes from the loader, opening the file here is left to files that have pages
+    if (pageCount <= 1)
+        return;
+
+    _pages = new MultiPageImage(this);
+    if (!_pages->open(filename)) {
+        delete _pages;
+        _pages = nullptr;
+        return;
+    }
+    connect(_pages, SIGNAL(pageReady(int)), this, SLOT(onPageReady(int)));
+
+    _page = 0;
+    _requestedPage = 0;
+    _pages->requestPage(1);
+    emit pageChanged(_page, _pages->pageCount());
+}
+
+void CustomScene::showPage(int page)
+{
+    if (_pages == nullptr || page < 0 || page >= _pages->pageCount() || page == _page)
+        return;
+
+    // only the most recently requested page is shown once decoded
+    _requestedPage = page;
+    QImage *image = _pages->page(page);
+    if (image != nullptr)
+        applyPage(page, *image);
+    else
+        _pages->requestPage(page);
+}
+
+void CustomScene::onPageReady(int page)
+{
+    if (page != _requestedPage || page == _page)
+        return;
+
+    QImage *image = _pages->page(page);
+    if (image != nullptr)
+        applyPage(page, *image);
+}
+
+void CustomScene::applyPage(int page, const QImage &image)
+{
+    // boxes of the page being left go to its own label file
+    saveBoxItemsToFile();
+    storeHistory();
+    _undoStack->clear();
+    _boxItem = nullptr;
+    releaseBoxItems();
+    if (_sampleItem != nullptr) {
+        delete _sampleItem;
+        _sampleItem = nullptr;
+        _pixmapItem->setVisible(true);
+    }
+
+    _page = page;
+    *_image = image;
+    _imageSize = image.size();
+    _pixmapItem->setPyramid(ImagePyramid(image));
+    fitPixmapToImage();
+
+    emit imageLoaded(_imageSize);
+    setSceneRect(QRect(QPoint(0, 0), _imageSize));
+
+    // the first page keeps the label file of a single page image
+    QFileInfo info(_imageFileName);
+    _boxItemFileName = info.path() + "/" + info.completeBaseName()
+            + (page > 0 ? QString("_page%1").arg(page + 1) : QString()) + ".txt";
+    loadBoxItemsFromFile();
+    restoreHistory();
+
+    _pages->requestPage(page + 1);
+    emit pageChanged(_page, _pages->pageCount());
+}
+
+void CustomScene::setWindow(quint16 low, quint16 high)
+{
+    if (_sampleItem != nullptr)
+        _sampleItem->setWindow(low, high);
+}
+
+void CustomScene::fitPixmapToImage()
+{
+    // a reduced resolution preview is stretched over the full image area
+    _pixmapItem->setTransform(QTransform::fromScale(_imageSize.width() * 1.0 / _image->width(),
+                                                    _imageSize.height() * 1.0 / _image->height()));
+}
+
+void CustomScene::loadBoxItemsFromFile()
+{
+    LoadTimer timer("annotations");
+    _fileIds.clear();
+    _journalFile = -1;
+
+    QByteArray content = AnnotationWriter::instance()->read(_boxItemFileName);
+    _fileHash = QCryptographicHash::hash(content, QCryptographicHash::Sha1);
+
+    QPoint zero(0, 0);
+    QRect fatherRect(zero, _imageSize);
+    qreal x,y,w,h;
+
+    // broken lines are not shown but kept as they are, saving writes them back below the boxes
+    QVector<YoloBox> labels;
+    QVector<YoloError> errors;
+    _rejectedLines.clear();
+    if (!YoloLabel::parse(content, _typeNameList.count(), &labels, &errors)) {
+        foreach (const YoloError &error, errors) {
+            qWarning() << _boxItemFileName << "line" << error.line << error.message;
+            _rejectedLines += error.text + '\n';
+        }
+        emit labelLinesRejected(_boxItemFileName, errors.first().line, errors.count());
+    }
+
+    foreach (const YoloBox &label, labels) {
+        w = label.width * _imageSize.width();
+        h = label.height * _imageSize.height();
+        x = label.x * _imageSize.width() - w/2;
+        y = label.y * _imageSize.height() - h/2;
+
+        BoxItem *b = BoxItemPool::instance()->acquire(fatherRect, _imageSize, _typeNameList, _typeNameList.at(label.classIndex));
+        b->setRect(x,y,w,h);
+        this->registerItem(b);
+        if (!b->rect().isNull()) {
+            b->setId(_nextBoxId++);
+            _boxItems.insert(b->id(), b);
+            _fileIds.append(b->id());
+            this->addItem(b);
+        } else {
+            BoxItemPool::instance()->release(b);
+        }
+    }
+}
+
+void CustomScene::reloadBoxItems(const QString &labelFile)
+{
+    if (_boxItemFileName.isEmpty() || QFileInfo(labelFile) != QFileInfo(_boxItemFileName))
+        return;
+
+    // files written by the annotation writer come back as changes too
+    QByteArray content;
+    QFile file(_boxItemFileName);
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+        content = file.readAll();
+    if (QCryptographicHash::hash(content, QCryptographicHash::Sha1) == _fileHash)
+        return;
+
+    // local edits, or a snapshot still on its way to disk, will replace the new file,
+    // which is kept next to it
+    AnnotationWriter *writer = AnnotationWriter::instance();
+    if (isModified() || writer->pendingContent(_boxItemFileName)) {
+        if (file.exists())
+            writer->write(_boxItemFileName + ".conflict", content);
+        emit labelConflict(_boxItemFileName);
+        return;
+    }
+
+    // nothing to lose, the boxes are loaded again, their ids and undo history start over
+    _undoStack->clear();
+    _boxItem = nullptr;
+    _isMoving = false;
+    _isMouseMoved = false;
+    releaseBoxItems();
+    loadBoxItemsFromFile();
+}
+
+void CustomScene::releaseBoxItems()
+{
+    // boxes go back to the pool instead of being destroyed with the image
+    foreach (QGraphicsItem *item, this->items()) {
+        if (item->type() == QGraphicsItem::UserType+1) {
+            BoxItemPool::instance()->release(qgraphicsitem_cast<BoxItem *>(item));
+        }
+    }
+    _boxItems.clear();
+    _nextBoxId = 1;
+}
+
+BoxItem *CustomScene::createBoxItem(const BoxRecord &record)
+{
+    BoxItem *b = BoxItemPool::instance()->acquire(this->sceneRect(), _imageSize, _typeNameList, record.typeName);
+    QCursor cursor(record.cursor);
+    b->setId(record.id);
+    b->setRect(record.rect);
+    b->setOldCursor(cursor);
+    if (b->rect().isNull()) {
+        BoxItemPool::instance()->release(b);
+        return nullptr;
+    }
+
+    this->registerItem(b);
+    this->addItem(b);
+    _boxItems.insert(record.id, b);
+    return b;
+}
+
+void CustomScene::removeBoxItem(int id)
+{
+    BoxItem *b = _boxItems.take(id);
+    if (b != nullptr)
+        BoxItemPool::instance()->release(b);
+}
+
+int CustomScene::journalFile()
+{
+    // edits are journaled against the boxes the label file was loaded or last saved with
+    if (_journalFile < 0 || !EditJournal::instance()->isBaselined(_journalFile)) {
+        QVector<JournalBox> boxes;
+        boxes.reserve(_boxItems.count());
+        foreach (BoxItem *b, _boxItems) {
+            JournalBox box;
+            box.id = b->id();
+            box.classIndex = classIndex(b->typeName());
+            box.rect = b->rect();
+            boxes.append(box);
+        }
+        _journalFile = EditJournal::instance()->baseline(_boxItemFileName, _imageSize, _fileHash, boxes, _rejectedLines);
+    }
+    return _journalFile;
+}
+
+void CustomScene::storeHistory()
+{
+    if (_history == nullptr || _boxItemFileName.isEmpty())
+        return;
+    _history->remove(_boxItemFileName);
+    if (_undoStack->count() == 0)
+        return;
+
+    // the stack deletes its commands when cleared, the history keeps copies
+    UndoHistoryEntry *entry = new UndoHistoryEntry;
+    for (int i = 0; i < _undoStack->count(); i++) {
+        const BoxCommand *command = dynamic_cast<const BoxCommand *>(_undoStack->command(i));
+        if (command == nullptr) {
+            delete entry;
+            return;
+        }
+        entry->commands.append(command->clone(this));
+    }
+    entry->index = _undoStack->index();
+    entry->fileIds = _fileIds;
+    entry->nextId = _nextBoxId;
+    entry->fileHash = _fileHash;
+    _history->insert(_boxItemFileName, entry);
+}
+
+void CustomScene::restoreHistory()
+{
+    UndoHistoryEntry *entry = _history != nullptr ? _history->take(_boxItemFileName) : nullptr;
+    if (entry == nullptr)
+        return;
+
+    // the label file must be the one written when the image was left
+    if (_fileHash != entry->fileHash || _boxItems.count() != entry->fileIds.count()) {
+        delete entry;
+        return;
+    }
+
+    // boxes were loaded with ids in file order, give them back the ids the commands refer to
+    QHash<int, BoxItem *> boxItems;
+    for (int i = 0; i < entry->fileIds.count(); i++) {
+        BoxItem *b = _boxItems.value(i + 1);
+        b->setId(entry->fileIds.at(i));
+        boxItems.insert(b->id(), b);
+    }
+    _boxItems = boxItems;
+    _fileIds = entry->fileIds;
+    _nextBoxId = entry->nextId;
+
+    // the label file already reflects the commands up to the index. The history is shared
+    // by both scenes, the commands are bound to this one, the stored copies go with the entry
+    _isReplaying = true;
+    foreach (BoxCommand *command, entry->commands) {
+        _undoStack->push(command->clone(this));
+    }
+    _undoStack->setIndex(entry->index);
+    _undoStack->setClean();
+    _isReplaying = false;
+
+    delete entry;
+}
+
+void CustomScene::registerItem(BoxItem *b)
+{
+    connect(b, SIGNAL(typeNameChanged(QString)), this, SLOT(changeBoxTypeName(QString)));
+    connect(b, SIGNAL(boxSelected(QRect, QString)), this, SIGNAL(boxSelected(QRect, QString)));
+    connect(b, SIGNAL(boxSelected(QRect, QString)), this, SLOT(selectedBoxItemInfo(QRect,QString)));
+    connect(b, SIGNAL(stretchCompleted(QRectF, QRectF)), this, SLOT(moveBox(QRectF, QRectF)));
+    connect(b, SIGNAL(moveCompleted(QRectF, QRectF)), this, SLOT(moveBox(QRectF, QRectF)));
+    b->installEventFilter(this);
+}
+
+void CustomScene::saveBoxItemsToFile()
+{
+    // the undo stack is clean as long as the boxes match the label file
+    if (_boxItemFileName.isEmpty())
+        return;
+    if (!isModified()) {
+        // edits undone, the journal need not keep them
+        if (_journalFile >= 0)
+            EditJournal::instance()->unchanged(_journalFile, _fileHash);
+        return;
+    }
+
+    // an image without labels keeps having no label file
+    AnnotationWriter *writer = AnnotationWriter::instance();
+    if (_boxItems.isEmpty() && !QFile::exists(_boxItemFileName) && !writer->pendingContent(_boxItemFileName)) {
+        _fileIds.clear();
+        _undoStack->setClean();
+        if (_journalFile >= 0)
+            EditJournal::instance()->unchanged(_journalFile, _fileHash);
+        return;
+    }
+
+    QHash<QString, int> classIndex;
+    for (int i = 0; i < _typeNameList.count(); i++) {
+        classIndex.insert(_typeNameList.at(i), i);
+    }
+
+    qreal label[4];
+    QVector<YoloBox> labels;
+    labels.reserve(_boxItems.count());
+    _fileIds.clear();
+
+    foreach (QGraphicsItem *item, this->items()) {
+        if (item->type() == QGraphicsItem::UserType+1) {
+            BoxItem *b = qgraphicsitem_cast<BoxItem *>(item);
+            b->rect(label);
+            _fileIds.append(b->id());
+            YoloBox box;
+            box.classIndex = classIndex.value(b->typeName(), -1);
+            box.x = float(label[0]);
+            box.y = float(label[1]);
+            box.width = float(label[2]);
+            box.height = float(label[3]);
+            labels.append(box);
+        }
+    }
+
+    // the writer thread replaces the file with this snapshot
+    QByteArray content = YoloLabel::serialize(labels) + _rejectedLines;
+    QByteArray replacedHash = _fileHash;
+    _fileHash = QCryptographicHash::hash(content, QCryptographicHash::Sha1);
+    writer->write(_boxItemFileName, content);
+    if (_journalFile >= 0)
+        EditJournal::instance()->saved(_journalFile, replacedHash, _fileHash);
+    _undoStack->setClean();
+
+    // the label file of the first page is the one of the image
+    if (_page == 0)
+        emit labelsSaved(_imageFileName, labels);
+}
+
+void CustomScene::deleteBoxItems()
+{
+    QVector<BoxRecord> boxList;
+    foreach (QGraphicsItem *item, this->selectedItems()) {
+        if (item->type() == QGraphicsItem::UserType+1) {
+            boxList.append(BoxRecord::fromItem(qgraphicsitem_cast<BoxItem *>(item)));
+        }
+    }
+
+    if (boxList.count() > 0) {
+        _undoStack->push(new RemoveBoxesCommand(this, boxList));
+        QApplication::setOverrideCursor(QCursor(boxList.first().cursor));
+    }
+}
+
+void CustomScene::selectBoxItems(bool op)
+{
+    // selecting box items
+    foreach (QGraphicsItem *item, this->items()) {
+        if (item->type() == QGraphicsItem::UserType+1) {
+            item->setSelected(op);
+        }
+    }
+}
+
+void CustomScene::selectBoxItems(BoxItem *box, bool op)
+{
+    foreach (QGraphicsItem *item, this->items()) {
+        if (item->type() == QGraphicsItem::UserType+1) {
+            item->setSelected(item==qgraphicsitem_cast<QGraphicsItem *>(box));
+        }
+    }
+}
+
+void CustomScene::selectBoxItems(QList<BoxItem *> *boxList, bool op)
+{
+    foreach (QGraphicsItem *item, this->items()) {
+        if (item->type() == QGraphicsItem::UserType+1) {
+            item->setSelected(boxList->contains(qgraphicsitem_cast<BoxItem *>(item)));
+        }
+    }
+}
+
+void CustomScene::drawBoxItem(bool op)
+{
+    _isDrawing = op;
+    _isPanning = false;
+}
+
+void CustomScene::panImage(bool op)
+{
+    _isDrawing = false;
+    _isPanning = op;
+    selectBoxItems(false);
+}
+
+void CustomScene::mousePressEvent(QGraphicsSceneMouseEvent *event)
+{
+    switch (event->buttons()) {
+    case Qt::LeftButton:
+        _leftTopPoint = event->scenePos();
+        if (_isDrawing && event->modifiers() != Qt::ControlModifier) { // drawing box item
+
+            // no box selected
+            int count = 0;
+            foreach (QGraphicsItem *item, this->selectedItems()) {
+                if (item->type() == QGraphicsItem::UserType + 1) {
+                    if (item->isSelected()) {
+                        count++;
+                    }
+                }
+            }
+            if (count <= 0) {
+                QGraphicsScene::mousePressEvent(event);
+                return;
+            }
+
+            // selected box do not contain pressed pos
+            count = 0;
+            foreach (QGraphicsItem *item, this->items()) {
+                if (item->type() == QGraphicsItem::UserType + 1) {
+                    if (item->isSelected() && !item->contains(_leftTopPoint)) {
+                        item->setSelected(false);
+                        count++;
+                    }
+                }
+            }
+            if (count >0) {
+                QGraphicsScene::mousePressEvent(event);
+                return;
+            }
+
+            // selected box contain pressed pos
+            foreach (QGraphicsItem *item, this->items()) {
+                if ((item->type() == QGraphicsItem::UserType + 1 && item->contains(_leftTopPoint))) {
+                    _isMoving = true;
+                    QGraphicsScene::mousePressEvent(event);
+                    return;
+                }
+            }
+        } else if (event->modifiers() == Qt::ControlModifier) { // selecting multiple box items
+            foreach (QGraphicsItem *item, this->items()) {
+                if ((item->type() == QGraphicsItem::UserType + 1 && item->contains(_leftTopPoint))) {
+                    item->setSelected(true);
+                    break;
+                }
+            }
+            QGraphicsScene::mousePressEvent(event);
+        } else {// selecting single box item
+            foreach (QGraphicsItem *item, this->items()) {
+                if ((item->type() == QGraphicsItem::UserType + 1 && item->contains(_leftTopPoint))) {
+                    selectBoxItems(qgraphicsitem_cast<BoxItem *>(item), true);
+                    _isMoving = true;
+                    QGraphicsScene::mousePressEvent(event);
+                    break;
+                }
+            }
+        }
+        break;
+    case Qt::RightButton:
+        QGraphicsScene::mousePressEvent(event);
+        break;
+    default:
+        break;
+    }
+    QGraphicsScene::mousePressEvent(event);
+}
+
+void CustomScene::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (event->buttons() & Qt::LeftButton) {
+        _isMouseMoved = true;
+
+        // add new box item
+        if(_isDrawing && (this->selectedItems().count() <= 0 || _boxItem) && !_isMoving && !_isPanning) {
+            if(!_boxItem) {
+                _boxItem = BoxItemPool::instance()->acquire(this->sceneRect(), _imageSize, _typeNameList, _typeName);
+                this->registerItem(_boxItem);
+                this->addItem(_boxItem);
+            }
+            _boxItem->setSelected(true);
+            _rightBottomPoint = event->scenePos();
+            QRect roi(qMin(_rightBottomPoint.x(), _leftTopPoint.x()),
+                      qMin(_rightBottomPoint.y(), _leftTopPoint.y()),
+                      qAbs(_rightBottomPoint.x() - _leftTopPoint.x()),
+                      qAbs(_rightBottomPoint.y() - _leftTopPoint.y()));
+            int l = sceneRect().left(), r = sceneRect().right(),
+                    t = sceneRect().top(), b = sceneRect().bottom();
+            if (roi.right() < l || roi.left() > r ||
+                    roi.top() > b || roi.bottom() < t )
+                return;
+
+            roi.setTop(qMax(t, roi.top()));
+            roi.setLeft(qMax(l, roi.left()));
+            roi.setBottom(qMin(b, roi.bottom()));
+            roi.setRight(qMin(r, roi.right()));
+
+            _boxItem->setRect(roi);
+        }
+
+        if (_isMoving) {
+            QGraphicsScene::mouseMoveEvent(event);
+        }
+    }
+    emit cursorMoved(event->scenePos());
+
+    if(!(_isDrawing && this->selectedItems().count()<=0))
+        QGraphicsScene::mouseMoveEvent(event);
+}
+
+void CustomScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (_isMouseMoved) {
+        if (_isDrawing) {
+            if (_boxItem) {
+                this->removeItem(_boxItem);
+                if ( _boxItem->rect().width() > 5 && (_boxItem->rect().height() > 5 ) ) {
+                    QCursor c = Qt::CrossCursor;
+                    _boxItem->setOldCursor(c);
+                    _boxItem->setId(_nextBoxId++);
+                    // the command creates the box from its values
+                    BoxRecord record = BoxRecord::fromItem(_boxItem);
+                    BoxItemPool::instance()->release(_boxItem);
+                    _undoStack->push(new AddBoxCommand(this, QVector<BoxRecord>() << record));
+                } else {
+                    BoxItemPool::instance()->release(_boxItem);
+                }
+                _boxItem = nullptr;
+                return;
+            }
+        }
+        if (_isMoving) {
+            _isMoving = false;
+            QGraphicsScene::mouseReleaseEvent(event);
+        }
+
+        _isMouseMoved = false;
+        return;
+    } else {
+        if (_boxItemMimeData)
+            _clickedPos = event->scenePos();
+    }
+
+    QGraphicsScene::mouseReleaseEvent(event);
+}
+
+void CustomScene::keyPressEvent(QKeyEvent *keyEvent)
+{
+    if(keyEvent->key() == Qt::Key_Delete) {
+        deleteBoxItems();
+    } else if(keyEvent->key() == Qt::Key_A && keyEvent->modifiers() == Qt::ControlModifier) {
+        selectBoxItems(true);
+    }else {
+        QGraphicsScene::keyPressEvent(keyEvent);
+    }
+}
+
+void CustomScene::keyReleaseEvent(QKeyEvent *keyEvent)
+{
+    QGraphicsScene::keyReleaseEvent(keyEvent);
+}
+
+void CustomScene::changeBoxTypeName(QString name)
+{
+    _typeName = name;
+    QVector<int> ids;
+    QStringList oldNames;
+    foreach (QGraphicsItem *item, this->selectedItems()) {
+        if (item->type() == QGraphicsItem::UserType+1) {
+            BoxItem *b = qgraphicsitem_cast<BoxItem *>(item);
+            ids.append(b->id());
+            oldNames.append(b->typeName());
+        }
+    }
+
+    if (ids.count() > 0) {
+        _undoStack->push(new SetTargetTypeCommand(this, ids, oldNames, name));
+    }
+}
+
+void CustomScene::moveBox(QRectF newRect, QRectF oldRect)
+{
+    BoxItem *item = reinterpret_cast<BoxItem *>(QObject::sender());
+    if (item != nullptr) {
+        _undoStack->push(new MoveBoxCommand(this, item->id(), newRect, oldRect));
+    }
+}
+
+
+void CustomScene::copy()
+{
+    if (selectedItems().count() <=0 )
+        return;
+
+    if (_boxItemMimeData) {
+        delete _boxItemMimeData;
+    }
+    _boxItemMimeData = new BoxItemMimeData(selectedItems());
+    QApplication::clipboard()->setMimeData(_boxItemMimeData);
+
+    _pastePos.clear();
+    for (int i=0; i<selectedItems().count(); i++)
+        _pastePos.append(QPointF(0,0));
+    _clickedPos = QPointF(0,0);
+}
+
+void CustomScene::paste()
+{
+    QMimeData *m = const_cast<QMimeData *>(QApplication::clipboard()->mimeData()) ;
+    BoxItemMimeData *data = dynamic_cast<BoxItemMimeData*>(m);
+    if (data){
+        clearSelection();
+
+        QList<QPointF> offset;
+        QList<QRectF> itemRects;
+        QRectF unitedRect(0,0,0,0);
+
+        for (int i=0; i<data->items().count(); i++) {
+            BoxItem *b = qgraphicsitem_cast<BoxItem*>(data->items().at(i));
+            itemRects.append(b->rect());
+            unitedRect = unitedRect.united(b->rect());
+        }
+        if (!unitedRect.isNull()) {
+            for (int i=0; i<itemRects.count(); i++) {
+                offset.append(itemRects[i].topLeft() - unitedRect.topLeft());
+            }
+        }
+
+        for (int i=0; i<_pastePos.count(); i++) {
+            if (_pastePos[i].isNull()) {
+                _pastePos[i] = QPointF(itemRects[i].x(), itemRects[i].y());
+            }
+        }
+        if (!_clickedPos.isNull()) {
+            unitedRect.moveCenter(_clickedPos);
+            for (int i=0; i<_pastePos.count(); i++) {
+                _pastePos[i] = unitedRect.topLeft() + offset[i];
+            }
+            _clickedPos = QPointF(0,0);
+        }
+        itemRects.clear();
+        offset.clear();
+
+        int count = 0;
+        QVector<BoxRecord> copyList;
+        foreach (QGraphicsItem* item, data->items()) {
+            if (item->type() == QGraphicsItem::UserType + 1) {
+                BoxItem *b = qgraphicsitem_cast<BoxItem*>(item);
+                if (_clickedPos.isNull())
+                    _pastePos[count] += QPointF(10, 10);
+                BoxRecord copy = BoxRecord::fromItem(b);
+                copy.id = _nextBoxId++;
+                copy.rect = QRectF(_pastePos[count].x(), _pastePos[count].y(), b->rect().width(), b->rect().height());
+                copyList.append(copy);
+
+                count++;
+            }
+        }
+        if (copyList.count() > 0) {
+            _undoStack->push(new AddBoxCommand(this, copyList));
+        }
+    }
+}
+
+void CustomScene::cut()
+{
+    if (selectedItems().count() <= 0)
+        return;
+
+    // the clipboard takes its own copies, the cut boxes then go back to the pool
+    if (_boxItemMimeData) {
+        delete _boxItemMimeData;
+    }
+    _boxItemMimeData = new BoxItemMimeData(selectedItems());
+    QApplication::clipboard()->setMimeData(_boxItemMimeData);
+
+    _pastePos.clear();
+    for (int i=0; i<selectedItems().count(); i++)
+        _pastePos.append(QPointF(0,0));
+    _clickedPos = QPointF(0,0);
+
+    deleteBoxItems();
+}
+
+void CustomScene::clipboardDataChanged()
+{
+//    QObject::sender()
+//   pasteAction->setEnabled(true);
+}
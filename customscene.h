@@ -1,101 +1,194 @@
-#ifndef CUSTOMSCENE_H
-#define CUSTOMSCENE_H
-
-#include <QGraphicsScene>
-#include <QGraphicsSceneMouseEvent>
-#include <QGraphicsLineItem>
-#include <QAction>
-#include <QGraphicsView>
-#include <QKeyEvent>
-#include "boxitem.h"
-#include <QFileInfo>
-#include <QFile>
-#include <QImageReader>
-#include <QUndoStack>
-#include "commands.h"
-#include "FreeImage.h"
-#include "boxitemmimedata.h"
-#include <QClipboard>
-
-class CustomScene : public QGraphicsScene
-{
-    Q_OBJECT
-public:
-    CustomScene(QObject* parent = 0);
-    ~CustomScene()
-    {
-        clearAll();
-    }
-
-    void loadImage(QString path);
-    void saveToFile(const QString& path);
-    void clearAll();
-
-    void setTypeNameList (const QStringList &list)
-    {
-        _typeNameList = list;
-    }
-    void setTypeName (const QString &name)
-    {
-        _typeName = name;
-    }
-    QUndoStack *undoStack() const
-    {
-        return _undoStack;
-    }
-    void selectBoxItems(QList<BoxItem *> *boxList, bool op);
-    void selectBoxItems(BoxItem *box, bool op);
-    void selectBoxItems(bool op);
-    void registerItem(BoxItem *b);
-    void drawBoxItem(bool op);
-    void panImage(bool op);
-
-public slots:
-    void changeBoxTypeName(QString name);
-    void selectedBoxItemInfo(QRect rect, QString typeName)
-    {
-        _typeName = typeName;
-    }
-    void copy();
-    void cut();
-    void paste();
-    void clipboardDataChanged();
-
-private slots:
-    void moveBox(QRectF newRect, QRectF oldRect);
-
-signals:
-    void imageLoaded(QSize imageSize);
-    void cursorMoved(QPointF cursorPos);
-    void boxSelected(QRect boxRect, QString typeName);
-
-protected:
-    void mousePressEvent(QGraphicsSceneMouseEvent *event);
-    void mouseMoveEvent(QGraphicsSceneMouseEvent *event);
-    void mouseReleaseEvent(QGraphicsSceneMouseEvent *event);
-    void keyPressEvent(QKeyEvent *keyEvent);
-    void keyReleaseEvent(QKeyEvent *keyEvent);
-    void deleteBoxItems();
-private:
-    QImage *_image;
-    QGraphicsPixmapItem *_pixmapItem = nullptr;
-    BoxItem* _boxItem = nullptr;//, *_selectedBoxItem;
-    QString _typeName;
-    QStringList _typeNameList;
-    double _zoomFactor = 1;
-    QPointF _dragStart, _dragEnd;
-    bool _isPanning = false;
-    bool _isDrawing = false;
-    bool _isMoving = false;
-    bool _isMouseMoved = false;
-    QPointF _leftTopPoint;
-    QPointF _rightBottomPoint;
-    QString _boxItemFileName;
-    QUndoStack *_undoStack;
-    BoxItemMimeData *_boxItemMimeData = nullptr;
-    QList<QPointF> _pastePos;
-    QPointF _clickedPos;
-    void loadBoxItemsFromFile();
-    void saveBoxItemsToFile();
-};
-#endif // CUSTOMSCENE_H
+#ifndef CUSTOMSCENE_H
+#define CUSTOMSCENE_H
+
+#include <QGraphicsScene>
+#include <QGraphicsSceneMouseEvent>
+#include <QGraphicsLineItem>
+#include <QAction>
+#include <QGraphicsView>
+#include <QKeyEvent>
+#include "boxitem.h"
+#include <QFileInfo>
+#include <QFile>
+#include <QImageReader>
+#include <QUndoStack>
+#include <QHash>
+#include "commands.h"
+#include "boxitemmimedata.h"
+#include "tiledimageitem.h"
+#include "imageitem.h"
+#include "sampleimageitem.h"
+#include "multipageimage.h"
+#include "undohistory.h"
+#include "yololabel.h"
+#include <QClipboard>
+
+class CustomScene : public QGraphicsScene
+{
+    Q_OBJECT
+public:
+    CustomScene(QObject* parent = 0);
+    ~CustomScene()
+    {
+        clearAll();
+    }
+
+    void loadImage(const QString &filename, const ImagePyramid &image, QSize imageSize = QSize());
+    bool loadTiledImage(const QString &filename);
+    void replaceImage(const ImagePyramid &image);
+    bool isPreview() const
+    {
+        return _image != nullptr && _image->size() != _imageSize;
+    }
+    QString imageFileName() const
+    {
+        return _imageFileName;
+    }
+    QString labelFileName() const
+    {
+        return _boxItemFileName;
+    }
+    void reloadBoxItems(const QString &labelFile);
+    QSize imageSize() const
+    {
+        return _imageSize;
+    }
+    void setUndoHistory(UndoHistory *history)
+    {
+        _history = history;
+    }
+    SampleImageItem *sampleItem() const
+    {
+        return _sampleItem;
+    }
+    void setWindow(quint16 low, quint16 high);
+    int page() const
+    {
+        return _page;
+    }
+    int pageCount() const
+    {
+        return _pages != nullptr ? _pages->pageCount() : 1;
+    }
+    void showPage(int page);
+    void saveToFile(const QString& path);
+    void clearAll();
+
+    void setTypeNameList (const QStringList &list)
+    {
+        _typeNameList = list;
+    }
+    void setTypeName (const QString &name)
+    {
+        _typeName = name;
+    }
+    QUndoStack *undoStack() const
+    {
+        return _undoStack;
+    }
+    bool isModified() const
+    {
+        return _undoStack != nullptr && !_undoStack->isClean();
+    }
+    BoxItem *boxItem(int id) const
+    {
+        return _boxItems.value(id);
+    }
+    BoxItem *createBoxItem(const BoxRecord &record);
+    void removeBoxItem(int id);
+    bool isReplaying() const
+    {
+        return _isReplaying;
+    }
+    int journalFile();
+    int classIndex(const QString &typeName) const
+    {
+        return _typeNameList.indexOf(typeName);
+    }
+    void selectBoxItems(QList<BoxItem *> *boxList, bool op);
+    void selectBoxItems(BoxItem *box, bool op);
+    void selectBoxItems(bool op);
+    void registerItem(BoxItem *b);
+    void drawBoxItem(bool op);
+    void panImage(bool op);
+
+public slots:
+    void reset();
+    void changeBoxTypeName(QString name);
+    void selectedBoxItemInfo(QRect rect, QString typeName)
+    {
+        _typeName = typeName;
+    }
+    void copy();
+    void cut();
+    void paste();
+    void clipboardDataChanged();
+
+private slots:
+    void moveBox(QRectF newRect, QRectF oldRect);
+    void onPageReady(int page);
+
+signals:
+    void imageLoaded(QSize imageSize);
+    void samplesLoaded();
+    void pageChanged(int page, int pageCount);
+    void cursorMoved(QPointF cursorPos);
+    void boxSelected(QRect boxRect, QString typeName);
+    void labelsSaved(QString imageFileName, QVector<YoloBox> labels);
+    void labelConflict(QString labelFile);
+    void labelLinesRejected(QString labelFile, int firstLine, int count);
+
+protected:
+    void mousePressEvent(QGraphicsSceneMouseEvent *event);
+    void mouseMoveEvent(QGraphicsSceneMouseEvent *event);
+    void mouseReleaseEvent(QGraphicsSceneMouseEvent *event);
+    void keyPressEvent(QKeyEvent *keyEvent);
+    void keyReleaseEvent(QKeyEvent *keyEvent);
+    void deleteBoxItems();
+private:
+    QImage *_image;
+    QSize _imageSize;
+    QString _imageFileName;
+    ImageItem *_pixmapItem = nullptr;
+    TiledImageItem *_tiledImageItem = nullptr;
+    SampleImageItem *_sampleItem = nullptr;
+    MultiPageImage *_pages = nullptr;
+    int _page = 0;
+    int _requestedPage = 0;
+    BoxItem* _boxItem = nullptr;//, *_selectedBoxItem;
+    QString _typeName;
+    QStringList _typeNameList;
+    double _zoomFactor = 1;
+    QPointF _dragStart, _dragEnd;
+    bool _isPanning = false;
+    bool _isDrawing = false;
+    bool _isMoving = false;
+    bool _isMouseMoved = false;
+    QPointF _leftTopPoint;
+    QPointF _rightBottomPoint;
+    QString _boxItemFileName;
+    QUndoStack *_undoStack;
+    UndoHistory *_history = nullptr;
+    bool _isReplaying = false;
+    QHash<int, BoxItem *> _boxItems;
+    int _nextBoxId = 1;
+    QVector<int> _fileIds;
+    QByteArray _fileHash;
+    // lines of the label file that could not be parsed, written back unchanged
+    QByteArray _rejectedLines;
+    int _journalFile = -1;
+    BoxItemMimeData *_boxItemMimeData = nullptr;
+    QList<QPointF> _pastePos;
+    QPointF _clickedPos;
+    void initBoxItems(const QString &filename);
+    void loadBoxItemsFromFile();
+    void releaseBoxItems();
+    void storeHistory();
+    void restoreHistory();
+    void saveBoxItemsToFile();
+    void fitPixmapToImage();
+    void initSampleItem(const ImagePyramid &image);
+    void initPages(const QString &filename, int pageCount);
+    void applyPage(int page, const QImage &image);
+};
+#endif // CUSTOMSCENE_H
@@ -0,0 +1,479 @@
+#include "editjournal.h"
+#include "annotationwriter.h"
+#include "yololabel.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QMap>
+#include <QSet>
+#include <QtDebug>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+static const quint32 JournalMagic = 0x4c494a52; // "LIJR"
+static const quint32 JournalVersion = 2;
+
+// a label file as the journal replays it
+struct ReplayFile
+{
+    QString labelFile;
+    QSize imageSize;
+    QMap<int, JournalBox> boxes;
+    QByteArray rejectedLines;
+    QByteArray savedHash;
+    // contents the label file had while it was edited, any other content is not ours to replace
+    QSet<QByteArray> knownHashes;
+};
+
+static void syncFile(QFile *file)
+{
+    // QFile::flush() only hands the data to the system, power loss could still drop it
+#ifdef Q_OS_WIN
+    _commit(file->handle());
+#else
+    fsync(file->handle());
+#endif
+}
+
+static void writeBoxes(QDataStream &out, const QVector<JournalBox> &boxes)
+{
+    out << qint32(boxes.count());
+    foreach (const JournalBox &box, boxes) {
+        out << qint32(box.id) << qint32(box.classIndex) << box.rect;
+    }
+}
+
+static void readBoxes(QDataStream &in, QMap<int, JournalBox> *boxes)
+{
+    qint32 count;
+    in >> count;
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        qint32 id, classIndex;
+        JournalBox box;
+        in >> id >> classIndex >> box.rect;
+        box.id = id;
+        box.classIndex = classIndex;
+        boxes->insert(box.id, box);
+    }
+}
+
+EditJournal::EditJournal()
+{
+    // a label file that could not be written keeps its edits in the journal
+    connect(AnnotationWriter::instance(), &AnnotationWriter::writeFailed,
+            this, &EditJournal::onWriteFailed, Qt::DirectConnection);
+    connect(AnnotationWriter::instance(), &AnnotationWriter::fileWritten,
+            this, &EditJournal::onFileWritten, Qt::QueuedConnection);
+    start(QThread::LowPriority);
+}
+
+EditJournal::~EditJournal()
+{
+    // records still buffered are written before the thread finishes
+    {
+        QMutexLocker locker(&_mutex);
+        _isQuitting = true;
+        _queued.wakeAll();
+    }
+    wait();
+}
+
+EditJournal *EditJournal::instance()
+{
+    static EditJournal journal;
+    return &journal;
+}
+
+void EditJournal::open(const QString &fileName)
+{
+    QMutexLocker locker(&_mutex);
+    _fileName = fileName;
+    _queued.wakeOne();
+}
+
+void EditJournal::close()
+{
+    QMutexLocker locker(&_mutex);
+    _isClosing = true;
+    _queued.wakeOne();
+    while (_isClosing)
+        _idle.wait(&_mutex);
+}
+
+int EditJournal::baseline(const QString &labelFile, const QSize &imageSize, const QByteArray &fileHash,
+                          const QVector<JournalBox> &boxes, const QByteArray &rejectedLines)
+{
+    int file = _files.value(labelFile, -1);
+    if (file < 0) {
+        file = _files.count();
+        _files.insert(labelFile, file);
+    }
+    _baselined.insert(file);
+    edited(file);
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << qint32(file) << labelFile << imageSize << fileHash << rejectedLines;
+    writeBoxes(out, boxes);
+    append(Baseline, payload);
+    return file;
+}
+
+void EditJournal::addBoxes(int file, const QVector<JournalBox> &boxes)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << qint32(file);
+    writeBoxes(out, boxes);
+    append(AddBoxes, payload);
+    edited(file);
+}
+
+void EditJournal::removeBoxes(int file, const QVector<int> &ids)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << qint32(file) << qint32(ids.count());
+    foreach (int id, ids) {
+        out << qint32(id);
+    }
+    append(RemoveBoxes, payload);
+    edited(file);
+}
+
+void EditJournal::setClasses(int file, const QVector<int> &ids, const QVector<int> &classIndexes)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << qint32(file) << qint32(ids.count());
+    for (int i = 0; i < ids.count(); i++) {
+        out << qint32(ids.at(i)) << qint32(classIndexes.at(i));
+    }
+    append(SetClasses, payload);
+    edited(file);
+}
+
+void EditJournal::moveBox(int file, int id, const QRectF &rect)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << qint32(file) << qint32(id) << rect;
+    append(MoveBox, payload);
+    edited(file);
+}
+
+void EditJournal::saved(int file, const QByteArray &replacedHash, const QByteArray &fileHash)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << qint32(file) << replacedHash << fileHash;
+    append(Saved, payload);
+    _savedHashes.insert(file, fileHash);
+}
+
+void EditJournal::unchanged(int file, const QByteArray &fileHash)
+{
+    if (!_unconfirmed.contains(file))
+        return;
+
+    // the same content may still be on its way to the file, it is confirmed once written
+    if (AnnotationWriter::instance()->pendingContent(_files.key(file))) {
+        _savedHashes.insert(file, fileHash);
+        return;
+    }
+    confirmed(file);
+}
+
+void EditJournal::edited(int file)
+{
+    _unconfirmed.insert(file);
+    _savedHashes.remove(file);
+}
+
+void EditJournal::append(RecordType type, const QByteArray &payload)
+{
+    // the checksum tells a record torn by a crash from a complete one
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out << quint8(type) << payload << qChecksum(payload.constData(), uint(payload.size()));
+
+    QMutexLocker locker(&_mutex);
+    if (_isClosed)
+        return;
+    _buffer.append(record);
+    _queued.wakeOne();
+}
+
+void EditJournal::onWriteFailed()
+{
+    QMutexLocker locker(&_mutex);
+    _isWriteFailed = true;
+}
+
+void EditJournal::onFileWritten(const QString &labelFile, const QByteArray &content)
+{
+    // a snapshot written after the file was edited again, or replaced by a newer one, does not count
+    int file = _files.value(labelFile, -1);
+    if (file < 0 || !_savedHashes.contains(file)
+            || QCryptographicHash::hash(content, QCryptographicHash::Sha1) != _savedHashes.value(file))
+        return;
+
+    confirmed(file);
+}
+
+void EditJournal::confirmed(int file)
+{
+    _savedHashes.remove(file);
+    _unconfirmed.remove(file);
+    if (!_unconfirmed.isEmpty())
+        return;
+
+    // no record is needed any more, the next edit of a file starts from a new baseline
+    _baselined.clear();
+    QMutexLocker locker(&_mutex);
+    if (_isWriteFailed || _isClosed)
+        return;
+    _buffer.clear();
+    _isCompacting = true;
+    _queued.wakeOne();
+}
+
+int EditJournal::recover(const QByteArray &data, int *conflicts)
+{
+    *conflicts = 0;
+    QDataStream in(data);
+    quint32 magic, version;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != JournalMagic || version != JournalVersion)
+        return 0;
+
+    // replay stops at the first incomplete record, the ones before it are intact
+    QHash<int, ReplayFile> files;
+    forever {
+        quint8 type;
+        QByteArray payload;
+        quint16 checksum;
+        in >> type >> payload >> checksum;
+        if (in.status() != QDataStream::Ok || checksum != qChecksum(payload.constData(), uint(payload.size())))
+            break;
+
+        QDataStream record(payload);
+        qint32 file;
+        record >> file;
+        ReplayFile &state = files[file];
+        if (type != Saved)
+            state.savedHash.clear();
+
+        switch (type) {
+        case Baseline: {
+            QByteArray fileHash;
+            state.boxes.clear();
+            state.knownHashes.clear();
+            record >> state.labelFile >> state.imageSize >> fileHash >> state.rejectedLines;
+            state.knownHashes.insert(fileHash);
+            readBoxes(record, &state.boxes);
+            break;
+        }
+        case AddBoxes:
+            readBoxes(record, &state.boxes);
+            break;
+        case RemoveBoxes: {
+            qint32 count, id;
+            record >> count;
+            for (int i = 0; i < count && record.status() == QDataStream::Ok; i++) {
+                record >> id;
+                state.boxes.remove(id);
+            }
+            break;
+        }
+        case SetClasses: {
+            qint32 count, id, classIndex;
+            record >> count;
+            for (int i = 0; i < count && record.status() == QDataStream::Ok; i++) {
+                record >> id >> classIndex;
+                if (state.boxes.contains(id))
+                    state.boxes[id].classIndex = classIndex;
+            }
+            break;
+        }
+        case MoveBox: {
+            qint32 id;
+            QRectF rect;
+            record >> id >> rect;
+            if (state.boxes.contains(id))
+                state.boxes[id].rect = rect;
+            break;
+        }
+        case Saved: {
+            QByteArray replacedHash;
+            record >> replacedHash >> state.savedHash;
+            state.knownHashes.insert(replacedHash);
+            state.knownHashes.insert(state.savedHash);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    int recovered = 0;
+    foreach (const ReplayFile &state, files) {
+        if (state.labelFile.isEmpty() || state.imageSize.isEmpty())
+            continue;
+
+        QByteArray current;
+        QFile file(state.labelFile);
+        bool exists = file.open(QIODevice::ReadOnly | QIODevice::Text);
+        if (exists)
+            current = file.readAll();
+
+        // the snapshot handed to the writer made it to disk
+        QByteArray currentHash = QCryptographicHash::hash(current, QCryptographicHash::Sha1);
+        if (!state.savedHash.isEmpty() && currentHash == state.savedHash)
+            continue;
+
+        QVector<YoloBox> labels;
+        labels.reserve(state.boxes.count());
+        foreach (const JournalBox &box, state.boxes) {
+            YoloBox label;
+            label.classIndex = box.classIndex;
+            label.x = float(box.rect.center().x() / state.imageSize.width());
+            label.y = float(box.rect.center().y() / state.imageSize.height());
+            label.width = float(box.rect.width() / state.imageSize.width());
+            label.height = float(box.rect.height() / state.imageSize.height());
+            labels.append(label);
+        }
+
+        QByteArray content = YoloLabel::serialize(labels) + state.rejectedLines;
+        if (content == current || (!exists && labels.isEmpty()))
+            continue;
+
+        // a file another program rewrote since is kept, the replayed boxes go next to it
+        if (!state.knownHashes.contains(currentHash)) {
+            qWarning() << state.labelFile << "was changed after its edits were journaled, they are kept in"
+                       << state.labelFile + ".conflict";
+            AnnotationWriter::instance()->write(state.labelFile + ".conflict", content);
+            (*conflicts)++;
+            continue;
+        }
+        AnnotationWriter::instance()->write(state.labelFile, content);
+        recovered++;
+    }
+
+    return recovered;
+}
+
+bool EditJournal::startFile(QFile *file, const QString &fileName)
+{
+    // a journal is only left behind when the last session did not shut down cleanly
+    int files = 0, conflicts = 0;
+    QFile previous(fileName);
+    if (previous.open(QIODevice::ReadOnly)) {
+        files = recover(previous.readAll(), &conflicts);
+        previous.close();
+    }
+
+    if (files > 0 || conflicts > 0) {
+        // the recovered label files must be on disk before the journal holding their edits goes
+        AnnotationWriter::instance()->flush();
+
+        QMutexLocker locker(&_mutex);
+        if (_isWriteFailed) {
+            qWarning() << "Edits could not be recovered, the journal is kept in" << fileName + ".bak";
+            QFile::remove(fileName + ".bak");
+            QFile::rename(fileName, fileName + ".bak");
+            _isWriteFailed = false;
+        }
+        locker.unlock();
+        emit recovered(files, conflicts);
+    }
+
+    QDir().mkpath(QFileInfo(fileName).path());
+    file->setFileName(fileName);
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate) || !writeHeader(file)) {
+        qWarning() << "Cannot open" << fileName << file->errorString();
+        return false;
+    }
+    return true;
+}
+
+bool EditJournal::writeHeader(QFile *file)
+{
+    QDataStream out(file);
+    out << JournalMagic << JournalVersion;
+    if (out.status() != QDataStream::Ok || !file->flush())
+        return false;
+    syncFile(file);
+    return true;
+}
+
+void EditJournal::run()
+{
+    QFile file;
+    forever {
+        QMutexLocker locker(&_mutex);
+        while (!_isQuitting && !_isClosing
+               && (_fileName.isEmpty() || (file.isOpen() && _buffer.isEmpty() && !_isCompacting)))
+            _queued.wait(&_mutex);
+
+        if (!_fileName.isEmpty() && !file.isOpen()) {
+            QString fileName = _fileName;
+            locker.unlock();
+
+            // replaying a left over journal rewrites label files, which is kept off the GUI thread
+            bool ok = startFile(&file, fileName);
+
+            locker.relock();
+            if (!ok) {
+                // edits still reach the label files, they are just not journaled
+                _fileName.clear();
+                _buffer.clear();
+                _isClosed = true;
+            }
+            continue;
+        }
+
+        // every edit journaled so far is in its label file, the journal starts over
+        if (_isCompacting && file.isOpen()) {
+            _isCompacting = false;
+            locker.unlock();
+
+            if (!file.resize(0) || !file.seek(0) || !writeHeader(&file))
+                qWarning() << "Cannot truncate" << file.fileName() << file.errorString();
+            continue;
+        }
+
+        // records appended while the last batch was written go out together
+        if (!_buffer.isEmpty() && file.isOpen()) {
+            QByteArray records;
+            records.swap(_buffer);
+            locker.unlock();
+
+            if (file.write(records) != records.size() || !file.flush())
+                qWarning() << "Cannot write" << file.fileName() << file.errorString();
+            syncFile(&file);
+            continue;
+        }
+
+        if (_isClosing) {
+            // every edit is in its label file, unless one of them could not be written
+            if (file.isOpen()) {
+                file.close();
+                if (!_isWriteFailed)
+                    file.remove();
+            }
+            _fileName.clear();
+            _buffer.clear();
+            _isClosing = false;
+            _isClosed = true;
+            _idle.wakeAll();
+            continue;
+        }
+        if (_isQuitting)
+            break;
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef EDITJOURNAL_H
+#define EDITJOURNAL_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QRectF>
+#include <QSet>
+#include <QSize>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+// a box as the journal records it, in image pixels
+struct JournalBox
+{
+    int id = 0;
+    int classIndex = 0;
+    QRectF rect;
+};
+
+/**
+ * @brief The EditJournal class appends every box edit to a journal file, so
+ *        edits that never reached a label file survive a crash.
+ *
+ * The first edit of a label file records the boxes it was loaded with as a
+ * baseline, the edits that follow are small binary records applied on top
+ * of it. A Saved record notes the content handed to the AnnotationWriter.
+ * Both record the hashes of the file contents they start from.
+ *
+ * Appending only copies the record into a buffer, a background thread
+ * writes the buffered records and syncs them to disk. On the next launch
+ * that thread replays a left over journal and rewrites every label file
+ * that does not match its replayed boxes, then the journal starts over. A
+ * label file whose content is none of the recorded ones was rewritten by
+ * another program, it is kept and the replayed boxes are written next to
+ * it, with a .conflict suffix.
+ *
+ * Once every label file edited has either had its last snapshot written
+ * by the AnnotationWriter or had its edits undone, the journal is
+ * truncated and the next edit of a file records a new baseline. A clean
+ * shutdown removes the journal.
+ */
+class EditJournal : public QThread
+{
+    Q_OBJECT
+public:
+    static EditJournal *instance();
+    ~EditJournal();
+
+    // the left over journal is replayed in the background, recovered() reports it
+    void open(const QString &fileName);
+    void close();
+
+    // edits refer to the label file by the number its baseline returned
+    // rejected lines are the ones of the label file that are not boxes, saved after them
+    int baseline(const QString &labelFile, const QSize &imageSize, const QByteArray &fileHash,
+                 const QVector<JournalBox> &boxes, const QByteArray &rejectedLines);
+    void addBoxes(int file, const QVector<JournalBox> &boxes);
+    void removeBoxes(int file, const QVector<int> &ids);
+    void setClasses(int file, const QVector<int> &ids, const QVector<int> &classIndexes);
+    void moveBox(int file, int id, const QRectF &rect);
+    void saved(int file, const QByteArray &replacedHash, const QByteArray &fileHash);
+    // the boxes are back to the content of fileHash without a new save, e.g. undone
+    void unchanged(int file, const QByteArray &fileHash);
+    // false once the journal was truncated, the file needs a new baseline
+    bool isBaselined(int file) const
+    {
+        return _baselined.contains(file);
+    }
+
+signals:
+    // label files rewritten, and label files kept because of a conflict
+    void recovered(int files, int conflicts);
+
+protected:
+    void run() override;
+
+private slots:
+    void onWriteFailed();
+    void onFileWritten(const QString &labelFile, const QByteArray &content);
+
+private:
+    enum RecordType : quint8 {
+        Baseline = 1,
+        AddBoxes,
+        RemoveBoxes,
+        SetClasses,
+        MoveBox,
+        Saved
+    };
+
+    EditJournal();
+    void append(RecordType type, const QByteArray &payload);
+    void edited(int file);
+    void confirmed(int file);
+    static int recover(const QByteArray &data, int *conflicts);
+    bool startFile(QFile *file, const QString &fileName);
+    static bool writeHeader(QFile *file);
+
+    mutable QMutex _mutex;
+    QWaitCondition _queued;
+    QWaitCondition _idle;
+    QString _fileName;
+    QByteArray _buffer;
+    bool _isWriteFailed = false;
+    bool _isCompacting = false;
+    bool _isClosing = false;
+    bool _isClosed = false;
+    bool _isQuitting = false;
+    // only used on the GUI thread: label files and their numbers, the files with a baseline in
+    // the journal, with edits their label file may not have yet, and the snapshots handed to the writer
+    QHash<QString, int> _files;
+    QSet<int> _baselined;
+    QSet<int> _unconfirmed;
+    QHash<int, QByteArray> _savedHashes;
+};
+
+#endif // EDITJOURNAL_H
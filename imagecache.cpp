@@ -0,0 +1,46 @@
+#include "imagecache.h"
+#include <climits>
+
+ImageCache::ImageCache(qint64 budgetBytes)
+{
+    setBudget(budgetBytes);
+}
+
+void ImageCache::setBudget(qint64 budgetBytes)
+{
+    _cache.setMaxCost(int(qBound<qint64>(0, budgetBytes / 1024, INT_MAX)));
+}
+
+bool ImageCache::lookup(const QString &path, ImagePyramid *image)
+{
+    ImagePyramid *cached = _cache.object(path);
+    if (cached == nullptr) {
+        _misses++;
+        return false;
+    }
+
+    _hits++;
+    *image = *cached;
+    return true;
+}
+
+void ImageCache::insert(const QString &path, const ImagePyramid &image)
+{
+    if (image.isNull())
+        return;
+
+    // QCache drops images larger than the whole budget by itself
+    int cost = int(qMax<qint64>(1, image.sizeInBytes() / 1024));
+    _cache.insert(path, new ImagePyramid(image), cost);
+}
+
+void ImageCache::clear()
+{
+    _cache.clear();
+}
+
+void ImageCache::resetCounters()
+{
+    _hits = 0;
+    _misses = 0;
+}
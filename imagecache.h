@@ -0,0 +1,52 @@
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <QCache>
+#include "imagepyramid.h"
+#include <QString>
+
+/**
+ * @brief The ImageCache class keeps recently decoded images in an LRU
+ *        bounded by their size in memory, mipmap levels included.
+ */
+class ImageCache
+{
+public:
+    ImageCache(qint64 budgetBytes = 0);
+
+    void setBudget(qint64 budgetBytes);
+    qint64 budget() const
+    {
+        return qint64(_cache.maxCost()) * 1024;
+    }
+    qint64 bytes() const
+    {
+        return qint64(_cache.totalCost()) * 1024;
+    }
+
+    bool lookup(const QString &path, ImagePyramid *image);
+    bool contains(const QString &path) const
+    {
+        return _cache.contains(path);
+    }
+    void insert(const QString &path, const ImagePyramid &image);
+    void clear();
+
+    int hits() const
+    {
+        return _hits;
+    }
+    int misses() const
+    {
+        return _misses;
+    }
+    void resetCounters();
+
+private:
+    // costs are kept in KiB so that budgets above 2 GiB fit in an int
+    QCache<QString, ImagePyramid> _cache;
+    int _hits = 0;
+    int _misses = 0;
+};
+
+#endif // IMAGECACHE_H
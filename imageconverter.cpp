@@ -0,0 +1,154 @@
+#include "imageconverter.h"
+#include "pixelconverter.h"
+#include <QVector>
+
+QImage ImageConverter::toQImage(FIBITMAP *dib)
+{
+    if (dib == nullptr)
+        return QImage();
+
+    FIBITMAP *converted = nullptr;
+    if (FreeImage_GetImageType(dib) == FIT_BITMAP) {
+        switch (FreeImage_GetBPP(dib)) {
+        case 8:
+            return fromPalette(dib);
+        case 24:
+            return fromBGR24(dib);
+        case 32:
+#if FREEIMAGE_COLORORDER == FREEIMAGE_COLORORDER_BGR
+            // BGRA in memory is 0xAARRGGBB on little endian, which is what Qt uses
+            return wrap(dib, FreeImage_IsTransparent(dib) ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+#else
+            converted = FreeImage_ConvertTo24Bits(dib);
+            break;
+#endif
+        case 1:
+        case 4:
+            converted = FreeImage_ConvertTo8Bits(dib);
+            break;
+        default:
+            // 16-bit 555/565 bitmaps
+            converted = FreeImage_ConvertTo24Bits(dib);
+            break;
+        }
+    } else {
+        switch (FreeImage_GetImageType(dib)) {
+        case FIT_UINT16:
+            return fromGray16(dib);
+        case FIT_RGB16:
+            // FreeImage_ConvertToStandardType only knows single channel types
+            converted = FreeImage_ConvertTo24Bits(dib);
+            break;
+        case FIT_RGBA16:
+            converted = FreeImage_ConvertTo32Bits(dib);
+            break;
+        case FIT_RGBF:
+        case FIT_RGBAF:
+            // HDR colors are tone mapped, a linear scale would leave most of them black
+            converted = FreeImage_ToneMapping(dib, FITMO_DRAGO03, 0, 0);
+            break;
+        default:
+            // other integer, float and complex samples are scaled linearly down to 8 bits
+            converted = FreeImage_ConvertToStandardType(dib, TRUE);
+            break;
+        }
+    }
+    FreeImage_Unload(dib);
+
+    return toQImage(converted);
+}
+
+QImage ImageConverter::wrap(FIBITMAP *dib, QImage::Format format)
+{
+    // FreeImage stores scanlines bottom-up, QImage expects them top-down
+    FreeImage_FlipVertical(dib);
+    QImage image(FreeImage_GetBits(dib),
+                 FreeImage_GetWidth(dib), FreeImage_GetHeight(dib),
+                 FreeImage_GetPitch(dib), format,
+                 ImageConverter::cleanup, dib);
+    if (image.isNull())
+        FreeImage_Unload(dib);
+
+    return image;
+}
+
+QImage ImageConverter::fromPalette(FIBITMAP *dib)
+{
+    bool transparent = FreeImage_IsTransparent(dib);
+    if (!transparent && FreeImage_GetColorType(dib) == FIC_MINISBLACK)
+        return wrap(dib, QImage::Format_Grayscale8);
+
+    RGBQUAD *palette = FreeImage_GetPalette(dib);
+    int colorCount = FreeImage_GetColorsUsed(dib);
+    BYTE *alphaTable = transparent ? FreeImage_GetTransparencyTable(dib) : nullptr;
+    int alphaCount = transparent ? FreeImage_GetTransparencyCount(dib) : 0;
+
+    QVector<QRgb> colorTable(colorCount);
+    for (int i = 0; i < colorCount; i++) {
+        int alpha = (alphaTable && i < alphaCount) ? alphaTable[i] : 255;
+        colorTable[i] = qRgba(palette[i].rgbRed, palette[i].rgbGreen, palette[i].rgbBlue, alpha);
+    }
+
+    QImage image = wrap(dib, QImage::Format_Indexed8);
+    image.setColorTable(colorTable);
+
+    return image;
+}
+
+QImage ImageConverter::fromBGR24(FIBITMAP *dib)
+{
+    int width = FreeImage_GetWidth(dib);
+    int height = FreeImage_GetHeight(dib);
+
+    QImage image(width, height, QImage::Format_RGB32);
+    if (!image.isNull()) {
+        uchar *bits = image.bits();
+        int bytesPerLine = image.bytesPerLine();
+        for (int y = 0; y < height; y++) {
+            const BYTE *src = FreeImage_GetScanLine(dib, height - 1 - y);
+            QRgb *dst = reinterpret_cast<QRgb *>(bits + y * bytesPerLine);
+#if FREEIMAGE_COLORORDER == FREEIMAGE_COLORORDER_BGR
+            PixelConverter::bgr24ToRgb32(src, dst, width);
+#else
+            for (int x = 0; x < width; x++, src += 3) {
+                dst[x] = qRgb(src[FI_RGBA_RED], src[FI_RGBA_GREEN], src[FI_RGBA_BLUE]);
+            }
+#endif
+        }
+    }
+    FreeImage_Unload(dib);
+
+    return image;
+}
+
+QImage ImageConverter::fromGray16(FIBITMAP *dib)
+{
+    int width = FreeImage_GetWidth(dib);
+    int height = FreeImage_GetHeight(dib);
+
+    // stretch the used range linearly over 8 bits, like FreeImage_ConvertToStandardType
+    quint16 min = 0xffff, max = 0;
+    for (int y = 0; y < height; y++) {
+        quint16 rowMin, rowMax;
+        PixelConverter::minMax16(reinterpret_cast<const quint16 *>(FreeImage_GetScanLine(dib, y)), width,
+                                 &rowMin, &rowMax);
+        min = qMin(min, rowMin);
+        max = qMax(max, rowMax);
+    }
+
+    QImage image(width, height, QImage::Format_Grayscale8);
+    if (!image.isNull()) {
+        for (int y = 0; y < height; y++) {
+            const quint16 *src = reinterpret_cast<const quint16 *>(FreeImage_GetScanLine(dib, height - 1 - y));
+            PixelConverter::scale16To8(src, image.scanLine(y), width, min, max);
+        }
+    }
+    FreeImage_Unload(dib);
+
+    return image;
+}
+
+void ImageConverter::cleanup(void *info)
+{
+    FreeImage_Unload(static_cast<FIBITMAP *>(info));
+}
@@ -0,0 +1,29 @@
+#ifndef IMAGECONVERTER_H
+#define IMAGECONVERTER_H
+
+#include <QImage>
+#include "FreeImage.h"
+
+/**
+ * @brief The ImageConverter class turns a decoded FIBITMAP into a QImage
+ *        without going through an intermediate encoder.
+ *
+ * 8-bit and 32-bit bitmaps are flipped in place and wrapped by the QImage,
+ * which then owns the FIBITMAP and unloads it when the last copy goes away.
+ * Every other layout is converted scanline by scanline into a Qt format.
+ */
+class ImageConverter
+{
+public:
+    // Takes ownership of dib, it must not be used after this call.
+    static QImage toQImage(FIBITMAP *dib);
+
+private:
+    static QImage wrap(FIBITMAP *dib, QImage::Format format);
+    static QImage fromPalette(FIBITMAP *dib);
+    static QImage fromBGR24(FIBITMAP *dib);
+    static QImage fromGray16(FIBITMAP *dib);
+    static void cleanup(void *info);
+};
+
+#endif // IMAGECONVERTER_H
@@ -0,0 +1,287 @@
+#include "imagedecoder.h"
+#include "imageconverter.h"
+#include "loadprofiler.h"
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QSettings>
+#include <climits>
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#endif
+
+bool FreeImageDecoder::canDecode(const QString &suffix) const
+{
+    FREE_IMAGE_FORMAT fif = FreeImage_GetFIFFromFilename(QString("x." + suffix).toLatin1());
+    return fif != FIF_UNKNOWN && FreeImage_FIFSupportsReading(fif);
+}
+
+QImage FreeImageDecoder::decode(const QString &path, int maxSize, QSize *imageSize, SampleImage *samples) const
+{
+    QByteArray fileName = path.toLocal8Bit();
+
+    // decode straight from a mapping of the file instead of FreeImage's stdio
+    // reads, files that cannot be mapped go through FreeImage_Load
+    QFile file(path);
+    uchar *data = nullptr;
+    qint64 fileSize = 0;
+    {
+        // pages faulted in during the decode count towards the decode stage
+        LoadTimer timer("read");
+        if (mapFiles() && file.open(QIODevice::ReadOnly)) {
+            fileSize = file.size();
+            if (fileSize > 0 && fileSize <= 0xffffffffLL)
+                data = file.map(0, fileSize);
+        }
+#ifdef Q_OS_UNIX
+        if (data != nullptr) {
+            // decoders read front to back, start the readahead right away
+            madvise(data, size_t(fileSize), MADV_SEQUENTIAL);
+            madvise(data, size_t(fileSize), MADV_WILLNEED);
+        }
+#endif
+    }
+    FIMEMORY *memory = data != nullptr ? FreeImage_OpenMemory(data, DWORD(fileSize)) : nullptr;
+
+    // Get image format
+    FREE_IMAGE_FORMAT fif = memory != nullptr ? FreeImage_GetFileTypeFromMemory(memory, 0)
+                                              : FreeImage_GetFileType(fileName, 0);
+    if (fif == FIF_UNKNOWN)
+        fif = FreeImage_GetFIFFromFilename(fileName);
+    if (fif == FIF_UNKNOWN || !FreeImage_FIFSupportsReading(fif)) {
+        if (memory != nullptr)
+            FreeImage_CloseMemory(memory);
+        return QImage();
+    }
+
+    // libjpeg can scale by 1/2, 1/4 or 1/8 while decoding, FreeImage takes
+    // the requested size in the upper 16 bits of the flags
+    int flags = 0;
+    QSize size;
+    FIBITMAP *dib = nullptr;
+    {
+        LoadTimer timer("decode");
+        if (maxSize > 0 && fif == FIF_JPEG) {
+            FIBITMAP *header = loadBitmap(fif, fileName, memory, FIF_LOAD_NOPIXELS);
+            if (header != nullptr) {
+                size = QSize(FreeImage_GetWidth(header), FreeImage_GetHeight(header));
+                FreeImage_Unload(header);
+                if (qMax(size.width(), size.height()) >= 2 * maxSize)
+                    flags = qMin(maxSize, 0xffff) << 16;
+            }
+        }
+
+        // Load image if possible
+        dib = loadBitmap(fif, fileName, memory, flags);
+    }
+    if (memory != nullptr)
+        FreeImage_CloseMemory(memory);
+    if (dib == nullptr)
+        return QImage();
+
+    if (flags == 0)
+        size = QSize(FreeImage_GetWidth(dib), FreeImage_GetHeight(dib));
+    if (imageSize)
+        *imageSize = size;
+
+    LoadTimer timer("convert");
+    // keep 16-bit and float samples for windowing, the QImage is only a default rendering
+    if (samples && SampleImage::hasHighDepth(dib))
+        *samples = SampleImage::fromBitmap(dib);
+
+    return ImageConverter::toQImage(dib);
+}
+
+FIBITMAP *FreeImageDecoder::loadBitmap(FREE_IMAGE_FORMAT fif, const QByteArray &fileName,
+                                       FIMEMORY *memory, int flags)
+{
+    if (memory == nullptr)
+        return FreeImage_Load(fif, fileName, flags);
+
+    // the header load leaves the stream at its end
+    FreeImage_SeekMemory(memory, 0, SEEK_SET);
+    return FreeImage_LoadFromMemory(fif, memory, flags);
+}
+
+bool QtImageDecoder::canDecode(const QString &suffix) const
+{
+    return QImageReader::supportedImageFormats().contains(suffix.toLatin1());
+}
+
+QImage QtImageDecoder::decode(const QString &path, int maxSize, QSize *imageSize, SampleImage *samples) const
+{
+    Q_UNUSED(samples);
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QImage();
+
+    // read from a mapping of the file like the FreeImage backend does
+    uchar *data = nullptr;
+    {
+        LoadTimer timer("read");
+        if (mapFiles() && file.size() > 0 && file.size() <= INT_MAX)
+            data = file.map(0, file.size());
+    }
+    QByteArray bytes;
+    if (data != nullptr)
+        bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data), int(file.size()));
+    QBuffer buffer(&bytes);
+    QImageReader reader;
+    if (data != nullptr)
+        reader.setDevice(&buffer);
+    else
+        reader.setDevice(&file);
+    // FreeImage does not apply the EXIF orientation either, box coordinates must not change
+    reader.setAutoTransform(false);
+
+    // the JPEG plugin scales in the DCT when the scaled size is small enough
+    QSize size = reader.size();
+    if (maxSize > 0 && size.isValid() && qMax(size.width(), size.height()) >= 2 * maxSize
+            && reader.supportsOption(QImageIOHandler::ScaledSize))
+        reader.setScaledSize(size.scaled(maxSize, maxSize, Qt::KeepAspectRatio));
+
+    QImage image;
+    {
+        LoadTimer timer("decode");
+        image = reader.read();
+    }
+    if (image.isNull())
+        return image;
+    if (imageSize)
+        *imageSize = size.isValid() ? size : image.size();
+
+    return image;
+}
+
+DecoderRegistry::DecoderRegistry()
+{
+    QSettings settings;
+    settings.beginGroup("decoders");
+    foreach (QString suffix, settings.childKeys()) {
+        _overrides.insert(suffix.toLower(), settings.value(suffix).toString());
+    }
+    settings.endGroup();
+    bool mapFiles = settings.value("decode/mapFiles", true).toBool();
+
+    // FreeImage comes first and decodes everything nobody else is preferred for
+    registerDecoder(new FreeImageDecoder(mapFiles));
+    registerDecoder(new QtImageDecoder(mapFiles), QStringList() << "jpg" << "jpeg");
+}
+
+DecoderRegistry::~DecoderRegistry()
+{
+    qDeleteAll(_decoders);
+}
+
+DecoderRegistry *DecoderRegistry::instance()
+{
+    static DecoderRegistry registry;
+    return &registry;
+}
+
+void DecoderRegistry::registerDecoder(ImageDecoder *decoder, const QStringList &preferredFormats)
+{
+    _decoders.append(decoder);
+    foreach (QString suffix, preferredFormats) {
+        _preferred.insert(suffix.toLower(), decoder);
+    }
+}
+
+ImageDecoder *DecoderRegistry::decoder(const QString &name) const
+{
+    foreach (ImageDecoder *decoder, _decoders) {
+        if (decoder->name() == name)
+            return decoder;
+    }
+
+    return nullptr;
+}
+
+ImageDecoder *DecoderRegistry::decoderFor(const QString &path) const
+{
+    QString suffix = QFileInfo(path).suffix().toLower();
+    ImageDecoder *chosen = decoder(_overrides.value(suffix));
+    if (chosen != nullptr && chosen->canDecode(suffix))
+        return chosen;
+
+    return _preferred.value(suffix, _decoders.first());
+}
+
+QImage DecoderRegistry::decode(const QString &path, int maxSize, QSize *imageSize, SampleImage *samples) const
+{
+    ImageDecoder *chosen = decoderFor(path);
+    QImage image = chosen->decode(path, maxSize, imageSize, samples);
+
+    // files the preferred backend rejects still get a try with FreeImage
+    if (image.isNull() && chosen != _decoders.first())
+        image = _decoders.first()->decode(path, maxSize, imageSize, samples);
+
+    return image;
+}
+
+QVector<DecoderStats> DecoderRegistry::benchmark(const QStringList &paths, QObject *progress,
+                                                const QAtomicInt *isCanceled) const
+{
+    // read every file once so that no backend pays for a cold page cache
+    foreach (QString path, paths) {
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly))
+            file.readAll();
+    }
+
+    // the benchmark decodes are not image switches, keep them out of the profile
+    LoadProfiler::setRecording(false);
+
+    QVector<DecoderStats> results;
+    int step = 0;
+    foreach (ImageDecoder *decoder, _decoders) {
+        results.append(benchmarkDecoder(decoder, paths, progress, isCanceled, &step));
+
+        // and the other way of reading the files, the setting only picks one of them
+        ImageDecoder *other = decoder->create(!decoder->mapFiles());
+        if (other != nullptr)
+            results.append(benchmarkDecoder(other, paths, progress, isCanceled, &step));
+        else
+            step += paths.count();
+        delete other;
+    }
+
+    LoadProfiler::setRecording(true);
+
+    return results;
+}
+
+DecoderStats DecoderRegistry::benchmarkDecoder(const ImageDecoder *decoder, const QStringList &paths,
+                                               QObject *progress, const QAtomicInt *isCanceled, int *step)
+{
+    DecoderStats stats;
+    stats.decoder = decoder->name();
+    stats.isMapped = decoder->mapFiles();
+    QElapsedTimer timer;
+    foreach (QString path, paths) {
+        if (isCanceled && isCanceled->loadAcquire())
+            break;
+        if (progress)
+            QMetaObject::invokeMethod(progress, "setValue", Qt::QueuedConnection, Q_ARG(int, (*step)++));
+
+        QFileInfo info(path);
+        if (!decoder->canDecode(info.suffix().toLower()))
+            continue;
+
+        timer.start();
+        QImage image = decoder->decode(path, 0, nullptr, nullptr);
+        qint64 elapsed = timer.nsecsElapsed();
+        if (image.isNull()) {
+            stats.failures++;
+            continue;
+        }
+        stats.images++;
+        stats.bytes += info.size();
+        stats.nsecs += elapsed;
+    }
+
+    return stats;
+}
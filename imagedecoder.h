@@ -0,0 +1,163 @@
+#ifndef IMAGEDECODER_H
+#define IMAGEDECODER_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "FreeImage.h"
+#include "sampleimage.h"
+
+/**
+ * @brief The ImageDecoder class is the interface of a decoding backend.
+ *
+ * decode() may be called from several worker threads at once. When maxSize
+ * is set the backend may return a reduced image whose longest side is at
+ * least maxSize, imageSize then receives the full size.
+ */
+class ImageDecoder
+{
+public:
+    virtual ~ImageDecoder()
+    {
+    }
+
+    virtual QString name() const = 0;
+    virtual bool canDecode(const QString &suffix) const = 0;
+    virtual QImage decode(const QString &path, int maxSize, QSize *imageSize,
+                          SampleImage *samples) const = 0;
+
+    // Whether files are decoded from a memory mapping or read through the backend's own file I/O.
+    bool mapFiles() const
+    {
+        return _mapFiles;
+    }
+    // A new backend of the same kind reading its files the given way, null if it cannot.
+    virtual ImageDecoder *create(bool mapFiles) const
+    {
+        Q_UNUSED(mapFiles);
+        return nullptr;
+    }
+
+protected:
+    explicit ImageDecoder(bool mapFiles):
+        _mapFiles(mapFiles)
+    {
+    }
+
+private:
+    const bool _mapFiles;
+};
+
+/**
+ * @brief The FreeImageDecoder class decodes every format FreeImage reads,
+ *        from a memory mapping of the file where possible.
+ */
+class FreeImageDecoder : public ImageDecoder
+{
+public:
+    explicit FreeImageDecoder(bool mapFiles = true):
+        ImageDecoder(mapFiles)
+    {
+    }
+
+    QString name() const override
+    {
+        return "freeimage";
+    }
+    bool canDecode(const QString &suffix) const override;
+    QImage decode(const QString &path, int maxSize, QSize *imageSize,
+                  SampleImage *samples) const override;
+    ImageDecoder *create(bool mapFiles) const override
+    {
+        return new FreeImageDecoder(mapFiles);
+    }
+
+private:
+    static FIBITMAP *loadBitmap(FREE_IMAGE_FORMAT fif, const QByteArray &fileName,
+                                FIMEMORY *memory, int flags);
+};
+
+/**
+ * @brief The QtImageDecoder class decodes through QImageReader and the Qt
+ *        image format plugins, which are faster for baseline JPEG.
+ */
+class QtImageDecoder : public ImageDecoder
+{
+public:
+    explicit QtImageDecoder(bool mapFiles = true):
+        ImageDecoder(mapFiles)
+    {
+    }
+
+    QString name() const override
+    {
+        return "qt";
+    }
+    bool canDecode(const QString &suffix) const override;
+    QImage decode(const QString &path, int maxSize, QSize *imageSize,
+                  SampleImage *samples) const override;
+};
+
+struct DecoderStats
+{
+    QString decoder;
+    bool isMapped = false;
+    int images = 0;
+    int failures = 0;
+    qint64 bytes = 0;
+    qint64 nsecs = 0;
+};
+
+/**
+ * @brief The DecoderRegistry class picks the decoding backend of a file
+ *        by its suffix.
+ *
+ * Backends register the formats they are preferred for, the first backend
+ * registered handles every other format it can decode. The choice can be
+ * overridden per suffix with the "decoders/<suffix>" setting naming a
+ * backend, e.g. decoders/jpg=freeimage. Backends decode from a memory
+ * mapping of the file unless the "decode/mapFiles" setting is turned off.
+ */
+class DecoderRegistry
+{
+public:
+    static DecoderRegistry *instance();
+    ~DecoderRegistry();
+
+    void registerDecoder(ImageDecoder *decoder, const QStringList &preferredFormats = QStringList());
+    QList<ImageDecoder *> decoders() const
+    {
+        return _decoders;
+    }
+    ImageDecoder *decoder(const QString &name) const;
+    ImageDecoder *decoderFor(const QString &path) const;
+
+    QImage decode(const QString &path, int maxSize = 0, QSize *imageSize = nullptr,
+                  SampleImage *samples = nullptr) const;
+    // Every backend is measured reading its files both ways where it can.
+    // May run on a worker thread: progress receives setValue(int) queued with
+    // the number of decodes done out of benchmarkSteps(paths.count()), and
+    // the run stops early once isCanceled is set.
+    QVector<DecoderStats> benchmark(const QStringList &paths, QObject *progress = nullptr,
+                                    const QAtomicInt *isCanceled = nullptr) const;
+    int benchmarkSteps(int pathCount) const
+    {
+        return 2 * _decoders.count() * pathCount;
+    }
+
+private:
+    DecoderRegistry();
+    static DecoderStats benchmarkDecoder(const ImageDecoder *decoder, const QStringList &paths,
+                                         QObject *progress, const QAtomicInt *isCanceled, int *step);
+
+    QList<ImageDecoder *> _decoders;
+    QHash<QString, ImageDecoder *> _preferred;
+    QHash<QString, QString> _overrides;
+};
+
+#endif // IMAGEDECODER_H
@@ -0,0 +1,39 @@
+#include "imageitem.h"
+#include "loadprofiler.h"
+#include <QPainter>
+
+ImageItem::ImageItem(const ImagePyramid &pyramid, QGraphicsItem *parent):
+    QGraphicsPixmapItem(parent)
+{
+    setTransformationMode(Qt::SmoothTransformation);
+    setPyramid(pyramid);
+}
+
+void ImageItem::setPyramid(const ImagePyramid &pyramid)
+{
+    _pyramid = pyramid;
+    _levels.fill(QPixmap(), pyramid.levelCount());
+
+    LoadTimer timer("upload");
+    setPixmap(QPixmap::fromImage(pyramid.image()));
+}
+
+void ImageItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    // the item transform is part of the world transform, so the scale is
+    // relative to the pixels of level 0
+    qreal scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    int level = _pyramid.levelForScale(scale);
+    if (level == 0) {
+        QGraphicsPixmapItem::paint(painter, option, widget);
+        return;
+    }
+
+    if (_levels.at(level).isNull())
+        _levels[level] = QPixmap::fromImage(_pyramid.level(level));
+
+    // a reduced level is stretched over the area of level 0
+    const QPixmap &pixmap = _levels.at(level);
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+    painter->drawPixmap(QRectF(offset(), this->pixmap().size()), pixmap, QRectF(pixmap.rect()));
+}
@@ -0,0 +1,28 @@
+#ifndef IMAGEITEM_H
+#define IMAGEITEM_H
+
+#include <QGraphicsPixmapItem>
+#include <QStyleOptionGraphicsItem>
+#include <QVector>
+#include "imagepyramid.h"
+
+/**
+ * @brief The ImageItem class paints an ImagePyramid, using the level
+ *        matching the view scale when zoomed out.
+ *
+ * Levels are converted to pixmaps the first time they are painted.
+ */
+class ImageItem : public QGraphicsPixmapItem
+{
+public:
+    ImageItem(const ImagePyramid &pyramid, QGraphicsItem *parent = 0);
+
+    void setPyramid(const ImagePyramid &pyramid);
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    ImagePyramid _pyramid;
+    QVector<QPixmap> _levels;
+};
+
+#endif // IMAGEITEM_H
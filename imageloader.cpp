@@ -0,0 +1,186 @@
+#include "imageloader.h"
+#include "imagedecoder.h"
+#include "loadprofiler.h"
+#include "multipageimage.h"
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSettings>
+#include <QThread>
+
+class ImageLoadTask : public QRunnable
+{
+public:
+    ImageLoadTask(ImageLoader *loader, int serial, const QString &path, int previewSize):
+        _loader(loader),
+        _serial(serial),
+        _path(path),
+        _previewSize(previewSize)
+    {
+    }
+
+    void run() override
+    {
+        // skip requests that were overtaken while waiting in the queue
+        if (!_loader->isCurrent(_serial))
+            return;
+
+        // a running prefetch of the same file delivers it instead; load tasks are
+        // not registered themselves, an overtaken one delivers nothing and must
+        // not keep a new load of its file from starting
+        if (_loader->isDecoding(_path))
+            return;
+
+        QImage image;
+        SampleImage samples;
+        if (_previewSize > 0) {
+            QSize imageSize;
+            QImage preview = ImageLoader::decode(_path, _previewSize, &imageSize, &samples);
+            if (preview.size() == imageSize) {
+                // the format cannot be decoded at a reduced scale
+                image = preview;
+            } else if (!preview.isNull() && _loader->isCurrent(_serial)) {
+                emit _loader->previewLoaded(_serial, _path, preview, imageSize);
+            }
+        }
+        if (image.isNull() && _loader->isCurrent(_serial))
+            image = ImageLoader::decode(_path, 0, nullptr, &samples);
+
+        // and results that were overtaken while decoding
+        if (_loader->isCurrent(_serial)) {
+            ImagePyramid pyramid = ImageLoader::pyramid(_path, image, _loader->_pyramidCacheDir);
+            pyramid.setSamples(samples);
+            pyramid.setPageCount(MultiPageImage::pageCount(_path));
+            emit _loader->imageLoaded(_serial, _path, pyramid);
+        }
+    }
+
+private:
+    ImageLoader *_loader;
+    int _serial;
+    QString _path;
+    int _previewSize;
+};
+
+class ImagePrefetchTask : public QRunnable
+{
+public:
+    ImagePrefetchTask(ImageLoader *loader, int serial, const QString &path):
+        _loader(loader),
+        _serial(serial),
+        _path(path)
+    {
+    }
+
+    void run() override
+    {
+        if (_serial != _loader->_prefetchSerial.load())
+            return;
+        if (!_loader->beginDecode(_path))
+            return;
+
+        SampleImage samples;
+        QImage image = ImageLoader::decode(_path, 0, nullptr, &samples);
+        _loader->endDecode(_path);
+
+        ImagePyramid pyramid = ImageLoader::pyramid(_path, image, _loader->_pyramidCacheDir);
+        pyramid.setSamples(samples);
+        pyramid.setPageCount(MultiPageImage::pageCount(_path));
+        emit _loader->imagePrefetched(_path, pyramid);
+    }
+
+private:
+    ImageLoader *_loader;
+    int _serial;
+    QString _path;
+};
+
+ImageLoader::ImageLoader(QObject *parent):
+    QObject(parent),
+    _serial(0),
+    _prefetchSerial(0)
+{
+    qRegisterMetaType<ImagePyramid>("ImagePyramid");
+    _pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+
+    QSettings settings;
+    _pyramidCacheDir = settings.value("pyramid/cacheDir").toString();
+}
+
+ImageLoader::~ImageLoader()
+{
+    cancel();
+    _pool.waitForDone();
+}
+
+int ImageLoader::load(const QString &path, int previewSize)
+{
+    int serial = _serial.fetchAndAddOrdered(1) + 1;
+    _pool.clear();
+    _pool.start(new ImageLoadTask(this, serial, path, previewSize), 1);
+
+    return serial;
+}
+
+void ImageLoader::prefetch(const QStringList &paths)
+{
+    int serial = _prefetchSerial.fetchAndAddOrdered(1) + 1;
+    foreach (QString path, paths) {
+        _pool.start(new ImagePrefetchTask(this, serial, path), 0);
+    }
+}
+
+void ImageLoader::cancel()
+{
+    _serial.fetchAndAddOrdered(1);
+    _prefetchSerial.fetchAndAddOrdered(1);
+    _pool.clear();
+}
+
+bool ImageLoader::isDecoding(const QString &path) const
+{
+    QMutexLocker locker(&_mutex);
+    return _decoding.contains(path);
+}
+
+bool ImageLoader::beginDecode(const QString &path)
+{
+    QMutexLocker locker(&_mutex);
+    if (_decoding.contains(path))
+        return false;
+
+    _decoding.insert(path);
+    return true;
+}
+
+void ImageLoader::endDecode(const QString &path)
+{
+    QMutexLocker locker(&_mutex);
+    _decoding.remove(path);
+}
+
+QImage ImageLoader::decode(const QString &path, int maxSize, QSize *imageSize, SampleImage *samples)
+{
+    // the backend is picked by format, see DecoderRegistry
+    return DecoderRegistry::instance()->decode(path, maxSize, imageSize, samples);
+}
+
+ImagePyramid ImageLoader::pyramid(const QString &path, const QImage &image, const QString &cacheDir)
+{
+    if (image.isNull())
+        return ImagePyramid();
+
+    LoadTimer timer("pyramid");
+    if (cacheDir.isEmpty())
+        return ImagePyramid::build(image);
+
+    QString cacheFile = ImagePyramid::cacheFileName(cacheDir, path);
+    ImagePyramid pyramid(image);
+    if (pyramid.loadLevels(cacheFile))
+        return pyramid;
+
+    pyramid = ImagePyramid::build(image);
+    if (pyramid.levelCount() > 1)
+        pyramid.saveLevels(cacheFile);
+
+    return pyramid;
+}
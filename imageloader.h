@@ -0,0 +1,76 @@
+#ifndef IMAGELOADER_H
+#define IMAGELOADER_H
+
+#include <QObject>
+#include <QImage>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QSet>
+#include "imagepyramid.h"
+
+/**
+ * @brief The ImageLoader class decodes images on a worker pool and hands
+ *        the results back to the GUI thread through imageLoaded().
+ *
+ * Every call to load() starts a new request serial. Requests that have not
+ * started yet are dropped from the pool, and results of requests that were
+ * overtaken while decoding are discarded instead of being emitted.
+ *
+ * When load() is given a preview size, JPEG files are first decoded at a
+ * reduced scale by libjpeg and delivered through previewLoaded(), followed
+ * by the full resolution image through imageLoaded().
+ *
+ * Files are decoded by the backend DecoderRegistry picks for their format,
+ * from a memory mapping unless the "decode/mapFiles" setting is turned off.
+ *
+ * Full resolution images are delivered as an ImagePyramid, along with the
+ * original samples of 16-bit and float images. When the "pyramid/cacheDir"
+ * setting names a directory, the reduced levels are read from and written
+ * to a sidecar file there instead of being rebuilt.
+ *
+ * prefetch() queues low priority decodes whose results are delivered
+ * through imagePrefetched(); a newer prefetch() makes older queued ones stale.
+ */
+class ImageLoader : public QObject
+{
+    Q_OBJECT
+public:
+    ImageLoader(QObject *parent = 0);
+    ~ImageLoader();
+
+    int load(const QString &path, int previewSize = 0);
+    void prefetch(const QStringList &paths);
+    void cancel();
+    bool isCurrent(int serial) const
+    {
+        return serial == _serial.load();
+    }
+    // Whether a prefetch is decoding path, its result arrives through imagePrefetched().
+    bool isDecoding(const QString &path) const;
+
+    static QImage decode(const QString &path, int maxSize = 0, QSize *imageSize = nullptr,
+                         SampleImage *samples = nullptr);
+    static ImagePyramid pyramid(const QString &path, const QImage &image, const QString &cacheDir);
+
+signals:
+    void previewLoaded(int serial, QString path, QImage preview, QSize imageSize);
+    void imageLoaded(int serial, QString path, ImagePyramid image);
+    void imagePrefetched(QString path, ImagePyramid image);
+
+private:
+    friend class ImageLoadTask;
+    friend class ImagePrefetchTask;
+
+    bool beginDecode(const QString &path);
+    void endDecode(const QString &path);
+
+    QThreadPool _pool;
+    QAtomicInt _serial;
+    QAtomicInt _prefetchSerial;
+    mutable QMutex _mutex;
+    QSet<QString> _decoding;
+    QString _pyramidCacheDir;
+};
+
+#endif // IMAGELOADER_H
@@ -0,0 +1,83 @@
+#include "imageprobe.h"
+#include "FreeImage.h"
+#include <QImageReader>
+#include <QtConcurrent>
+
+static int countPages(FREE_IMAGE_FORMAT fif, const QByteArray &fileName)
+{
+    // only the container formats have to walk their page directory
+    int pageCount = 1;
+    if (fif == FIF_TIFF || fif == FIF_GIF || fif == FIF_ICO) {
+        FIMULTIBITMAP *multi = FreeImage_OpenMultiBitmap(fif, fileName, FALSE, TRUE, TRUE, FIF_LOAD_NOPIXELS);
+        if (multi != nullptr) {
+            pageCount = qMax(1, FreeImage_GetPageCount(multi));
+            FreeImage_CloseMultiBitmap(multi);
+        }
+    }
+
+    return pageCount;
+}
+
+static ImageInfo readHeader(const QString &path, const QByteArray &fileName, FREE_IMAGE_FORMAT *format)
+{
+    ImageInfo info;
+    info.path = path;
+
+    FREE_IMAGE_FORMAT fif = FreeImage_GetFileType(fileName, 0);
+    if (fif == FIF_UNKNOWN)
+        fif = FreeImage_GetFIFFromFilename(fileName);
+    *format = fif;
+
+    if (fif != FIF_UNKNOWN && FreeImage_FIFSupportsNoPixels(fif)) {
+        FIBITMAP *header = FreeImage_Load(fif, fileName, FIF_LOAD_NOPIXELS);
+        if (header != nullptr) {
+            info.size = QSize(FreeImage_GetWidth(header), FreeImage_GetHeight(header));
+            info.bitsPerPixel = FreeImage_GetBPP(header);
+            FreeImage_Unload(header);
+        }
+    }
+    if (!info.isValid()) {
+        QImageReader reader(path);
+        info.size = reader.size();
+        if (!info.isValid())
+            return info;
+        info.bitsPerPixel = reader.imageFormat() != QImage::Format_Invalid
+                ? QImage::toPixelFormat(reader.imageFormat()).bitsPerPixel() : 0;
+    }
+
+    return info;
+}
+
+ImageInfo ImageProbe::probe(const QString &path)
+{
+    QByteArray fileName = path.toLocal8Bit();
+    FREE_IMAGE_FORMAT fif;
+    ImageInfo info = readHeader(path, fileName, &fif);
+    if (info.isValid())
+        info.pageCount = countPages(fif, fileName);
+
+    return info;
+}
+
+ImageInfo ImageProbe::probeHeader(const QString &path)
+{
+    FREE_IMAGE_FORMAT fif;
+    return readHeader(path, path.toLocal8Bit(), &fif);
+}
+
+int ImageProbe::pageCount(const QString &path)
+{
+    QByteArray fileName = path.toLocal8Bit();
+    return countPages(FreeImage_GetFileType(fileName, 0), fileName);
+}
+
+QVector<ImageInfo> ImageProbe::probeAll(const QStringList &paths)
+{
+    return QtConcurrent::blockingMapped<QVector<ImageInfo> >(paths, &ImageProbe::probe);
+}
+
+QFuture<ImageInfo> ImageProbe::probeAllAsync(const QStringList &paths)
+{
+    // progress and results can be followed with a QFutureWatcher
+    return QtConcurrent::mapped(paths, &ImageProbe::probe);
+}
@@ -0,0 +1,44 @@
+#ifndef IMAGEPROBE_H
+#define IMAGEPROBE_H
+
+#include <QFuture>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+struct ImageInfo
+{
+    QString path;
+    QSize size;
+    int bitsPerPixel = 0;
+    int pageCount = 0;
+
+    bool isValid() const
+    {
+        return size.isValid() && !size.isEmpty();
+    }
+};
+
+/**
+ * @brief The ImageProbe class reads the dimensions, bit depth and page
+ *        count of images from their headers, without decoding any pixels.
+ *
+ * FreeImage is asked for a FIF_LOAD_NOPIXELS load where the plugin supports
+ * it, other formats fall back to the header parsing of QImageReader.
+ * probeHeader() leaves out the page count, which has to walk the page
+ * directory of TIFF, GIF and ICO files, the whole file for a GIF.
+ * probeAll() and probeAllAsync() scan many files on the global thread pool.
+ */
+class ImageProbe
+{
+public:
+    static ImageInfo probe(const QString &path);
+    // pageCount stays 0
+    static ImageInfo probeHeader(const QString &path);
+    static int pageCount(const QString &path);
+    static QVector<ImageInfo> probeAll(const QStringList &paths);
+    static QFuture<ImageInfo> probeAllAsync(const QStringList &paths);
+};
+
+#endif // IMAGEPROBE_H
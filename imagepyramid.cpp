@@ -0,0 +1,224 @@
+#include "imagepyramid.h"
+#include "pixelconverter.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PYRAMID_SSE2
+#endif
+
+// levels stop halving once their longest side fits in this size
+static const int MinLevelSize = 512;
+static const quint32 CacheMagic = 0x4c495059; // "LIPY"
+static const quint32 CacheVersion = 1;
+
+static inline quint32 average4(quint32 a, quint32 b, quint32 c, quint32 d)
+{
+    // (a + b + c + d + 2) / 4 for each 8-bit channel
+    quint32 result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        quint32 sum = ((a >> shift) & 0xff) + ((b >> shift) & 0xff)
+                + ((c >> shift) & 0xff) + ((d >> shift) & 0xff);
+        result |= ((sum + 2) >> 2) << shift;
+    }
+    return result;
+}
+
+static void halveRow(const quint32 *top, const quint32 *bottom, quint32 *dst, int width)
+{
+    int x = 0;
+#ifdef PYRAMID_SSE2
+    // 8 source pixels of both rows give 4 destination pixels, channels summed in 16 bits
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    for (; x + 4 <= width; x += 4) {
+        __m128i t0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(top + 2 * x));
+        __m128i t1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(top + 2 * x + 4));
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bottom + 2 * x));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bottom + 2 * x + 4));
+
+        __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(t0, zero), _mm_unpacklo_epi8(b0, zero));
+        __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(t0, zero), _mm_unpackhi_epi8(b0, zero));
+        __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(t1, zero), _mm_unpacklo_epi8(b1, zero));
+        __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(t1, zero), _mm_unpackhi_epi8(b1, zero));
+
+        // add the right pixel of each pair onto the left one
+        s0 = _mm_add_epi16(s0, _mm_srli_si128(s0, 8));
+        s1 = _mm_add_epi16(s1, _mm_srli_si128(s1, 8));
+        s2 = _mm_add_epi16(s2, _mm_srli_si128(s2, 8));
+        s3 = _mm_add_epi16(s3, _mm_srli_si128(s3, 8));
+
+        __m128i d01 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(s0, s1), two), 2);
+        __m128i d23 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(s2, s3), two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(d01, d23));
+    }
+#endif
+    for (; x < width; x++) {
+        dst[x] = average4(top[2 * x], top[2 * x + 1], bottom[2 * x], bottom[2 * x + 1]);
+    }
+}
+
+ImagePyramid::ImagePyramid(const QImage &image)
+{
+    _levels.append(image);
+}
+
+ImagePyramid ImagePyramid::build(const QImage &image)
+{
+    ImagePyramid pyramid(image);
+    QImage level = image;
+    while (qMax(level.width(), level.height()) > MinLevelSize
+           && qMin(level.width(), level.height()) >= 2) {
+        level = halve(level);
+        pyramid._levels.append(level);
+    }
+
+    return pyramid;
+}
+
+QImage ImagePyramid::toFilterFormat(const QImage &image)
+{
+    QImage::Format format = image.format();
+    if (format == QImage::Format_RGB32 || format == QImage::Format_ARGB32_Premultiplied)
+        return image;
+    if (format != QImage::Format_Grayscale8 && format != QImage::Format_ARGB32)
+        return image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied
+                                                             : QImage::Format_RGB32);
+
+    // the layouts decoders produce most go through the vectorized converters
+    QImage converted(image.size(), format == QImage::Format_Grayscale8 ? QImage::Format_RGB32
+                                                                       : QImage::Format_ARGB32_Premultiplied);
+    if (converted.isNull())
+        return converted;
+    for (int y = 0; y < image.height(); y++) {
+        quint32 *dst = reinterpret_cast<quint32 *>(converted.scanLine(y));
+        if (format == QImage::Format_Grayscale8)
+            PixelConverter::gray8ToRgb32(image.constScanLine(y), dst, image.width());
+        else
+            PixelConverter::premultiply(reinterpret_cast<const quint32 *>(image.constScanLine(y)), dst, image.width());
+    }
+
+    return converted;
+}
+
+QImage ImagePyramid::halve(const QImage &image)
+{
+    if (image.width() < 2 || image.height() < 2)
+        return image;
+
+    // the filter works on 32-bit pixels, alpha is averaged premultiplied
+    QImage src = toFilterFormat(image);
+
+    int width = src.width() / 2;
+    int height = src.height() / 2;
+    QImage dst(width, height, src.format());
+    if (dst.isNull())
+        return dst;
+
+    for (int y = 0; y < height; y++) {
+        const quint32 *top = reinterpret_cast<const quint32 *>(src.constScanLine(2 * y));
+        const quint32 *bottom = reinterpret_cast<const quint32 *>(src.constScanLine(2 * y + 1));
+        halveRow(top, bottom, reinterpret_cast<quint32 *>(dst.scanLine(y)), width);
+    }
+
+    return dst;
+}
+
+int ImagePyramid::levelForScale(qreal scale) const
+{
+    // the smallest level that still has at least one pixel per screen pixel
+    int level = 0;
+    for (int i = 1; i < _levels.count(); i++) {
+        if (_levels.at(i).width() >= _levels.first().width() * scale)
+            level = i;
+    }
+
+    return level;
+}
+
+qint64 ImagePyramid::sizeInBytes() const
+{
+    qint64 bytes = _samples.sizeInBytes();
+    foreach (const QImage &level, _levels) {
+        bytes += level.sizeInBytes();
+    }
+
+    return bytes;
+}
+
+QString ImagePyramid::cacheFileName(const QString &cacheDir, const QString &path)
+{
+    QFileInfo info(path);
+    QString key = QString("%1|%2|%3")
+            .arg(info.absoluteFilePath())
+            .arg(info.size())
+            .arg(info.lastModified().toMSecsSinceEpoch());
+    QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+
+    return QDir(cacheDir).filePath(QString::fromLatin1(hash) + ".pyr");
+}
+
+bool ImagePyramid::loadLevels(const QString &cacheFile)
+{
+    if (isNull())
+        return false;
+
+    QFile file(cacheFile);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    quint32 magic, version;
+    qint32 count;
+    in >> magic >> version >> count;
+    if (magic != CacheMagic || version != CacheVersion || count < 0)
+        return false;
+
+    QVector<QImage> levels;
+    levels.append(image());
+    for (int i = 0; i < count; i++) {
+        qint32 width, height, format, bytesPerLine;
+        in >> width >> height >> format >> bytesPerLine;
+
+        // each level must be the half of the previous one, rounded down like halve()
+        QSize previous = levels.last().size();
+        QSize expected(previous.width() / 2, previous.height() / 2);
+        if (in.status() != QDataStream::Ok || QSize(width, height) != expected)
+            return false;
+
+        QImage level(width, height, QImage::Format(format));
+        if (level.isNull() || level.bytesPerLine() != bytesPerLine)
+            return false;
+        int bytes = int(level.sizeInBytes());
+        if (in.readRawData(reinterpret_cast<char *>(level.bits()), bytes) != bytes)
+            return false;
+        levels.append(level);
+    }
+
+    _levels = levels;
+    return true;
+}
+
+bool ImagePyramid::saveLevels(const QString &cacheFile) const
+{
+    QDir().mkpath(QFileInfo(cacheFile).path());
+    QSaveFile file(cacheFile);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream out(&file);
+    out << CacheMagic << CacheVersion << qint32(_levels.count() - 1);
+    for (int i = 1; i < _levels.count(); i++) {
+        const QImage &level = _levels.at(i);
+        out << qint32(level.width()) << qint32(level.height())
+            << qint32(level.format()) << qint32(level.bytesPerLine());
+        out.writeRawData(reinterpret_cast<const char *>(level.constBits()), int(level.sizeInBytes()));
+    }
+
+    return file.commit();
+}
@@ -0,0 +1,83 @@
+#ifndef IMAGEPYRAMID_H
+#define IMAGEPYRAMID_H
+
+#include <QImage>
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+#include "sampleimage.h"
+
+/**
+ * @brief The ImagePyramid class holds a decoded image together with its
+ *        mipmap levels, each one half the size of the previous one.
+ *
+ * Level 0 is the decoded image itself. Levels are built with a 2x2 box
+ * filter and can be persisted to a sidecar cache directory, keyed by the
+ * source file path, size and modification time.
+ *
+ * High bit depth images also carry their original samples, which the
+ * levels are an 8-bit rendering of. The loader also records the page
+ * count of the file, so the scene does not have to open it again to find
+ * out whether it has more pages.
+ */
+class ImagePyramid
+{
+public:
+    ImagePyramid()
+    {
+    }
+    explicit ImagePyramid(const QImage &image);
+
+    static ImagePyramid build(const QImage &image);
+    static QImage halve(const QImage &image);
+
+    bool isNull() const
+    {
+        return _levels.isEmpty() || _levels.first().isNull();
+    }
+    QImage image() const
+    {
+        return _levels.isEmpty() ? QImage() : _levels.first();
+    }
+    int levelCount() const
+    {
+        return _levels.count();
+    }
+    QImage level(int level) const
+    {
+        return _levels.at(level);
+    }
+    int levelForScale(qreal scale) const;
+    SampleImage samples() const
+    {
+        return _samples;
+    }
+    void setSamples(const SampleImage &samples)
+    {
+        _samples = samples;
+    }
+    int pageCount() const
+    {
+        return _pageCount;
+    }
+    void setPageCount(int pageCount)
+    {
+        _pageCount = pageCount;
+    }
+    qint64 sizeInBytes() const;
+
+    static QString cacheFileName(const QString &cacheDir, const QString &path);
+    bool loadLevels(const QString &cacheFile);
+    bool saveLevels(const QString &cacheFile) const;
+
+private:
+    static QImage toFilterFormat(const QImage &image);
+
+    QVector<QImage> _levels;
+    SampleImage _samples;
+    int _pageCount = 1;
+};
+
+Q_DECLARE_METATYPE(ImagePyramid)
+
+#endif // IMAGEPYRAMID_H
@@ -0,0 +1,191 @@
+#include "labelwatcher.h"
+#include "annotationwriter.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSettings>
+#include <QtConcurrent>
+
+LabelWatcher::LabelWatcher(QObject *parent):
+    QObject(parent)
+{
+    QSettings settings;
+    _batchTimer.setSingleShot(true);
+    _batchTimer.setInterval(settings.value("watcher/batchMs", 500).toInt());
+    _rescanTimer.setInterval(settings.value("watcher/rescanMs", 10000).toInt());
+    connect(&_batchTimer, &QTimer::timeout, this, &LabelWatcher::processBatch);
+    connect(&_rescanTimer, &QTimer::timeout, this, &LabelWatcher::onDirectoryChanged);
+    connect(&_scanWatcher, &QFutureWatcherBase::finished, this, &LabelWatcher::onScanFinished);
+    connect(&_watcher, &QFileSystemWatcher::directoryChanged, this, &LabelWatcher::onDirectoryChanged);
+    connect(&_watcher, &QFileSystemWatcher::fileChanged, this, &LabelWatcher::onFileChanged);
+    connect(AnnotationWriter::instance(), &AnnotationWriter::fileWritten, this, &LabelWatcher::onFileWritten);
+}
+
+void LabelWatcher::watch(const QString &dir)
+{
+    if (!_watcher.directories().isEmpty())
+        _watcher.removePaths(_watcher.directories());
+    if (!_watcher.files().isEmpty())
+        _watcher.removePaths(_watcher.files());
+    _batchTimer.stop();
+    _isDirChanged = false;
+    _changedFiles.clear();
+    _currentFile.clear();
+    _stamps.clear();
+    _hasStamps = false;
+
+    // the first scan only records what the folder holds
+    _dir = QDir(dir).absolutePath();
+    _watcher.addPath(dir);
+    startScan();
+    _rescanTimer.start();
+}
+
+void LabelWatcher::setCurrentFile(const QString &labelFile)
+{
+    // a directory watch misses files rewritten in place, the one on screen is watched itself
+    if (labelFile == _currentFile)
+        return;
+    if (!_currentFile.isEmpty())
+        _watcher.removePath(_currentFile);
+    _currentFile = labelFile;
+    if (!_currentFile.isEmpty() && QFile::exists(_currentFile))
+        _watcher.addPath(_currentFile);
+}
+
+void LabelWatcher::onDirectoryChanged()
+{
+    _isDirChanged = true;
+    if (!_batchTimer.isActive())
+        _batchTimer.start();
+}
+
+void LabelWatcher::onFileChanged(const QString &labelFile)
+{
+    _changedFiles.insert(labelFile);
+    if (!_batchTimer.isActive())
+        _batchTimer.start();
+}
+
+void LabelWatcher::onFileWritten(const QString &labelFile)
+{
+    if (QFileInfo(labelFile).absolutePath() != _dir)
+        return;
+
+    _stamps.insert(labelFile, stamp(labelFile));
+    _writtenFiles.insert(labelFile);
+}
+
+void LabelWatcher::processBatch()
+{
+    // a file replaced through a rename is dropped from the watch
+    if (!_currentFile.isEmpty() && !_watcher.files().contains(_currentFile) && QFile::exists(_currentFile))
+        _watcher.addPath(_currentFile);
+
+    // the changed files are reported when the scan finishes
+    if (_isDirChanged) {
+        startScan();
+        return;
+    }
+    if (!_hasStamps)
+        return;
+
+    // only the file on screen is stamped here, the one just saved has not changed
+    QSet<QString> changedFiles;
+    changedFiles.swap(_changedFiles);
+    foreach (const QString &labelFile, changedFiles) {
+        Stamp current = stamp(labelFile);
+        if (current == _stamps.value(labelFile))
+            continue;
+        if (current.size < 0)
+            _stamps.remove(labelFile);
+        else
+            _stamps.insert(labelFile, current);
+        _changedFiles.insert(labelFile);
+    }
+    emitChanged();
+}
+
+void LabelWatcher::startScan()
+{
+    if (_scanWatcher.isRunning()) {
+        // scanned again once the running scan finishes
+        _isDirChanged = true;
+        return;
+    }
+
+    // events up to now are covered by the scan
+    _isDirChanged = false;
+    _changedFiles.clear();
+    _writtenFiles.clear();
+    _scanDir = _dir;
+    _scanWatcher.setFuture(QtConcurrent::run(&LabelWatcher::scan, _dir));
+}
+
+void LabelWatcher::onScanFinished()
+{
+    Stamps stamps = _scanWatcher.result();
+    if (_scanDir == _dir) {
+        // files saved while the scan ran may be newer than what it saw
+        foreach (const QString &labelFile, _writtenFiles) {
+            if (_stamps.contains(labelFile))
+                stamps.insert(labelFile, _stamps.value(labelFile));
+        }
+
+        // only the files whose size or time differ from the last scan are reported
+        if (_hasStamps) {
+            Stamps::const_iterator it;
+            for (it = stamps.constBegin(); it != stamps.constEnd(); ++it) {
+                Stamps::const_iterator old = _stamps.constFind(it.key());
+                if (old == _stamps.constEnd() || *old != *it)
+                    _changedFiles.insert(it.key());
+            }
+            for (it = _stamps.constBegin(); it != _stamps.constEnd(); ++it) {
+                if (!stamps.contains(it.key()))
+                    _changedFiles.insert(it.key());
+            }
+        }
+        _stamps = stamps;
+        _hasStamps = true;
+    }
+
+    if (_isDirChanged)
+        startScan();
+    emitChanged();
+}
+
+void LabelWatcher::emitChanged()
+{
+    if (_changedFiles.isEmpty())
+        return;
+    QStringList labelFiles = _changedFiles.toList();
+    _changedFiles.clear();
+    emit labelFilesChanged(labelFiles);
+}
+
+LabelWatcher::Stamp LabelWatcher::stamp(const QString &labelFile)
+{
+    Stamp stamp;
+    QFileInfo info(labelFile);
+    if (info.exists()) {
+        stamp.size = info.size();
+        stamp.modified = info.lastModified();
+    }
+    return stamp;
+}
+
+LabelWatcher::Stamps LabelWatcher::scan(const QString &dir)
+{
+    Stamps stamps;
+    QDirIterator it(dir, QStringList() << "*.txt", QDir::Files | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        it.next();
+        QFileInfo info = it.fileInfo();
+        Stamp stamp;
+        stamp.size = info.size();
+        stamp.modified = info.lastModified();
+        stamps.insert(it.filePath(), stamp);
+    }
+
+    return stamps;
+}
@@ -0,0 +1,83 @@
+#ifndef LABELWATCHER_H
+#define LABELWATCHER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+/**
+ * @brief The LabelWatcher class reports label files of the open folder
+ *        that were changed by another program.
+ *
+ * The folder is watched for files being created, renamed or removed, and
+ * the label file on screen for being rewritten in place as well. Events
+ * are batched: the first one starts a timer, and when it fires the folder
+ * is scanned on a worker thread and compared with the sizes and
+ * modification times seen before, so only the label files that really
+ * changed are reported, once per batch. Files rewritten in place without
+ * a folder event are found by a periodic scan.
+ *
+ * The AnnotationWriter reports the label files it writes, their new sizes
+ * and times are taken as seen, so saving does not report them back.
+ */
+class LabelWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    LabelWatcher(QObject *parent = 0);
+
+    void watch(const QString &dir);
+    void setCurrentFile(const QString &labelFile);
+
+signals:
+    void labelFilesChanged(QStringList labelFiles);
+
+private slots:
+    void onDirectoryChanged();
+    void onFileChanged(const QString &labelFile);
+    void onFileWritten(const QString &labelFile);
+    void processBatch();
+    void onScanFinished();
+
+private:
+    struct Stamp {
+        qint64 size = -1;
+        QDateTime modified;
+
+        bool operator==(const Stamp &other) const
+        {
+            return size == other.size && modified == other.modified;
+        }
+        bool operator!=(const Stamp &other) const
+        {
+            return !(*this == other);
+        }
+    };
+    typedef QHash<QString, Stamp> Stamps;
+
+    static Stamp stamp(const QString &labelFile);
+    static Stamps scan(const QString &dir);
+    void startScan();
+    void emitChanged();
+
+    QFileSystemWatcher _watcher;
+    QTimer _batchTimer;
+    QTimer _rescanTimer;
+    QFutureWatcher<Stamps> _scanWatcher;
+    QString _dir;
+    QString _scanDir;
+    QString _currentFile;
+    Stamps _stamps;
+    bool _hasStamps = false;
+    bool _isDirChanged = false;
+    QSet<QString> _changedFiles;
+    // written by the AnnotationWriter since the running scan started
+    QSet<QString> _writtenFiles;
+};
+
+#endif // LABELWATCHER_H
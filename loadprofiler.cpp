@@ -0,0 +1,204 @@
+#include "loadprofiler.h"
+#include "boxitempool.h"
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSaveFile>
+#include <QSettings>
+#include <QTableWidget>
+#include <QTextStream>
+#include <QTimer>
+#include <QVBoxLayout>
+#include <algorithm>
+
+static thread_local bool isThreadRecording = true;
+
+LoadProfiler::LoadProfiler()
+{
+    QSettings settings;
+    _windowSize = qMax(1, settings.value("profiler/window", 512).toInt());
+}
+
+LoadProfiler *LoadProfiler::instance()
+{
+    static LoadProfiler profiler;
+    return &profiler;
+}
+
+void LoadProfiler::setRecording(bool isRecording)
+{
+    isThreadRecording = isRecording;
+}
+
+void LoadProfiler::record(const QString &stage, qint64 nsecs)
+{
+    if (!isThreadRecording)
+        return;
+
+    QMutexLocker locker(&_mutex);
+    if (!_windows.contains(stage))
+        _stages.append(stage);
+
+    // the oldest sample is overwritten once the window is full
+    Window &window = _windows[stage];
+    if (window.samples.count() < _windowSize)
+        window.samples.append(nsecs);
+    else
+        window.samples[window.next] = nsecs;
+    window.next = (window.next + 1) % _windowSize;
+    window.count++;
+}
+
+QStringList LoadProfiler::stages() const
+{
+    QMutexLocker locker(&_mutex);
+    return _stages;
+}
+
+LoadStageStats LoadProfiler::stats(const QString &stage) const
+{
+    LoadStageStats stats;
+    stats.stage = stage;
+
+    QVector<qint64> samples;
+    {
+        QMutexLocker locker(&_mutex);
+        const Window window = _windows.value(stage);
+        samples = window.samples;
+        stats.count = window.count;
+    }
+    if (samples.isEmpty())
+        return stats;
+
+    // nearest rank percentiles over the window
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](int p) {
+        int rank = (p * samples.count() + 99) / 100;
+        return samples.at(qBound(0, rank - 1, samples.count() - 1));
+    };
+    stats.p50 = percentile(50);
+    stats.p95 = percentile(95);
+    stats.p99 = percentile(99);
+    stats.max = samples.last();
+
+    return stats;
+}
+
+void LoadProfiler::reset()
+{
+    QMutexLocker locker(&_mutex);
+    _stages.clear();
+    _windows.clear();
+}
+
+bool LoadProfiler::exportCsv(const QString &fileName) const
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream out(&file);
+    out << "stage,count,p50_ms,p95_ms,p99_ms,max_ms\n";
+    foreach (QString stage, stages()) {
+        LoadStageStats s = stats(stage);
+        out << s.stage << ',' << s.count << ','
+            << s.p50 / 1e6 << ',' << s.p95 / 1e6 << ','
+            << s.p99 / 1e6 << ',' << s.max / 1e6 << '\n';
+    }
+    out.flush();
+
+    return file.commit();
+}
+
+LoadProfilerDock::LoadProfilerDock(QWidget *parent):
+    QDockWidget(tr("Load Profiler"), parent),
+    _table(new QTableWidget(0, 6, this)),
+    _labelBoxes(new QLabel(this)),
+    _timer(new QTimer(this))
+{
+    setObjectName("loadProfilerDock");
+    _table->setHorizontalHeaderLabels(QStringList() << tr("Stage") << tr("Count")
+                                      << tr("p50 (ms)") << tr("p95 (ms)") << tr("p99 (ms)") << tr("Max (ms)"));
+    _table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    _table->verticalHeader()->hide();
+    _table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    QPushButton *resetButton = new QPushButton(tr("&Reset"), this);
+    QPushButton *exportButton = new QPushButton(tr("&Export CSV..."), this);
+    connect(resetButton, &QPushButton::clicked, this, &LoadProfilerDock::reset);
+    connect(exportButton, &QPushButton::clicked, this, &LoadProfilerDock::exportCsv);
+
+    QHBoxLayout *buttons = new QHBoxLayout();
+    buttons->addWidget(_labelBoxes);
+    buttons->addStretch(1);
+    buttons->addWidget(resetButton);
+    buttons->addWidget(exportButton);
+
+    QWidget *widget = new QWidget(this);
+    QVBoxLayout *layout = new QVBoxLayout(widget);
+    layout->addWidget(_table);
+    layout->addLayout(buttons);
+    setWidget(widget);
+
+    _timer->setInterval(1000);
+    connect(_timer, &QTimer::timeout, this, &LoadProfilerDock::refresh);
+}
+
+void LoadProfilerDock::refresh()
+{
+    QStringList stages = LoadProfiler::instance()->stages();
+    _table->setRowCount(stages.count());
+    for (int row = 0; row < stages.count(); row++) {
+        LoadStageStats s = LoadProfiler::instance()->stats(stages.at(row));
+        QStringList values;
+        values << s.stage << QString::number(s.count)
+               << QString::number(s.p50 / 1e6, 'f', 2) << QString::number(s.p95 / 1e6, 'f', 2)
+               << QString::number(s.p99 / 1e6, 'f', 2) << QString::number(s.max / 1e6, 'f', 2);
+        for (int column = 0; column < values.count(); column++) {
+            QTableWidgetItem *item = new QTableWidgetItem(values.at(column));
+            if (column > 0)
+                item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            _table->setItem(row, column, item);
+        }
+    }
+
+    BoxItemPool *pool = BoxItemPool::instance();
+    _labelBoxes->setText(QString(tr("Boxes: %1 live, %2 pooled, %3 allocated"))
+                         .arg(pool->live())
+                         .arg(pool->pooled())
+                         .arg(pool->allocated()));
+}
+
+void LoadProfilerDock::reset()
+{
+    LoadProfiler::instance()->reset();
+    refresh();
+}
+
+void LoadProfilerDock::exportCsv()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export Load Profile"),
+                                                    "load-profile.csv", tr("CSV files (*.csv)"));
+    if (fileName.isEmpty())
+        return;
+
+    if (!LoadProfiler::instance()->exportCsv(fileName))
+        QMessageBox::warning(this, tr("Export Load Profile"),
+                             QString(tr("Cannot write %1")).arg(fileName));
+}
+
+void LoadProfilerDock::showEvent(QShowEvent *event)
+{
+    QDockWidget::showEvent(event);
+    refresh();
+    _timer->start();
+}
+
+void LoadProfilerDock::hideEvent(QHideEvent *event)
+{
+    _timer->stop();
+    QDockWidget::hideEvent(event);
+}
@@ -0,0 +1,115 @@
+#ifndef LOADPROFILER_H
+#define LOADPROFILER_H
+
+#include <QDockWidget>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+class QLabel;
+class QTableWidget;
+class QTimer;
+QT_END_NAMESPACE
+
+struct LoadStageStats
+{
+    QString stage;
+    qint64 count = 0;
+    qint64 p50 = 0;
+    qint64 p95 = 0;
+    qint64 p99 = 0;
+    qint64 max = 0;
+};
+
+/**
+ * @brief The LoadProfiler class collects the durations of the stages of an
+ *        image switch, such as decode, conversion or annotation parsing.
+ *
+ * Each stage keeps a rolling window of its most recent samples, the
+ * percentiles are taken over that window. Stages are recorded from the
+ * loader threads as well, all methods are thread safe.
+ *
+ * Recording can be suspended on the calling thread, so that decodes run
+ * for other purposes, such as the decoder benchmark, are not counted.
+ */
+class LoadProfiler
+{
+public:
+    static LoadProfiler *instance();
+    // Only affects the calling thread.
+    static void setRecording(bool isRecording);
+
+    void record(const QString &stage, qint64 nsecs);
+    QStringList stages() const;
+    LoadStageStats stats(const QString &stage) const;
+    void reset();
+    bool exportCsv(const QString &fileName) const;
+
+private:
+    LoadProfiler();
+
+    struct Window
+    {
+        QVector<qint64> samples;
+        int next = 0;
+        qint64 count = 0;
+    };
+
+    mutable QMutex _mutex;
+    int _windowSize;
+    QStringList _stages;
+    QHash<QString, Window> _windows;
+};
+
+/**
+ * @brief The LoadTimer class records the time between its construction and
+ *        destruction as one sample of a stage.
+ */
+class LoadTimer
+{
+public:
+    explicit LoadTimer(const char *stage):
+        _stage(stage)
+    {
+        _timer.start();
+    }
+    ~LoadTimer()
+    {
+        LoadProfiler::instance()->record(QLatin1String(_stage), _timer.nsecsElapsed());
+    }
+
+private:
+    const char *_stage;
+    QElapsedTimer _timer;
+};
+
+/**
+ * @brief The LoadProfilerDock class shows the stage percentiles of the
+ *        LoadProfiler and the box item pool counters, refreshed while the
+ *        dock is visible.
+ */
+class LoadProfilerDock : public QDockWidget
+{
+    Q_OBJECT
+public:
+    LoadProfilerDock(QWidget *parent = 0);
+
+public slots:
+    void refresh();
+    void reset();
+    void exportCsv();
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    QTableWidget *_table;
+    QLabel *_labelBoxes;
+    QTimer *_timer;
+};
+
+#endif // LOADPROFILER_H
@@ -1,18 +1,19 @@
-#include <QApplication>
-#include <QCommandLineParser>
-#include "mainwindow.h"
-int main(int argc, char *argv[])
-{
-//    Q_IMPORT_PLUGIN( qtiff );
-    QApplication app(argc, argv);
-    QGuiApplication::setApplicationDisplayName(MainWindow::tr("Image Labeler"));
-    QCommandLineParser commandLineParser;
-    commandLineParser.addHelpOption();
-    commandLineParser.addPositionalArgument(MainWindow::tr("[file]"), MainWindow::tr("Image file to open."));
-    commandLineParser.process(QCoreApplication::arguments());
-
-    MainWindow mainWindow;
-    mainWindow.show();
-
-    return app.exec();
-}
+#include <QApplication>
+#include <QCommandLineParser>
+#include "mainwindow.h"
+int main(int argc, char *argv[])
+{
+//    Q_IMPORT_PLUGIN( qtiff );
+    QApplication app(argc, argv);
+    QCoreApplication::setOrganizationName("labelimage");
+    QGuiApplication::setApplicationDisplayName(MainWindow::tr("Image Labeler"));
+    QCommandLineParser commandLineParser;
+    commandLineParser.addHelpOption();
+    commandLineParser.addPositionalArgument(MainWindow::tr("[file]"), MainWindow::tr("Image file to open."));
+    commandLineParser.process(QCoreApplication::arguments());
+
+    MainWindow mainWindow;
+    mainWindow.show();
+
+    return app.exec();
+}
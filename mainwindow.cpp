@@ -1,807 +1,1449 @@
-
-#include <QScrollBar>
-#include <QImageWriter>
-#include <QFileSystemModel>
-#include <QStandardPaths>
-#include <QDebug>
-#include <QMouseEvent>
-#include <QFileDialog>
-#include <functional>
-#include <QtWidgets>
-#if defined(QT_PRINTSUPPORT_LIB)
-#include <QtPrintSupport/qtprintsupportglobal.h>
-#if QT_CONFIG(printdialog)
-#include <QPrintDialog>
-#endif
-#endif
-
-#include "mainwindow.h"
-
-MainWindow::MainWindow()
-{
-    setWindowIcon(QIcon(":/images/draw.ico"));
-    setWindowTitle(tr("Image Labeler"));
-    createActions();
-    createCentralWindow();
-    resize(QGuiApplication::primaryScreen()->availableSize() * 3 / 5);
-    this->installEventFilter(this);
-
-    _languageFile = ":/languages/zh_CN.qm";
-    _translator.load(_languageFile);
-    qApp->installTranslator( &_translator );
-    this->retranslate();
-}
-/**
- * @brief MainWindow::openFolder
- *        Open the specified directory that contains images to be labeled.
- */
-void MainWindow::openFolder()
-{
-    QString srcImageDir = QFileDialog::getExistingDirectory(this, tr("Open Directory"),
-                                                            "",
-                                                            QFileDialog::ShowDirsOnly
-                                                            | QFileDialog::DontResolveSymlinks);
-    if (!srcImageDir.isEmpty()) {
-        setWindowTitle(srcImageDir);
-
-        if (_fileListModel){
-            delete _fileListModel;
-            _fileListModel = nullptr;
-            _editAct->setEnabled(false);
-        }
-
-        // init dirmodel
-        _filters << "*.jpg" << "*.jpeg" << "*.png" << "*.gif" << "*.tif" << "*.tiff" << "*.bmp" << "*.ppm";
-        _fileListModel = new QDirModel(_filters, QDir::Files | QDir::NoDotAndDotDot, QDir::Name, this);
-
-        // init treeview and set model
-        _fileListView->setRootIsDecorated(0);
-        _fileListView->setModel(_fileListModel);
-        _fileListView->setRootIndex(_fileListModel->index(srcImageDir));
-        _fileListView->setSelectionMode(QAbstractItemView::SingleSelection);
-
-        connect(_fileListView->selectionModel(), &QItemSelectionModel::selectionChanged,
-                this, &MainWindow::onFileSelected);
-
-        // load typenamefile and init typename list.
-        _typeNameList.clear();
-        _typeNameFile= srcImageDir + "/names.txt";
-        _typeNameList = loadTypeNameFromFile(_typeNameFile);
-        _editAct->setEnabled(true);
-        if (_typeNameList.count() <= 0) {
-            editTypeNameList();
-            _typeNameList = loadTypeNameFromFile(_typeNameFile);
-        }
-
-        // save image names to txt file
-        saveImageNamesToFile(srcImageDir + "/train.txt");
-
-        // add type name on combobox
-        _typeNameComboBox->clear();
-        _typeNameComboBox->addItems(_typeNameList);
-
-        // set the first image selected.
-        QModelIndex index = _fileListModel->index(0, 0, _fileListView->rootIndex());
-        _fileListView->setCurrentIndex(index);
-        _drawAct->setEnabled(true);
-        _panAct->setEnabled(true);
-
-        _editImageIndex->setValidator(new QIntValidator(1, _fileListModel->rowCount(_fileListView->rootIndex()), this));
-        _editImageIndex->setAlignment(Qt::AlignRight);
-        _editImageIndex->setHidden(false);
-        connect(_editImageIndex, SIGNAL(returnPressed()), this, SLOT(selectFile()));
-    }
-}
-
-void MainWindow::saveImageNamesToFile(const QString fileName)
-{
-
-    QFile file(fileName);
-    file.open(QIODevice::WriteOnly | QIODevice::Text);
-    QTextStream out(&file);
-    out.setCodec(QTextCodec::codecForName("utf-8"));
-
-    QModelIndex rootIndex = _fileListView->rootIndex();
-    int rowCount = _fileListModel->rowCount(rootIndex);
-
-    for (int i = 0; i < rowCount; ++i) {
-        QModelIndex index = _fileListModel->index(i, 0, rootIndex);
-        QString name = _fileListModel->filePath(index);
-        out << name + "\n";
-    }
-
-    file.close();
-}
-
-QStringList MainWindow::loadTypeNameFromFile(QString filePath)
-{
-    QStringList typeNameList;
-    QFile file(filePath);
-    file.open(QIODevice::ReadOnly | QIODevice::Text);
-
-    QTextStream in(&file);
-    while (!in.atEnd()) {
-        QString s = in.readLine();
-        if(!(s.simplified().isEmpty())) {
-            typeNameList.append(s);
-        }
-    }
-    file.close();
-
-    return typeNameList;
-}
-
-void MainWindow::help()
-{
-    _helpMessageBox.about(this,
-                          qApp->translate("MainWindow", "Help"),
-                          qApp->translate("MainWindow", _helpText));
-}
-
-void MainWindow::about()
-{
-    sprintf(_aboutText, "<p><b>Image Labeler %d.%d.%d</b> is based on Qt 5.10.1 and FreeImage 3.18.</p>",
-            VERSION_MAJOR, VERSION_MINOR, VERSION_BUILD);
-    _aboutMessageBox.about(this,
-                           qApp->translate("MainWindow", "About Image Labeler"),
-                           qApp->translate("MainWindow", _aboutText));
-}
-
-/**
- * @brief MainWindow::createActions add menu actions
- */
-void MainWindow::createActions()
-{
-    // file menu
-    _fileMenu = menuBar()->addMenu(tr("&File"));
-    _fileToolBar = addToolBar(tr("File"));
-
-    // open folder
-    _openAct = new QAction(QIcon(":/images/folder.png"), tr("&Open Folder..."), this);
-    _openAct->setShortcuts(QKeySequence::Open);
-    _openAct->setStatusTip(tr("Open an image folder"));
-    connect(_openAct, &QAction::triggered, this, &MainWindow::openFolder);
-    _fileMenu->addAction(_openAct);
-    _fileToolBar->addAction(_openAct);
-
-    // quit
-    _exitAct = _fileMenu->addAction(QIcon(":/images/quit.png"), tr("E&xit"), qApp, &QApplication::closeAllWindows);
-    _exitAct->setShortcut(tr("Ctrl+Q"));
-    _exitAct->setStatusTip(tr("Exit the application"));
-    _fileMenu->addAction(_exitAct);
-    _fileToolBar->addAction(_exitAct);
-
-    menuBar()->addSeparator();
-
-    // edit menu
-    _editMenu = menuBar()->addMenu(tr("&Edit"));
-    _editToolBar = addToolBar(tr("Edit"));
-
-    // draw box rect
-    _drawAct = new QAction(QIcon(":/images/draw.png"), tr("&Draw Box"), this);
-    _drawAct->setShortcut(tr("Ctrl+D"));
-    _drawAct->setStatusTip(tr("Draw Box"));
-    connect(_drawAct, &QAction::toggled, this, &MainWindow::drawBoxItem);
-    _editMenu->addAction(_drawAct);
-    _editToolBar->addAction(_drawAct);
-    _drawAct->setEnabled(false);
-    _drawAct->setCheckable(true);
-    _drawAct->setChecked(false);
-
-    // edit type name
-    _editAct = new QAction(QIcon(":/images/edit.png"), tr("T&arget Type"), this);
-    _editAct->setShortcut(tr("Ctrl+T"));
-    _editAct->setStatusTip(tr("Edit Target Type"));
-    connect(_editAct, &QAction::triggered, this, &MainWindow::editTypeNameList);
-    _editMenu->addAction(_editAct);
-    _editToolBar->addAction(_editAct);
-    _editAct->setEnabled(false);
-
-    // target type combobox
-    _typeNameComboBox = new QComboBox(this);
-    _editToolBar->addWidget(_typeNameComboBox);
-    _typeNameComboBox->installEventFilter(this);
-
-    _editMenu->addSeparator();
-
-    _undoGroup = new QUndoGroup(this);
-    // undo
-    _undoAct = _undoGroup->createUndoAction(this);
-    _undoAct->setIcon(QIcon(":/images/undo.png"));
-    _undoAct->setText(tr("&Undo"));
-    _undoAct->setStatusTip(tr("Undo"));
-    _undoAct->setShortcut(QKeySequence::Undo);
-    _editMenu->addAction(_undoAct);
-    _editToolBar->addAction(_undoAct);
-
-    // redo
-    _redoAct = _undoGroup->createRedoAction(this);
-    _redoAct->setIcon(QIcon(":/images/redo.png"));
-    _redoAct->setText(tr("&Redo"));
-    _redoAct->setStatusTip(tr("Redo"));
-    _redoAct->setShortcut(QKeySequence::Redo);
-    _editMenu->addAction(_redoAct);
-    _editToolBar->addAction(_redoAct);
-
-    _editMenu->addSeparator();
-
-    // copy
-    _copyAct = new QAction(QIcon(":/images/copy.png"), tr("&Copy"), this);
-    _copyAct->setStatusTip(tr("Copy"));
-    _copyAct->setShortcut(QKeySequence::Copy);
-    _copyAct->setEnabled(false);
-    _editMenu->addAction(_copyAct);
-    _editToolBar->addAction(_copyAct);
-
-    // cut
-    _cutAct = new QAction(QIcon(":/images/cut.png"), tr("Cu&t"), this);
-    _cutAct->setStatusTip(tr("Cut"));
-    _cutAct->setShortcut(QKeySequence::Cut);
-    _cutAct->setEnabled(false);
-    _editMenu->addAction(_cutAct);
-    _editToolBar->addAction(_cutAct);
-
-    // paste
-    _pasteAct = new QAction(QIcon(":/images/paste.png"), tr("&Paste"), this);
-    _pasteAct->setStatusTip(tr("Paste"));
-    _pasteAct->setShortcut(QKeySequence::Paste);
-    _pasteAct->setEnabled(false);
-    _editMenu->addAction(_pasteAct);
-    _editToolBar->addAction(_pasteAct);
-
-    menuBar()->addSeparator();
-
-    // view menu
-    _viewMenu = menuBar()->addMenu(tr("&View"));
-    _viewToolBar = addToolBar(tr("View"));
-
-    // pan
-    _panAct = new QAction(QIcon(":/images/pan.png"), tr("&Pan"), this);
-    _panAct->setShortcut(tr("Ctrl+P"));
-    _panAct->setStatusTip(tr("Pan Image"));
-    _panAct->setCheckable(true);
-    _panAct->setChecked(false);
-    _panAct->setEnabled(false);
-    connect(_panAct, &QAction::toggled, this, &MainWindow::panImage);
-    _viewMenu->addAction(_panAct);
-    _viewToolBar->addAction(_panAct);
-
-    // zoom in
-    _zoomInAct = new QAction(QIcon(":/images/zoom-in.png"), tr("Zoom &In"), this);
-    _zoomInAct->setShortcut(QKeySequence::ZoomIn);
-    _zoomInAct->setStatusTip(tr("Zoom In Image"));
-    connect(_zoomInAct, &QAction::triggered, this, &MainWindow::zoomIn);
-    _viewMenu->addAction(_zoomInAct);
-    _viewToolBar->addAction(_zoomInAct);
-
-    // zoom out
-    _zoomOutAct = new QAction(QIcon(":/images/zoom-out.png"), tr("Zoom &Out"), this);
-    _zoomOutAct->setShortcut(QKeySequence::ZoomOut);
-    _zoomOutAct->setStatusTip(tr("Zoom Out Image"));
-    connect(_zoomOutAct, &QAction::triggered, this, &MainWindow::zoomOut);
-    _viewMenu->addAction(_zoomOutAct);
-    _viewToolBar->addAction(_zoomOutAct);
-
-    // fit to window
-    _fitToWindowAct = new QAction(QIcon(":/images/fit-to-window.png"), tr("&Fit To Window"), this);
-    _fitToWindowAct->setShortcut(tr("Ctrl+F"));
-    _fitToWindowAct->setStatusTip(tr("Fit View To Window"));
-    connect(_fitToWindowAct, &QAction::triggered, this, &MainWindow::fitViewToWindow);
-    _fitToWindowAct->setCheckable(true);
-    _fitToWindowAct->setChecked(true);
-    _viewMenu->addAction(_fitToWindowAct);
-    _viewToolBar->addAction(_fitToWindowAct);
-
-    // actual size
-    _actualSizeAct = new QAction(QIcon(":/images/actual-size.png"), tr("&Actual Size"), this);
-    _actualSizeAct->setShortcut(tr("Ctrl+R"));
-    _actualSizeAct->setStatusTip(tr("Fit View To Actual Size"));
-    connect(_actualSizeAct, &QAction::triggered, this, &MainWindow::fitViewToActual);
-    _viewMenu->addAction(_actualSizeAct);
-    _viewToolBar->addAction(_actualSizeAct);
-
-    _viewMenu->addSeparator();
-
-    // full screen
-    _fullscreenAct = new QAction(QIcon(":/images/fullscreen.png"), tr("&Full Screen"), this);
-    _fullscreenAct->setShortcut(tr("Alt+Enter"));
-    _fullscreenAct->setStatusTip(tr("Full Screen"));
-    connect(_fullscreenAct, &QAction::triggered, this, &MainWindow::fullScreen);
-    _viewMenu->addAction(_fullscreenAct);
-    _viewToolBar->addAction(_fullscreenAct);
-
-    // help menu
-    _helpMenu = menuBar()->addMenu(tr("&Help"));
-    _helpToolBar = addToolBar(tr("Help"));
-
-    // language
-    _languageMenu = _helpMenu->addMenu(QIcon(":/images/language.png"), tr("&Language"));
-    _languageMenu->setStatusTip(tr("Select language"));
-
-    // Chinese
-    _zhCNAct = _languageMenu->addAction(QIcon(":/images/zh_CN.png"),
-                tr("&Chinese"));
-    _languageMenu->addAction(_zhCNAct);
-    _helpToolBar->addAction(_zhCNAct);
-    connect(_zhCNAct, &QAction::triggered, this, &MainWindow::switchLanguage);
-
-    // English
-    _enUSAct = _languageMenu->addAction(QIcon(":/images/en_US.png"),
-                tr("&English"));
-    _languageMenu->addAction(_enUSAct);
-    _helpToolBar->addAction(_enUSAct);
-    connect(_enUSAct, &QAction::triggered, this, &MainWindow::switchLanguage);
-
-    // help
-    _helpAct = _helpMenu->addAction(QIcon(":/images/help.png"),
-                tr("&Help"), this, &MainWindow::help);
-    _helpAct->setStatusTip(tr("Help"));
-    _helpAct->setShortcut(QKeySequence::HelpContents);
-    _helpToolBar->addAction(_helpAct);
-
-    // about
-    _aboutAct = _helpMenu->addAction(QIcon(":/images/about.png"),
-                tr("&About"), this, &MainWindow::about);
-    _aboutAct->setStatusTip(tr("About Image Labeler"));
-    _helpToolBar->addAction(_aboutAct);
-}
-
-void MainWindow::switchLanguage()
-{
-    if (this->sender() == _zhCNAct) {
-        _languageFile = ":/languages/zh_CN.qm";
-    } else if (this->sender() == _enUSAct) {
-        _languageFile = ":/languages/en_US.qm";
-    }
-    _translator.load(_languageFile);
-    qApp->installTranslator( &_translator );
-    this->retranslate();
-}
-
-void MainWindow::retranslate()
-{
-    // file menu
-    _fileMenu->setTitle(tr("&File"));
-    //    fileToolBar->setTitle(tr("File"));
-
-    // open folder
-    _openAct->setText(tr("&Open Folder..."));
-    _openAct->setStatusTip(tr("Open an image folder"));
-
-    // quit
-    _exitAct->setText(tr("E&xit"));
-    _exitAct->setShortcut(tr("Ctrl+Q"));
-    _exitAct->setStatusTip(tr("Exit the application"));
-
-    // edit menu
-    _editMenu->setTitle(tr("&Edit"));
-
-    // draw box rect
-    _drawAct->setText(tr("&Draw Box"));
-    _drawAct->setShortcut(tr("Ctrl+D"));
-    _drawAct->setStatusTip(tr("Draw Box"));
-
-    // edit target type
-    _editAct ->setText(tr("T&arget Type"));
-    _editAct->setShortcut(tr("Ctrl+T"));
-    _editAct->setStatusTip(tr("Edit Target Type"));
-
-    // undo
-    _undoAct->setText(tr("&Undo"));
-    _undoAct->setStatusTip(tr("Undo"));
-
-    // redo
-    _redoAct->setText(tr("&Redo"));
-    _redoAct->setStatusTip(tr("Redo"));
-
-    // copy
-    _copyAct->setText(tr("&Copy"));
-    _copyAct->setStatusTip(tr("Copy"));
-
-    // cut
-    _cutAct->setText(tr("Cu&t"));
-    _cutAct->setStatusTip(tr("Cut"));
-
-    // paste
-    _pasteAct->setText(tr("&Paste"));
-    _pasteAct->setStatusTip(tr("Paste"));
-
-    // view menu
-    _viewMenu->setTitle(tr("&View"));
-    //    viewToolBar->setTitle(tr("View"));
-
-    // pan
-    _panAct->setText(tr("&Pan"));
-    _panAct->setShortcut(tr("Ctrl+P"));
-    _panAct->setStatusTip(tr("Pan Image"));
-    // zoom in
-    _zoomInAct->setText(tr("Zoom &In"));
-    _zoomInAct->setShortcut(QKeySequence::ZoomIn);
-    _zoomInAct->setStatusTip(tr("Zoom In Image"));
-    // zoom out
-    _zoomOutAct->setText(tr("Zoom &Out"));
-    _zoomOutAct->setShortcut(QKeySequence::ZoomOut);
-    _zoomOutAct->setStatusTip(tr("Zoom Out Image"));
-    // fit to window
-    _fitToWindowAct->setText(tr("&Fit To Window"));
-    _fitToWindowAct->setShortcut(tr("Ctrl+F"));
-    _fitToWindowAct->setStatusTip(tr("Fit View To Window"));
-
-    // actual size
-    _actualSizeAct->setText(tr("&Actual Size"));
-    _actualSizeAct->setShortcut(tr("Ctrl+R"));
-    _actualSizeAct->setStatusTip(tr("Fit View To Actual Size"));
-
-    // full screen
-    _fullscreenAct->setText(tr("&Full Screen"));
-    _fullscreenAct->setShortcut(tr("Alt+Enter"));
-    _fullscreenAct->setStatusTip(tr("Full Screen"));
-    // help menu
-    _helpMenu->setTitle(tr("&Help"));
-    //    helpToolBar = addToolBar(tr("Help"));
-
-    // language
-    _languageMenu->setTitle(tr("&Language"));
-    _languageMenu->setStatusTip(tr("Select language"));
-
-    // Chinese
-    _zhCNAct->setText(tr("&Chinese"));
-
-    // English
-    _enUSAct->setText(tr("&English"));
-
-    // help
-    _helpAct->setText(tr("&Help"));
-    _helpAct->setStatusTip(tr("Help"));
-
-    // about
-    _aboutAct->setText(tr("&About"));
-    _aboutAct->setToolTip(tr("About Image Labeler"));
-
-    // status bar
-    if (!_imageSize.isEmpty())
-        _labelImageInfo->setText(QString(tr("Image: %1 x %2"))
-                                 .arg(_imageSize.width())
-                                 .arg(_imageSize.height())
-                                 .toUtf8());
-    if (!_boxRect.isNull())
-        _labelBoxInfo->setText(QString(tr("Box: x-%1, y-%2, w-%3, h-%4, type-%5"))
-                               .arg(_boxRect.left())
-                               .arg(_boxRect.top())
-                               .arg(_boxRect.width())
-                               .arg(_boxRect.height())
-                               .arg(_boxTypeName)
-                               .toUtf8());
-    if (!_cursorPos.isNull())
-        _labelCursorPos->setText(QString(tr("Cursor: %1, %2"))
-                                 .arg((int)_cursorPos.x())
-                                 .arg((int)_cursorPos.y())
-                                 .toUtf8());
-}
-
-void MainWindow::createCentralWindow()
-{
-    _centralWidget = new QWidget(this);
-    _horizontalLayout = new QHBoxLayout(_centralWidget);
-    _fileListView = new QTreeView(this);
-//    _fileListView->setSortingEnabled(true);
-
-    _imageView = new CustomView(this);
-    _imageView->setViewportUpdateMode(QGraphicsView::BoundingRectViewportUpdate);
-
-    _mainSplitter = new QSplitter(Qt::Horizontal, _centralWidget);
-    _mainSplitter->addWidget(_fileListView);
-    _mainSplitter->addWidget(_imageView);
-    _mainSplitter->setStretchFactor(0, 2);
-    _mainSplitter->setStretchFactor(1, 8);
-    _mainSplitter->setOpaqueResize(false);
-
-    _horizontalLayout->addWidget(_mainSplitter);
-    _centralWidget->setLayout(_horizontalLayout);
-    this->setCentralWidget(_centralWidget);
-
-    _labelImageIndex = new QLabel();
-    _editImageIndex = new QLineEdit();
-    _labelImageInfo = new QLabel();
-    _labelCursorPos = new QLabel();
-    _labelBoxInfo = new QLabel();
-
-    this->statusBar()->addPermanentWidget(new QLabel(), 1);
-    this->statusBar()->addPermanentWidget(_editImageIndex, 1);
-    _editImageIndex->setHidden(true);
-    this->statusBar()->addPermanentWidget(_labelImageIndex, 1);
-    this->statusBar()->addPermanentWidget(new QLabel(), 1);
-    this->statusBar()->addPermanentWidget(_labelImageInfo, 1);
-    this->statusBar()->addPermanentWidget(new QLabel(), 1);
-    this->statusBar()->addPermanentWidget(_labelCursorPos, 1);
-    this->statusBar()->addPermanentWidget(new QLabel(), 1);
-    this->statusBar()->addPermanentWidget(_labelBoxInfo, 1);
-    this->statusBar()->addPermanentWidget(new QLabel(), 1);
-}
-
-void MainWindow::closeEvent(QCloseEvent *event)
-{
-    if (_imageScene) {
-        delete _imageScene;
-    }
-}
-
-void MainWindow::updateActions()
-{
-    _zoomInAct->setEnabled(!_fitToWindowAct->isChecked());
-    _zoomOutAct->setEnabled(!_fitToWindowAct->isChecked());
-}
-
-void MainWindow::selectFile()
-{
-    int row = _editImageIndex->text().toInt();
-    QModelIndex index = _fileListModel->index(row-1, 0, _fileListView->rootIndex());
-    _fileListView->setCurrentIndex(index);
-}
-
-void MainWindow::onFileSelected(const QItemSelection& selected, const QItemSelection& deselected)
-{
-    QModelIndex index = selected.indexes().first();
-    displayImageView(_fileListModel->filePath(index));
-
-    _editImageIndex->setText(QString("%1")
-                              .arg(index.row()+1));
-    _labelImageIndex->setText(QString("/%1")
-                              .arg(_fileListModel->rowCount(_fileListView->rootIndex()))
-                              .toUtf8());
-    _selectedImageName = _fileListModel->fileName(index);
-    _labelImageInfo->setText(QString(tr("Image: %1 Size: %2 x %3"))
-                             .arg(_selectedImageName)
-                             .arg(_imageSize.width())
-                             .arg(_imageSize.height())
-                             .toUtf8());
-}
-
-void MainWindow::displayImageView(QString imageFilePath)
-{
-    if (_imageScene) {
-        delete _imageScene;
-    }
-
-    _imageScene = new CustomScene(this);
-    _imageScene->setTypeNameList(_typeNameList);
-    _imageScene->setTypeName(_typeNameComboBox->currentText());
-
-    _imageScene->installEventFilter(this);
-    connect(_imageScene, SIGNAL(cursorMoved(QPointF)), this, SLOT(updateLabelCursorPos(QPointF)));
-    connect(_imageScene, SIGNAL(boxSelected(QRect, QString)), this, SLOT(updateBoxInfo(QRect, QString)));
-    connect(_imageScene, SIGNAL(imageLoaded(QSize)), this, SLOT(updateLabelImageSize(QSize)));
-    connect(_typeNameComboBox, SIGNAL(activated(QString)), _imageScene, SLOT(changeBoxTypeName(QString)));
-
-    connect(_copyAct, SIGNAL(triggered()), _imageScene, SLOT(copy()));
-    connect(_pasteAct, SIGNAL(triggered()), _imageScene, SLOT(paste()));
-    connect(_cutAct, SIGNAL(triggered()), _imageScene, SLOT(cut()));
-    connect(_imageScene, SIGNAL(selectionChanged()), this, SLOT(updateCopyCutActions()));
-//    connect(QApplication::clipboard(), SIGNAL(dataChanged()), _imageScene, SLOT(clipboardDataChanged()));
-    connect(QApplication::clipboard(), SIGNAL(dataChanged()), this, SLOT(updatePasteAction()));
-
-    _copyAct->setEnabled(false);
-    _pasteAct->setEnabled(false);
-    _cutAct->setEnabled(false);
-
-    _imageScene->loadImage(imageFilePath);
-    _isImageLoaded = true;
-
-    // init box info on the status bar
-    int boxCount = 0;
-    foreach (QGraphicsItem *item, _imageScene->items()) {
-        if (item->type() == QGraphicsItem::UserType+1) {
-            BoxItem *b = qgraphicsitem_cast<BoxItem *>(item);
-            b->setSelected(true);
-            boxCount++;
-            break;
-        }
-    }
-    if (boxCount == 0)
-        updateBoxInfo(QRect(), QString());
-
-    _undoGroup->addStack(_imageScene->undoStack());
-    _undoGroup->setActiveStack(_imageScene ? _imageScene->undoStack() : 0);
-
-    _imageView->setScene(_imageScene);
-
-    _panAct->setChecked(false);
-    if (_drawAct->isChecked()) {
-        drawBoxItem(true);
-    }
-    _fitToWindowAct->setChecked(true);
-    fitViewToWindow();
-
-    // init drawing status from _drawAct
-    _imageScene->drawBoxItem(_drawAct->isChecked());
-}
-
-void MainWindow::showEvent(QShowEvent* event)
-{
-    fitViewToWindow();
-}
-
-void MainWindow::resizeEvent(QResizeEvent* event)
-{
-    fitViewToWindow();
-}
-
-bool MainWindow::eventFilter(QObject *obj, QEvent *event)
-{
-    if (obj == _imageScene || obj == _typeNameComboBox || obj == this) {
-        if (event->type() == QEvent::KeyPress) {
-            QKeyEvent *keyEvent = static_cast<QKeyEvent*>(event);
-            // use Key_Down and Key_Up received by _viewScene and MainWindow to select image in fileListView
-            if (keyEvent->key() == Qt::Key_Down || keyEvent->key() == Qt::Key_Up ) {
-                int rowCount = _fileListModel->rowCount(_fileListView->rootIndex());
-                int currentRow = _fileListView->currentIndex().row();
-                if (keyEvent->key() == Qt::Key_Down) {
-                    currentRow = qMin(rowCount-1, currentRow+1);
-                } else if (keyEvent->key() == Qt::Key_Up) {
-                    currentRow = qMax(0, currentRow-1);
-                }
-                QModelIndex index = _fileListModel->index(currentRow,  0, _fileListView->rootIndex());
-                _fileListView->setCurrentIndex(index);
-                return true;
-            }
-        }
-        return false;
-    } else {
-        // pass the event on to the parent class
-        return QMainWindow::eventFilter(obj, event);
-    }
-}
-
-void MainWindow::drawBoxItem(bool checked)
-{
-    if (!_isImageLoaded)
-        return;
-
-    if (_panAct->isChecked()) {
-        _panAct->setChecked(false);
-    }
-    _imageView->drawBoxItem(checked);
-    _imageScene->drawBoxItem(checked);
-}
-
-void MainWindow::panImage(bool checked)
-{
-    if (!_isImageLoaded)
-        return;
-
-    if (_fitToWindowAct->isChecked())
-        _fitToWindowAct->setChecked(false);
-
-    if (_drawAct->isChecked())
-        _drawAct->setChecked(false);
-
-    _imageView->panImage(checked);
-    _imageScene->panImage(checked);
-}
-
-void MainWindow::editTypeNameList()
-{
-    TypeEditDialog* d = new TypeEditDialog(this, _typeNameFile, &_translator);
-    int r = d->exec();
-    if (r == QDialog::Accepted) {
-        delete d;
-    }
-}
-
-void MainWindow::updateCopyCutActions()
-{
-    bool op = _imageScene->selectedItems().count() > 0;
-
-    _copyAct->setEnabled(op);
-    _cutAct->setEnabled(op);
-}
-
-void MainWindow::updatePasteAction()
-{
-    _pasteAct->setEnabled(true);
-}
-
-
-void MainWindow::zoomIn()
-{
-    if (!_isImageLoaded)
-        return;
-
-    if (_fitToWindowAct->isChecked())
-        _fitToWindowAct->setChecked(false);
-
-    _imageView->scale(1.2, 1.2);
-}
-
-void MainWindow::zoomOut()
-{
-    if (!_isImageLoaded)
-        return;
-
-    if (_fitToWindowAct->isChecked())
-        _fitToWindowAct->setChecked(false);
-
-    _imageView->scale(0.8, 0.8);
-}
-
-void MainWindow::wheelEvent(QWheelEvent *event)
-{
-    if (!_isImageLoaded)
-        return;
-
-    if (_fitToWindowAct->isChecked())
-        _fitToWindowAct->setChecked(false);
-
-    qreal newZoom = 1 + (event->delta() / 120.0) * 0.05;
-    _imageView->scale(newZoom, newZoom);
-}
-
-void MainWindow::fitViewToWindow()
-{
-    if (!_isImageLoaded)
-        return;
-    if (!_fitToWindowAct->isChecked())
-        return;
-    if (_panAct->isChecked())
-        _panAct->setChecked(false);
-
-    _imageView->fitInView(_imageView->sceneRect(), Qt::KeepAspectRatio);
-}
-
-void MainWindow::fitViewToActual()
-{
-    if (!_isImageLoaded)
-        return;
-
-    if (_fitToWindowAct->isChecked())
-        _fitToWindowAct->setChecked(false);
-
-    _imageView->fitInView(_imageView->rect(), Qt::KeepAspectRatio); // please check this issue.
-}
-
-void MainWindow::fullScreen()
-{
-    auto makeFullscreen = !isFullScreen();
-
-    _fileListView->setVisible(!makeFullscreen);
-    setWindowState(makeFullscreen ? Qt::WindowFullScreen : Qt::WindowMaximized);
-}
-
-void MainWindow::updateLabelImageSize(QSize imageSize)
-{
-    _imageSize = imageSize;
-    _labelImageInfo->setText(QString(tr("Image: %1 Size: %2 x %3"))
-                             .arg(_selectedImageName)
-                             .arg(_imageSize.width())
-                             .arg(_imageSize.height())
-                             .toUtf8());
-}
-
-void MainWindow::updateBoxInfo(QRect rect, QString typeName)
-{
-    if (typeName.isNull() || rect.isNull())
-    {
-        _labelBoxInfo->setText(QString(tr("Box: x- , y- , w- , h- , type: "))
-                   .toUtf8());
-        return;
-    }
-    _boxRect = rect;
-    _boxTypeName = typeName;
-    _labelBoxInfo->setText(QString(tr("Box: x-%1, y-%2, w-%3, h-%4, type: %5"))
-                           .arg(_boxRect.left())
-                           .arg(_boxRect.top())
-                           .arg(_boxRect.width())
-                           .arg(_boxRect.height())
-                           .arg(_boxTypeName)
-                           .toUtf8());
-    _typeNameComboBox->setCurrentText(_boxTypeName);
-}
-
-void MainWindow::updateLabelCursorPos(QPointF cursorPos)
-{
-    _cursorPos = cursorPos;
-    _labelCursorPos->setText(QString(tr("Cursor: %1, %2"))
-                             .arg((int)_cursorPos.x())
-                             .arg((int)_cursorPos.y())
-                             .toUtf8());
-}
+
+#include <QScrollBar>
+#include <QImageWriter>
+#include <QFileSystemModel>
+#include <QStandardPaths>
+#include <QDebug>
+#include <QMouseEvent>
+#include <QFileDialog>
+#include <functional>
+#include <QtWidgets>
+#include <QtConcurrent>
+#if defined(QT_PRINTSUPPORT_LIB)
+#include <QtPrintSupport/qtprintsupportglobal.h>
+#if QT_CONFIG(printdialog)
+#include <QPrintDialog>
+#endif
+#endif
+
+#include "mainwindow.h"
+
+MainWindow::MainWindow()
+{
+    setWindowIcon(QIcon(":/images/draw.ico"));
+    setWindowTitle(tr("Image Labeler"));
+    createActions();
+    createCentralWindow();
+    _imageLoader = new ImageLoader(this);
+    connect(_imageLoader, &ImageLoader::previewLoaded, this, &MainWindow::onPreviewLoaded);
+    connect(_imageLoader, &ImageLoader::imageLoaded, this, &MainWindow::onImageLoaded);
+    connect(_imageLoader, &ImageLoader::imagePrefetched, this, &MainWindow::onImagePrefetched);
+
+    // decoded image cache and prefetch distance, tunable through the settings file
+    QSettings settings;
+    _imageCache.setBudget(settings.value("cache/budgetMB", 512).toLongLong() * 1024 * 1024);
+    _prefetchCount = settings.value("cache/prefetchCount", 2).toInt();
+
+    // thumbnails kept across sessions, shown in the file list and while decoding
+    _thumbnailStore = new ThumbnailStore(this);
+    QString thumbnailDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails";
+    _thumbnailStore->open(settings.value("thumbnails/dir", thumbnailDir).toString());
+    _thumbnailDelegate = new ThumbnailDelegate(_thumbnailStore, this);
+    _fileListView->setItemDelegate(_thumbnailDelegate);
+    _fileListView->setIconSize(QSize(32, 32));
+    connect(_thumbnailStore, &ThumbnailStore::thumbnailReady, this, &MainWindow::onThumbnailReady);
+
+    // box counts and classes of every image of the folder
+    _annotationIndex = new AnnotationIndex(this);
+    connect(_annotationIndex, &AnnotationIndex::progress, this, &MainWindow::onIndexProgress);
+    connect(_annotationIndex, &AnnotationIndex::ready, this, &MainWindow::onIndexReady);
+
+    // label files rewritten by other programs, e.g. pre-labelling scripts
+    _labelWatcher = new LabelWatcher(this);
+    connect(_labelWatcher, &LabelWatcher::labelFilesChanged, this, &MainWindow::onLabelFilesChanged);
+
+    // edits of a session that did not shut down cleanly are written to their label files
+    QString journalFile = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/edits.journal";
+    connect(EditJournal::instance(), &EditJournal::recovered, this, &MainWindow::onJournalRecovered);
+    connect(&_benchmarkWatcher, &QFutureWatcherBase::finished, this, &MainWindow::onBenchmarkFinished);
+    EditJournal::instance()->open(settings.value("journal/file", journalFile).toString());
+    resize(QGuiApplication::primaryScreen()->availableSize() * 3 / 5);
+    this->installEventFilter(this);
+
+    _languageFile = ":/languages/zh_CN.qm";
+    _translator.load(_languageFile);
+    qApp->installTranslator( &_translator );
+    this->retranslate();
+}
+/**
+ * @brief MainWindow::openFolder
+ *        Open the specified directory that contains images to be labeled.
+ */
+void MainWindow::openFolder()
+{
+    QString srcImageDir = QFileDialog::getExistingDirectory(this, tr("Open Directory"),
+                                                            "",
+                                                            QFileDialog::ShowDirsOnly
+                                                            | QFileDialog::DontResolveSymlinks);
+    if (!srcImageDir.isEmpty()) {
+        setWindowTitle(srcImageDir);
+
+        if (_fileListModel){
+            delete _fileListModel;
+            _fileListModel = nullptr;
+            _editAct->setEnabled(false);
+        }
+
+        // init dirmodel
+        _filters << "*.jpg" << "*.jpeg" << "*.png" << "*.gif" << "*.tif" << "*.tiff" << "*.bmp" << "*.ppm";
+        _fileListModel = new QDirModel(_filters, QDir::Files | QDir::NoDotAndDotDot, QDir::Name, this);
+
+        // init treeview and set model
+        _fileListView->setRootIsDecorated(0);
+        _fileListView->setModel(_fileListModel);
+        _fileListView->setRootIndex(_fileListModel->index(srcImageDir));
+        _fileListView->setSelectionMode(QAbstractItemView::SingleSelection);
+
+        connect(_fileListView->selectionModel(), &QItemSelectionModel::selectionChanged,
+                this, &MainWindow::onFileSelected);
+
+        // load typenamefile and init typename list.
+        _typeNameList.clear();
+        _typeNameFile= srcImageDir + "/names.txt";
+        _typeNameList = loadTypeNameFromFile(_typeNameFile);
+        _editAct->setEnabled(true);
+        if (_typeNameList.count() <= 0) {
+            editTypeNameList();
+            _typeNameList = loadTypeNameFromFile(_typeNameFile);
+        }
+
+        // save image names to txt file
+        saveImageNamesToFile(srcImageDir + "/train.txt");
+
+        // build the thumbnails missing from the store in the background
+        QStringList imagePaths;
+        QModelIndex rootIndex = _fileListView->rootIndex();
+        for (int i = 0; i < _fileListModel->rowCount(rootIndex); ++i) {
+            imagePaths.append(_fileListModel->filePath(_fileListModel->index(i, 0, rootIndex)));
+        }
+        _thumbnailStore->fill(imagePaths);
+
+        // and parse all of their label files
+        setJumpActionsEnabled(false);
+        _annotationIndex->build(imagePaths, _typeNameList.count());
+        _labelWatcher->watch(srcImageDir);
+
+        // add type name on combobox
+        _typeNameComboBox->clear();
+        _typeNameComboBox->addItems(_typeNameList);
+
+        // set the first image selected.
+        QModelIndex index = _fileListModel->index(0, 0, _fileListView->rootIndex());
+        _fileListView->setCurrentIndex(index);
+        _drawAct->setEnabled(true);
+        _panAct->setEnabled(true);
+        _benchmarkAct->setEnabled(true);
+
+        _editImageIndex->setValidator(new QIntValidator(1, _fileListModel->rowCount(_fileListView->rootIndex()), this));
+        _editImageIndex->setAlignment(Qt::AlignRight);
+        _editImageIndex->setHidden(false);
+        connect(_editImageIndex, SIGNAL(returnPressed()), this, SLOT(selectFile()));
+    }
+}
+
+void MainWindow::saveImageNamesToFile(const QString fileName)
+{
+
+    QFile file(fileName);
+    file.open(QIODevice::WriteOnly | QIODevice::Text);
+    QTextStream out(&file);
+    out.setCodec(QTextCodec::codecForName("utf-8"));
+
+    QModelIndex rootIndex = _fileListView->rootIndex();
+    int rowCount = _fileListModel->rowCount(rootIndex);
+
+    for (int i = 0; i < rowCount; ++i) {
+        QModelIndex index = _fileListModel->index(i, 0, rootIndex);
+        QString name = _fileListModel->filePath(index);
+        out << name + "\n";
+    }
+
+    file.close();
+}
+
+QStringList MainWindow::loadTypeNameFromFile(QString filePath)
+{
+    QStringList typeNameList;
+    QFile file(filePath);
+    file.open(QIODevice::ReadOnly | QIODevice::Text);
+
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString s = in.readLine();
+        if(!(s.simplified().isEmpty())) {
+            typeNameList.append(s);
+        }
+    }
+    file.close();
+
+    return typeNameList;
+}
+
+void MainWindow::help()
+{
+    _helpMessageBox.about(this,
+                          qApp->translate("MainWindow", "Help"),
+                          qApp->translate("MainWindow", _helpText));
+}
+
+void MainWindow::about()
+{
+    sprintf(_aboutText, "<p><b>Image Labeler %d.%d.%d</b> is based on Qt 5.10.1 and FreeImage 3.18.</p>",
+            VERSION_MAJOR, VERSION_MINOR, VERSION_BUILD);
+    _aboutMessageBox.about(this,
+                           qApp->translate("MainWindow", "About Image Labeler"),
+                           qApp->translate("MainWindow", _aboutText));
+}
+
+/**
+ * @brief MainWindow::benchmarkDecoders
+ *        Decode a sample of the current folder with every backend on a worker
+ *        thread and report their throughput when done.
+ */
+void MainWindow::benchmarkDecoders()
+{
+    if (!_fileListModel || _benchmarkWatcher.isRunning())
+        return;
+
+    // spread the sample over the whole folder
+    static const int SampleCount = 32;
+    QModelIndex rootIndex = _fileListView->rootIndex();
+    int rowCount = _fileListModel->rowCount(rootIndex);
+    int step = qMax(1, rowCount / SampleCount);
+    QStringList paths;
+    for (int row = 0; row < rowCount && paths.count() < SampleCount; row += step) {
+        paths.append(_fileListModel->filePath(_fileListModel->index(row, 0, rootIndex)));
+    }
+    _benchmarkSampleCount = paths.count();
+
+    DecoderRegistry *registry = DecoderRegistry::instance();
+    _benchmarkProgress = new QProgressDialog(tr("Decoding sample images..."), tr("Cancel"),
+                                             0, registry->benchmarkSteps(paths.count()), this);
+    _benchmarkProgress->setWindowTitle(tr("Benchmark Decoders"));
+    _benchmarkProgress->setWindowModality(Qt::WindowModal);
+    _benchmarkProgress->setMinimumDuration(0);
+    _benchmarkProgress->setValue(0);
+    connect(_benchmarkProgress, &QProgressDialog::canceled, this, &MainWindow::cancelBenchmark);
+
+    _isBenchmarkCanceled.storeRelease(0);
+    _benchmarkAct->setEnabled(false);
+    _benchmarkWatcher.setFuture(QtConcurrent::run(registry, &DecoderRegistry::benchmark,
+                                                  paths, _benchmarkProgress, &_isBenchmarkCanceled));
+}
+
+void MainWindow::cancelBenchmark()
+{
+    _isBenchmarkCanceled.storeRelease(1);
+}
+
+void MainWindow::onBenchmarkFinished()
+{
+    _benchmarkProgress->deleteLater();
+    _benchmarkProgress = nullptr;
+    _benchmarkAct->setEnabled(true);
+    if (_isBenchmarkCanceled.loadAcquire())
+        return;
+
+    QString report = QString(tr("<p>%1 images sampled from the current folder.</p>")).arg(_benchmarkSampleCount);
+    foreach (const DecoderStats &stats, _benchmarkWatcher.result()) {
+        double seconds = stats.nsecs / 1e9;
+        report += QString(tr("<p><b>%1</b> (%2): %3 decoded, %4 failed, %5 images/s, %6 MB/s</p>"))
+                .arg(stats.decoder)
+                .arg(stats.isMapped ? tr("mapped") : tr("file reads"))
+                .arg(stats.images)
+                .arg(stats.failures)
+                .arg(seconds > 0 ? stats.images / seconds : 0, 0, 'f', 1)
+                .arg(seconds > 0 ? stats.bytes / seconds / (1024 * 1024) : 0, 0, 'f', 1);
+    }
+    QMessageBox::information(this, tr("Benchmark Decoders"), report);
+}
+
+/**
+ * @brief MainWindow::createActions add menu actions
+ */
+void MainWindow::createActions()
+{
+    // file menu
+    _fileMenu = menuBar()->addMenu(tr("&File"));
+    _fileToolBar = addToolBar(tr("File"));
+
+    // open folder
+    _openAct = new QAction(QIcon(":/images/folder.png"), tr("&Open Folder..."), this);
+    _openAct->setShortcuts(QKeySequence::Open);
+    _openAct->setStatusTip(tr("Open an image folder"));
+    connect(_openAct, &QAction::triggered, this, &MainWindow::openFolder);
+    _fileMenu->addAction(_openAct);
+    _fileToolBar->addAction(_openAct);
+
+    // quit
+    _exitAct = _fileMenu->addAction(QIcon(":/images/quit.png"), tr("E&xit"), qApp, &QApplication::closeAllWindows);
+    _exitAct->setShortcut(tr("Ctrl+Q"));
+    _exitAct->setStatusTip(tr("Exit the application"));
+    _fileMenu->addAction(_exitAct);
+    _fileToolBar->addAction(_exitAct);
+
+    menuBar()->addSeparator();
+
+    // edit menu
+    _editMenu = menuBar()->addMenu(tr("&Edit"));
+    _editToolBar = addToolBar(tr("Edit"));
+
+    // draw box rect
+    _drawAct = new QAction(QIcon(":/images/draw.png"), tr("&Draw Box"), this);
+    _drawAct->setShortcut(tr("Ctrl+D"));
+    _drawAct->setStatusTip(tr("Draw Box"));
+    connect(_drawAct, &QAction::toggled, this, &MainWindow::drawBoxItem);
+    _editMenu->addAction(_drawAct);
+    _editToolBar->addAction(_drawAct);
+    _drawAct->setEnabled(false);
+    _drawAct->setCheckable(true);
+    _drawAct->setChecked(false);
+
+    // edit type name
+    _editAct = new QAction(QIcon(":/images/edit.png"), tr("T&arget Type"), this);
+    _editAct->setShortcut(tr("Ctrl+T"));
+    _editAct->setStatusTip(tr("Edit Target Type"));
+    connect(_editAct, &QAction::triggered, this, &MainWindow::editTypeNameList);
+    _editMenu->addAction(_editAct);
+    _editToolBar->addAction(_editAct);
+    _editAct->setEnabled(false);
+
+    // target type combobox
+    _typeNameComboBox = new QComboBox(this);
+    _editToolBar->addWidget(_typeNameComboBox);
+    _typeNameComboBox->installEventFilter(this);
+    connect(_typeNameComboBox, SIGNAL(activated(QString)), this, SLOT(changeBoxTypeName(QString)));
+
+    _editMenu->addSeparator();
+
+    _undoGroup = new QUndoGroup(this);
+    // undo
+    _undoAct = _undoGroup->createUndoAction(this);
+    _undoAct->setIcon(QIcon(":/images/undo.png"));
+    _undoAct->setText(tr("&Undo"));
+    _undoAct->setStatusTip(tr("Undo"));
+    _undoAct->setShortcut(QKeySequence::Undo);
+    _editMenu->addAction(_undoAct);
+    _editToolBar->addAction(_undoAct);
+
+    // redo
+    _redoAct = _undoGroup->createRedoAction(this);
+    _redoAct->setIcon(QIcon(":/images/redo.png"));
+    _redoAct->setText(tr("&Redo"));
+    _redoAct->setStatusTip(tr("Redo"));
+    _redoAct->setShortcut(QKeySequence::Redo);
+    _editMenu->addAction(_redoAct);
+    _editToolBar->addAction(_redoAct);
+
+    _editMenu->addSeparator();
+
+    // copy
+    _copyAct = new QAction(QIcon(":/images/copy.png"), tr("&Copy"), this);
+    _copyAct->setStatusTip(tr("Copy"));
+    _copyAct->setShortcut(QKeySequence::Copy);
+    _copyAct->setEnabled(false);
+    _editMenu->addAction(_copyAct);
+    _editToolBar->addAction(_copyAct);
+
+    // cut
+    _cutAct = new QAction(QIcon(":/images/cut.png"), tr("Cu&t"), this);
+    _cutAct->setStatusTip(tr("Cut"));
+    _cutAct->setShortcut(QKeySequence::Cut);
+    _cutAct->setEnabled(false);
+    _editMenu->addAction(_cutAct);
+    _editToolBar->addAction(_cutAct);
+
+    // paste
+    _pasteAct = new QAction(QIcon(":/images/paste.png"), tr("&Paste"), this);
+    _pasteAct->setStatusTip(tr("Paste"));
+    _pasteAct->setShortcut(QKeySequence::Paste);
+    _pasteAct->setEnabled(false);
+    _editMenu->addAction(_pasteAct);
+    _editToolBar->addAction(_pasteAct);
+
+    // the actions go to whichever scene is on screen
+    connect(_copyAct, SIGNAL(triggered()), this, SLOT(copy()));
+    connect(_cutAct, SIGNAL(triggered()), this, SLOT(cut()));
+    connect(_pasteAct, SIGNAL(triggered()), this, SLOT(paste()));
+    connect(QApplication::clipboard(), SIGNAL(dataChanged()), this, SLOT(updatePasteAction()));
+
+    menuBar()->addSeparator();
+
+    // view menu
+    _viewMenu = menuBar()->addMenu(tr("&View"));
+    _viewToolBar = addToolBar(tr("View"));
+
+    // pan
+    _panAct = new QAction(QIcon(":/images/pan.png"), tr("&Pan"), this);
+    _panAct->setShortcut(tr("Ctrl+P"));
+    _panAct->setStatusTip(tr("Pan Image"));
+    _panAct->setCheckable(true);
+    _panAct->setChecked(false);
+    _panAct->setEnabled(false);
+    connect(_panAct, &QAction::toggled, this, &MainWindow::panImage);
+    _viewMenu->addAction(_panAct);
+    _viewToolBar->addAction(_panAct);
+
+    // zoom in
+    _zoomInAct = new QAction(QIcon(":/images/zoom-in.png"), tr("Zoom &In"), this);
+    _zoomInAct->setShortcut(QKeySequence::ZoomIn);
+    _zoomInAct->setStatusTip(tr("Zoom In Image"));
+    connect(_zoomInAct, &QAction::triggered, this, &MainWindow::zoomIn);
+    _viewMenu->addAction(_zoomInAct);
+    _viewToolBar->addAction(_zoomInAct);
+
+    // zoom out
+    _zoomOutAct = new QAction(QIcon(":/images/zoom-out.png"), tr("Zoom &Out"), this);
+    _zoomOutAct->setShortcut(QKeySequence::ZoomOut);
+    _zoomOutAct->setStatusTip(tr("Zoom Out Image"));
+    connect(_zoomOutAct, &QAction::triggered, this, &MainWindow::zoomOut);
+    _viewMenu->addAction(_zoomOutAct);
+    _viewToolBar->addAction(_zoomOutAct);
+
+    // fit to window
+    _fitToWindowAct = new QAction(QIcon(":/images/fit-to-window.png"), tr("&Fit To Window"), this);
+    _fitToWindowAct->setShortcut(tr("Ctrl+F"));
+    _fitToWindowAct->setStatusTip(tr("Fit View To Window"));
+    connect(_fitToWindowAct, &QAction::triggered, this, &MainWindow::fitViewToWindow);
+    _fitToWindowAct->setCheckable(true);
+    _fitToWindowAct->setChecked(true);
+    _viewMenu->addAction(_fitToWindowAct);
+    _viewToolBar->addAction(_fitToWindowAct);
+
+    // actual size
+    _actualSizeAct = new QAction(QIcon(":/images/actual-size.png"), tr("&Actual Size"), this);
+    _actualSizeAct->setShortcut(tr("Ctrl+R"));
+    _actualSizeAct->setStatusTip(tr("Fit View To Actual Size"));
+    connect(_actualSizeAct, &QAction::triggered, this, &MainWindow::fitViewToActual);
+    _viewMenu->addAction(_actualSizeAct);
+    _viewToolBar->addAction(_actualSizeAct);
+
+    _viewMenu->addSeparator();
+
+    // full screen
+    _fullscreenAct = new QAction(QIcon(":/images/fullscreen.png"), tr("&Full Screen"), this);
+    _fullscreenAct->setShortcut(tr("Alt+Enter"));
+    _fullscreenAct->setStatusTip(tr("Full Screen"));
+    connect(_fullscreenAct, &QAction::triggered, this, &MainWindow::fullScreen);
+    _viewMenu->addAction(_fullscreenAct);
+    _viewToolBar->addAction(_fullscreenAct);
+
+    // window/level of 16-bit and float images
+    _windowToolBar = addToolBar(tr("Window"));
+    _autoWindowAct = new QAction(tr("A&uto Window"), this);
+    _autoWindowAct->setStatusTip(tr("Stretch Window Over Sample Range"));
+    connect(_autoWindowAct, &QAction::triggered, this, &MainWindow::autoWindow);
+    _viewMenu->addAction(_autoWindowAct);
+    _windowToolBar->addAction(_autoWindowAct);
+    _levelSlider = new QSlider(Qt::Horizontal, this);
+    _levelSlider->setRange(0, 65535);
+    _levelSlider->setMaximumWidth(120);
+    _windowToolBar->addWidget(_levelSlider);
+    _widthSlider = new QSlider(Qt::Horizontal, this);
+    _widthSlider->setRange(1, 65535);
+    _widthSlider->setMaximumWidth(120);
+    _windowToolBar->addWidget(_widthSlider);
+    _labelWindow = new QLabel(this);
+    _windowToolBar->addWidget(_labelWindow);
+    connect(_levelSlider, &QSlider::valueChanged, this, &MainWindow::changeWindow);
+    connect(_widthSlider, &QSlider::valueChanged, this, &MainWindow::changeWindow);
+    _windowToolBar->setEnabled(false);
+
+    menuBar()->addSeparator();
+
+    // go menu, answered by the annotation index once the folder is indexed
+    _goMenu = menuBar()->addMenu(tr("&Go"));
+    _goToolBar = addToolBar(tr("Go"));
+
+    // next / previous unlabeled
+    _nextUnlabeledAct = _goMenu->addAction(tr("Next &Unlabeled"), this, &MainWindow::nextUnlabeled);
+    _nextUnlabeledAct->setShortcut(tr("Ctrl+U"));
+    _nextUnlabeledAct->setStatusTip(tr("Go To The Next Image Without Boxes"));
+    _previousUnlabeledAct = _goMenu->addAction(tr("Previous Unlabeled"), this, &MainWindow::previousUnlabeled);
+    _previousUnlabeledAct->setShortcut(tr("Ctrl+Shift+U"));
+    _previousUnlabeledAct->setStatusTip(tr("Go To The Previous Image Without Boxes"));
+
+    _goMenu->addSeparator();
+
+    // next / previous with the target type of the combobox
+    _nextTypeAct = _goMenu->addAction(tr("Next With &Target Type"), this, &MainWindow::nextWithType);
+    _nextTypeAct->setShortcut(tr("Ctrl+J"));
+    _nextTypeAct->setStatusTip(tr("Go To The Next Image With The Selected Target Type"));
+    _previousTypeAct = _goMenu->addAction(tr("Previous With Target Type"), this, &MainWindow::previousWithType);
+    _previousTypeAct->setShortcut(tr("Ctrl+Shift+J"));
+    _previousTypeAct->setStatusTip(tr("Go To The Previous Image With The Selected Target Type"));
+
+    _goMenu->addSeparator();
+
+    // next / previous with more boxes than the spinbox
+    _nextBoxesAct = _goMenu->addAction(tr("Next With &More Boxes"), this, &MainWindow::nextWithMoreBoxes);
+    _nextBoxesAct->setShortcut(tr("Ctrl+K"));
+    _nextBoxesAct->setStatusTip(tr("Go To The Next Image With More Boxes Than Given"));
+    _previousBoxesAct = _goMenu->addAction(tr("Previous With More Boxes"), this, &MainWindow::previousWithMoreBoxes);
+    _previousBoxesAct->setShortcut(tr("Ctrl+Shift+K"));
+    _previousBoxesAct->setStatusTip(tr("Go To The Previous Image With More Boxes Than Given"));
+    _boxCountSpinBox = new QSpinBox(this);
+    _boxCountSpinBox->setRange(0, 9999);
+    _boxCountSpinBox->setPrefix(tr("Boxes > "));
+    _goToolBar->addAction(_nextUnlabeledAct);
+    _goToolBar->addAction(_nextTypeAct);
+    _goToolBar->addAction(_nextBoxesAct);
+    _goToolBar->addWidget(_boxCountSpinBox);
+    setJumpActionsEnabled(false);
+
+    // help menu
+    _helpMenu = menuBar()->addMenu(tr("&Help"));
+    _helpToolBar = addToolBar(tr("Help"));
+
+    // language
+    _languageMenu = _helpMenu->addMenu(QIcon(":/images/language.png"), tr("&Language"));
+    _languageMenu->setStatusTip(tr("Select language"));
+
+    // Chinese
+    _zhCNAct = _languageMenu->addAction(QIcon(":/images/zh_CN.png"),
+                tr("&Chinese"));
+    _languageMenu->addAction(_zhCNAct);
+    _helpToolBar->addAction(_zhCNAct);
+    connect(_zhCNAct, &QAction::triggered, this, &MainWindow::switchLanguage);
+
+    // English
+    _enUSAct = _languageMenu->addAction(QIcon(":/images/en_US.png"),
+                tr("&English"));
+    _languageMenu->addAction(_enUSAct);
+    _helpToolBar->addAction(_enUSAct);
+    connect(_enUSAct, &QAction::triggered, this, &MainWindow::switchLanguage);
+
+    // help
+    _helpAct = _helpMenu->addAction(QIcon(":/images/help.png"),
+                tr("&Help"), this, &MainWindow::help);
+    _helpAct->setStatusTip(tr("Help"));
+    _helpAct->setShortcut(QKeySequence::HelpContents);
+    _helpToolBar->addAction(_helpAct);
+
+    // decoder benchmark
+    _benchmarkAct = _helpMenu->addAction(tr("&Benchmark Decoders"), this, &MainWindow::benchmarkDecoders);
+    _benchmarkAct->setStatusTip(tr("Measure Decoder Throughput On The Current Folder"));
+    _benchmarkAct->setEnabled(false);
+
+    // load latency per stage
+    _profilerDock = new LoadProfilerDock(this);
+    addDockWidget(Qt::BottomDockWidgetArea, _profilerDock);
+    _profilerDock->hide();
+    _profilerAct = _profilerDock->toggleViewAction();
+    _profilerAct->setText(tr("&Load Profiler"));
+    _profilerAct->setStatusTip(tr("Show Load Latency Per Stage"));
+    _helpMenu->addAction(_profilerAct);
+
+    // about
+    _aboutAct = _helpMenu->addAction(QIcon(":/images/about.png"),
+                tr("&About"), this, &MainWindow::about);
+    _aboutAct->setStatusTip(tr("About Image Labeler"));
+    _helpToolBar->addAction(_aboutAct);
+}
+
+void MainWindow::switchLanguage()
+{
+    if (this->sender() == _zhCNAct) {
+        _languageFile = ":/languages/zh_CN.qm";
+    } else if (this->sender() == _enUSAct) {
+        _languageFile = ":/languages/en_US.qm";
+    }
+    _translator.load(_languageFile);
+    qApp->installTranslator( &_translator );
+    this->retranslate();
+}
+
+void MainWindow::retranslate()
+{
+    // file menu
+    _fileMenu->setTitle(tr("&File"));
+    //    fileToolBar->setTitle(tr("File"));
+
+    // open folder
+    _openAct->setText(tr("&Open Folder..."));
+    _openAct->setStatusTip(tr("Open an image folder"));
+
+    // quit
+    _exitAct->setText(tr("E&xit"));
+    _exitAct->setShortcut(tr("Ctrl+Q"));
+    _exitAct->setStatusTip(tr("Exit the application"));
+
+    // edit menu
+    _editMenu->setTitle(tr("&Edit"));
+
+    // draw box rect
+    _drawAct->setText(tr("&Draw Box"));
+    _drawAct->setShortcut(tr("Ctrl+D"));
+    _drawAct->setStatusTip(tr("Draw Box"));
+
+    // edit target type
+    _editAct ->setText(tr("T&arget Type"));
+    _editAct->setShortcut(tr("Ctrl+T"));
+    _editAct->setStatusTip(tr("Edit Target Type"));
+
+    // undo
+    _undoAct->setText(tr("&Undo"));
+    _undoAct->setStatusTip(tr("Undo"));
+
+    // redo
+    _redoAct->setText(tr("&Redo"));
+    _redoAct->setStatusTip(tr("Redo"));
+
+    // copy
+    _copyAct->setText(tr("&Copy"));
+    _copyAct->setStatusTip(tr("Copy"));
+
+    // cut
+    _cutAct->setText(tr("Cu&t"));
+    _cutAct->setStatusTip(tr("Cut"));
+
+    // paste
+    _pasteAct->setText(tr("&Paste"));
+    _pasteAct->setStatusTip(tr("Paste"));
+
+    // view menu
+    _viewMenu->setTitle(tr("&View"));
+    //    viewToolBar->setTitle(tr("View"));
+
+    // pan
+    _panAct->setText(tr("&Pan"));
+    _panAct->setShortcut(tr("Ctrl+P"));
+    _panAct->setStatusTip(tr("Pan Image"));
+    // zoom in
+    _zoomInAct->setText(tr("Zoom &In"));
+    _zoomInAct->setShortcut(QKeySequence::ZoomIn);
+    _zoomInAct->setStatusTip(tr("Zoom In Image"));
+    // zoom out
+    _zoomOutAct->setText(tr("Zoom &Out"));
+    _zoomOutAct->setShortcut(QKeySequence::ZoomOut);
+    _zoomOutAct->setStatusTip(tr("Zoom Out Image"));
+    // fit to window
+    _fitToWindowAct->setText(tr("&Fit To Window"));
+    _fitToWindowAct->setShortcut(tr("Ctrl+F"));
+    _fitToWindowAct->setStatusTip(tr("Fit View To Window"));
+
+    // actual size
+    _actualSizeAct->setText(tr("&Actual Size"));
+    _actualSizeAct->setShortcut(tr("Ctrl+R"));
+    _actualSizeAct->setStatusTip(tr("Fit View To Actual Size"));
+
+    // full screen
+    _fullscreenAct->setText(tr("&Full Screen"));
+    _fullscreenAct->setShortcut(tr("Alt+Enter"));
+    _fullscreenAct->setStatusTip(tr("Full Screen"));
+
+    // auto window
+    _autoWindowAct->setText(tr("A&uto Window"));
+    _autoWindowAct->setStatusTip(tr("Stretch Window Over Sample Range"));
+
+    // go menu
+    _goMenu->setTitle(tr("&Go"));
+    _nextUnlabeledAct->setText(tr("Next &Unlabeled"));
+    _nextUnlabeledAct->setStatusTip(tr("Go To The Next Image Without Boxes"));
+    _previousUnlabeledAct->setText(tr("Previous Unlabeled"));
+    _previousUnlabeledAct->setStatusTip(tr("Go To The Previous Image Without Boxes"));
+    _nextTypeAct->setText(tr("Next With &Target Type"));
+    _nextTypeAct->setStatusTip(tr("Go To The Next Image With The Selected Target Type"));
+    _previousTypeAct->setText(tr("Previous With Target Type"));
+    _previousTypeAct->setStatusTip(tr("Go To The Previous Image With The Selected Target Type"));
+    _nextBoxesAct->setText(tr("Next With &More Boxes"));
+    _nextBoxesAct->setStatusTip(tr("Go To The Next Image With More Boxes Than Given"));
+    _previousBoxesAct->setText(tr("Previous With More Boxes"));
+    _previousBoxesAct->setStatusTip(tr("Go To The Previous Image With More Boxes Than Given"));
+    _boxCountSpinBox->setPrefix(tr("Boxes > "));
+
+    // help menu
+    _helpMenu->setTitle(tr("&Help"));
+    //    helpToolBar = addToolBar(tr("Help"));
+
+    // language
+    _languageMenu->setTitle(tr("&Language"));
+    _languageMenu->setStatusTip(tr("Select language"));
+
+    // Chinese
+    _zhCNAct->setText(tr("&Chinese"));
+
+    // English
+    _enUSAct->setText(tr("&English"));
+
+    // help
+    _helpAct->setText(tr("&Help"));
+    _helpAct->setStatusTip(tr("Help"));
+
+    // decoder benchmark
+    _benchmarkAct->setText(tr("&Benchmark Decoders"));
+    _benchmarkAct->setStatusTip(tr("Measure Decoder Throughput On The Current Folder"));
+
+    // load profiler
+    _profilerDock->setWindowTitle(tr("Load Profiler"));
+    _profilerAct->setText(tr("&Load Profiler"));
+    _profilerAct->setStatusTip(tr("Show Load Latency Per Stage"));
+
+    // about
+    _aboutAct->setText(tr("&About"));
+    _aboutAct->setToolTip(tr("About Image Labeler"));
+
+    // status bar
+    if (!_imageSize.isEmpty())
+        _labelImageInfo->setText(QString(tr("Image: %1 x %2"))
+                                 .arg(_imageSize.width())
+                                 .arg(_imageSize.height())
+                                 .toUtf8());
+    if (!_boxRect.isNull())
+        _labelBoxInfo->setText(QString(tr("Box: x-%1, y-%2, w-%3, h-%4, type-%5"))
+                               .arg(_boxRect.left())
+                               .arg(_boxRect.top())
+                               .arg(_boxRect.width())
+                               .arg(_boxRect.height())
+                               .arg(_boxTypeName)
+                               .toUtf8());
+    if (!_cursorPos.isNull())
+        _labelCursorPos->setText(QString(tr("Cursor: %1, %2"))
+                                 .arg((int)_cursorPos.x())
+                                 .arg((int)_cursorPos.y())
+                                 .toUtf8());
+}
+
+void MainWindow::createCentralWindow()
+{
+    _centralWidget = new QWidget(this);
+    _horizontalLayout = new QHBoxLayout(_centralWidget);
+    _fileListView = new QTreeView(this);
+//    _fileListView->setSortingEnabled(true);
+
+    _imageView = new CustomView(this);
+    _imageView->setViewportUpdateMode(QGraphicsView::BoundingRectViewportUpdate);
+    connect(_imageView, SIGNAL(framePainted()), this, SLOT(onFramePainted()));
+    connect(AnnotationWriter::instance(), SIGNAL(writeFailed(QString)), this, SLOT(onAnnotationWriteFailed(QString)));
+
+    _mainSplitter = new QSplitter(Qt::Horizontal, _centralWidget);
+    _mainSplitter->addWidget(_fileListView);
+    _mainSplitter->addWidget(_imageView);
+    _mainSplitter->setStretchFactor(0, 2);
+    _mainSplitter->setStretchFactor(1, 8);
+    _mainSplitter->setOpaqueResize(false);
+
+    _horizontalLayout->addWidget(_mainSplitter);
+    _centralWidget->setLayout(_horizontalLayout);
+    this->setCentralWidget(_centralWidget);
+
+    _labelImageIndex = new QLabel();
+    _editImageIndex = new QLineEdit();
+    _labelImageInfo = new QLabel();
+    _labelCursorPos = new QLabel();
+    _labelBoxInfo = new QLabel();
+    _labelPage = new QLabel();
+    _indexProgress = new QProgressBar();
+    _indexProgress->setMaximumWidth(160);
+    _indexProgress->setFormat(tr("Indexing %p%"));
+    _indexProgress->setHidden(true);
+
+    this->statusBar()->addPermanentWidget(new QLabel(), 1);
+    this->statusBar()->addPermanentWidget(_editImageIndex, 1);
+    _editImageIndex->setHidden(true);
+    this->statusBar()->addPermanentWidget(_labelImageIndex, 1);
+    this->statusBar()->addPermanentWidget(new QLabel(), 1);
+    this->statusBar()->addPermanentWidget(_labelImageInfo, 1);
+    this->statusBar()->addPermanentWidget(_labelPage);
+    this->statusBar()->addPermanentWidget(new QLabel(), 1);
+    this->statusBar()->addPermanentWidget(_labelCursorPos, 1);
+    this->statusBar()->addPermanentWidget(new QLabel(), 1);
+    this->statusBar()->addPermanentWidget(_labelBoxInfo, 1);
+    this->statusBar()->addPermanentWidget(new QLabel(), 1);
+    this->statusBar()->addPermanentWidget(_indexProgress);
+}
+
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    _imageLoader->cancel();
+    _thumbnailStore->cancel();
+    _annotationIndex->cancel();
+    // the benchmark still uses the cancel flag and the decoders
+    cancelBenchmark();
+    _benchmarkWatcher.waitForFinished();
+    if (_imageScene) {
+        delete _imageScene;
+        _imageScene = nullptr;
+    }
+    if (_backScene) {
+        delete _backScene;
+        _backScene = nullptr;
+    }
+    BoxItemPool::instance()->clear();
+
+    // the scenes queued their last label files above, wait until they are on disk
+    AnnotationWriter::instance()->flush();
+    EditJournal::instance()->close();
+}
+
+void MainWindow::updateActions()
+{
+    _zoomInAct->setEnabled(!_fitToWindowAct->isChecked());
+    _zoomOutAct->setEnabled(!_fitToWindowAct->isChecked());
+}
+
+void MainWindow::selectFile()
+{
+    int row = _editImageIndex->text().toInt();
+    QModelIndex index = _fileListModel->index(row-1, 0, _fileListView->rootIndex());
+    _fileListView->setCurrentIndex(index);
+}
+
+void MainWindow::onFileSelected(const QItemSelection& selected, const QItemSelection& deselected)
+{
+    QModelIndex index = selected.indexes().first();
+
+    _editImageIndex->setText(QString("%1")
+                              .arg(index.row()+1));
+    _labelImageIndex->setText(QString("/%1")
+                              .arg(_fileListModel->rowCount(_fileListView->rootIndex()))
+                              .toUtf8());
+    _selectedImageName = _fileListModel->fileName(index);
+    displayImageView(_fileListModel->filePath(index));
+    prefetchNeighbours(index.row());
+}
+
+void MainWindow::displayImageView(QString imageFilePath)
+{
+    // the part of a switch that runs on the GUI thread, decoding is timed by the loader
+    LoadTimer timer("switch");
+    _switchTimer.start();
+    _pendingImagePath = imageFilePath;
+
+    // large tiled TIFFs are streamed tile by tile instead of being decoded whole
+    if (TiledImage::isTiled(imageFilePath)) {
+        _imageLoader->cancel();
+        showImage(imageFilePath, ImagePyramid());
+        return;
+    }
+
+    ImagePyramid image;
+    if (_imageCache.lookup(imageFilePath, &image)) {
+        _imageLoader->cancel();
+        showImage(imageFilePath, image);
+        return;
+    }
+
+    // decode on the worker pool, the previous frame stays on screen until the result arrives
+    if (_imageLoader->isDecoding(imageFilePath)) {
+        // already being prefetched, onImagePrefetched() shows it
+        _imageLoader->cancel();
+    } else {
+        // in fit to window mode a reduced resolution preview is shown first
+        QSize viewSize = _imageView->viewport()->size();
+        int previewSize = _fitToWindowAct->isChecked() ? qMax(viewSize.width(), viewSize.height()) : 0;
+        _imageLoader->load(imageFilePath, previewSize);
+    }
+
+    // a stored thumbnail stands in for the image until the decode arrives
+    QSize imageSize;
+    QImage thumbnail;
+    {
+        LoadTimer timer("thumbnail");
+        thumbnail = _thumbnailStore->thumbnail(QFileInfo(imageFilePath), &imageSize);
+    }
+    if (!thumbnail.isNull()) {
+        showImage(imageFilePath, ImagePyramid(thumbnail), imageSize);
+        _pendingImagePath = imageFilePath;
+    }
+
+    // the thumbnail entry or else the header gives the size long before the decode finishes,
+    // the page count comes with the decoded image
+    ImageInfo info;
+    info.size = imageSize;
+    if (!info.isValid()) {
+        LoadTimer timer("header");
+        info = ImageProbe::probeHeader(imageFilePath);
+    }
+    if (info.isValid()) {
+        _labelImageInfo->setText(QString(tr("Image: %1 Size: %2 x %3 Loading..."))
+                                 .arg(_selectedImageName)
+                                 .arg(info.size.width())
+                                 .arg(info.size.height())
+                                 .toUtf8());
+    } else {
+        _labelImageInfo->setText(QString(tr("Image: %1 Loading..."))
+                                 .arg(_selectedImageName)
+                                 .toUtf8());
+    }
+}
+
+void MainWindow::prefetchNeighbours(int row)
+{
+    QModelIndex rootIndex = _fileListView->rootIndex();
+    int rowCount = _fileListModel->rowCount(rootIndex);
+
+    // nearest first, the next image before the previous one
+    QStringList paths;
+    for (int i = 1; i <= _prefetchCount; i++) {
+        foreach (int r, QList<int>() << row + i << row - i) {
+            if (r < 0 || r >= rowCount)
+                continue;
+            QString path = _fileListModel->filePath(_fileListModel->index(r, 0, rootIndex));
+            if (!_imageCache.contains(path) && !_imageLoader->isDecoding(path))
+                paths.append(path);
+        }
+    }
+    _imageLoader->prefetch(paths);
+}
+
+void MainWindow::onImagePrefetched(QString path, ImagePyramid image)
+{
+    _imageCache.insert(path, image);
+    if (path != _pendingImagePath)
+        return;
+
+    if (_imageScene && _imageScene->isPreview() && _imageScene->imageFileName() == path) {
+        _pendingImagePath.clear();
+        _imageScene->replaceImage(image);
+        return;
+    }
+    showImage(path, image);
+}
+
+void MainWindow::onSamplesLoaded()
+{
+    // a window set by hand is kept for the next images of a series
+    SampleImageItem *item = _imageScene->sampleItem();
+    if (_isWindowSet)
+        item->setWindow(_windowLow, _windowHigh);
+    updateWindowControls();
+    _windowToolBar->setEnabled(true);
+}
+
+void MainWindow::changeWindow()
+{
+    if (!_imageScene || !_imageScene->sampleItem())
+        return;
+
+    int level = _levelSlider->value();
+    int width = _widthSlider->value();
+    _windowLow = quint16(qBound(0, level - width / 2, 65535));
+    _windowHigh = quint16(qBound(0, level - width / 2 + width, 65535));
+    _isWindowSet = true;
+
+    // only the visible tiles are mapped again, the samples stay decoded
+    _imageScene->setWindow(_windowLow, _windowHigh);
+    updateWindowControls();
+}
+
+void MainWindow::autoWindow()
+{
+    _isWindowSet = false;
+    if (!_imageScene || !_imageScene->sampleItem())
+        return;
+
+    SampleImageItem *item = _imageScene->sampleItem();
+    item->setWindow(item->samples().minimum(), item->samples().maximum());
+    updateWindowControls();
+}
+
+void MainWindow::updateWindowControls()
+{
+    SampleImageItem *item = _imageScene->sampleItem();
+    int low = item->low();
+    int high = item->high();
+
+    QSignalBlocker levelBlocker(_levelSlider);
+    QSignalBlocker widthBlocker(_widthSlider);
+    _levelSlider->setValue((low + high) / 2);
+    _widthSlider->setValue(qMax(1, high - low));
+
+    const SampleImage &samples = item->samples();
+    _labelWindow->setText(QString(tr("L: %1 W: %2"))
+                          .arg(samples.valueAt(quint16((low + high) / 2)), 0, 'g', 5)
+                          .arg(samples.valueAt(quint16(high)) - samples.valueAt(quint16(low)), 0, 'g', 5));
+}
+
+void MainWindow::onPageChanged(int page, int pageCount)
+{
+    _labelPage->setText(QString(tr("Page: %1/%2")).arg(page + 1).arg(pageCount));
+    _labelWatcher->setCurrentFile(_imageScene->labelFileName());
+    fitViewToWindow();
+}
+
+void MainWindow::onThumbnailReady(QString path)
+{
+    _thumbnailDelegate->invalidate(path);
+    _fileListView->viewport()->update();
+}
+
+void MainWindow::onPreviewLoaded(int serial, QString path, QImage preview, QSize imageSize)
+{
+    if (!_imageLoader->isCurrent(serial))
+        return;
+
+    // sharpen a thumbnail placeholder in place
+    if (_imageScene && _imageScene->isPreview() && _imageScene->imageFileName() == path) {
+        _imageScene->replaceImage(ImagePyramid(preview));
+        return;
+    }
+    showImage(path, ImagePyramid(preview), imageSize);
+}
+
+void MainWindow::onImageLoaded(int serial, QString path, ImagePyramid image)
+{
+    // a newer image was selected while this one was decoding
+    if (!_imageLoader->isCurrent(serial))
+        return;
+
+    _imageCache.insert(path, image);
+
+    // swap the full resolution pixels under the preview, boxes and undo history stay
+    if (_imageScene && _imageScene->isPreview() && _imageScene->imageFileName() == path) {
+        _imageScene->replaceImage(image);
+        return;
+    }
+    showImage(path, image);
+}
+
+CustomScene *MainWindow::createScene()
+{
+    CustomScene *scene = new CustomScene(this);
+    scene->setUndoHistory(&_undoHistory);
+
+    scene->installEventFilter(this);
+    connect(scene, SIGNAL(cursorMoved(QPointF)), this, SLOT(updateLabelCursorPos(QPointF)));
+    connect(scene, SIGNAL(boxSelected(QRect, QString)), this, SLOT(updateBoxInfo(QRect, QString)));
+    connect(scene, SIGNAL(imageLoaded(QSize)), this, SLOT(updateLabelImageSize(QSize)));
+    connect(scene, SIGNAL(samplesLoaded()), this, SLOT(onSamplesLoaded()));
+    connect(scene, SIGNAL(pageChanged(int, int)), this, SLOT(onPageChanged(int, int)));
+    connect(scene, SIGNAL(selectionChanged()), this, SLOT(updateCopyCutActions()));
+    connect(scene, SIGNAL(labelsSaved(QString, QVector<YoloBox>)), _annotationIndex, SLOT(update(QString, QVector<YoloBox>)));
+    connect(scene, SIGNAL(labelConflict(QString)), this, SLOT(onLabelConflict(QString)));
+    connect(scene, SIGNAL(labelLinesRejected(QString, int, int)), this, SLOT(onLabelLinesRejected(QString, int, int)));
+//    connect(QApplication::clipboard(), SIGNAL(dataChanged()), scene, SLOT(clipboardDataChanged()));
+
+    _undoGroup->addStack(scene->undoStack());
+    return scene;
+}
+
+void MainWindow::showImage(const QString &imageFilePath, const ImagePyramid &image, QSize imageSize)
+{
+    LoadTimer timer("scene");
+    _pendingImagePath.clear();
+
+    // the same file must not be loaded while its boxes are still held by the front scene
+    if (_imageScene && _imageScene->imageFileName() == imageFilePath)
+        _imageScene->reset();
+
+    // the next image is built in the back scene while the current one stays on screen,
+    // the scenes, their connections and undo stacks are kept, only the items change
+    if (_backScene)
+        _backScene->reset();
+    else
+        _backScene = createScene();
+    CustomScene *scene = _backScene;
+    scene->setTypeNameList(_typeNameList);
+    scene->setTypeName(_typeNameComboBox->currentText());
+
+    {
+        // the status bar follows the scene on screen, it is updated after the swap
+        QSignalBlocker blocker(scene);
+        if (!image.isNull())
+            scene->loadImage(imageFilePath, image, imageSize);
+        else
+            scene->loadTiledImage(imageFilePath);
+    }
+
+    // swap, the previous image is torn down once the new one had a chance to paint
+    _backScene = _imageScene;
+    _imageScene = scene;
+    _imageView->setScene(_imageScene);
+    _undoGroup->setActiveStack(_imageScene->undoStack());
+    if (_backScene)
+        QTimer::singleShot(0, _backScene, SLOT(reset()));
+    _isFirstPixelPending = _switchTimer.isValid();
+
+    _copyAct->setEnabled(false);
+    _pasteAct->setEnabled(false);
+    _cutAct->setEnabled(false);
+    _windowToolBar->setEnabled(false);
+    _labelPage->clear();
+
+    updateLabelImageSize(_imageScene->imageSize());
+    _labelWatcher->setCurrentFile(_imageScene->labelFileName());
+    if (_imageScene->sampleItem() != nullptr)
+        onSamplesLoaded();
+    if (_imageScene->pageCount() > 1)
+        onPageChanged(_imageScene->page(), _imageScene->pageCount());
+    updateImageInfoToolTip();
+    _isImageLoaded = true;
+
+    // init box info on the status bar
+    int boxCount = 0;
+    foreach (QGraphicsItem *item, _imageScene->items()) {
+        if (item->type() == QGraphicsItem::UserType+1) {
+            BoxItem *b = qgraphicsitem_cast<BoxItem *>(item);
+            b->setSelected(true);
+            boxCount++;
+            break;
+        }
+    }
+    if (boxCount == 0)
+        updateBoxInfo(QRect(), QString());
+
+    _panAct->setChecked(false);
+    if (_drawAct->isChecked()) {
+        drawBoxItem(true);
+    }
+    _fitToWindowAct->setChecked(true);
+    fitViewToWindow();
+
+    // init drawing status from _drawAct
+    _imageScene->drawBoxItem(_drawAct->isChecked());
+}
+
+void MainWindow::updateImageInfoToolTip()
+{
+    QString toolTip = QString(tr("Cache: %1 hits, %2 misses, %3 / %4 MB"))
+            .arg(_imageCache.hits())
+            .arg(_imageCache.misses())
+            .arg(_imageCache.bytes() / (1024 * 1024))
+            .arg(_imageCache.budget() / (1024 * 1024));
+    if (_firstPixelNsecs >= 0)
+        toolTip += "\n" + QString(tr("First pixel: %1 ms")).arg(_firstPixelNsecs / 1e6, 0, 'f', 1);
+    _labelImageInfo->setToolTip(toolTip);
+}
+
+void MainWindow::onFramePainted()
+{
+    if (!_isFirstPixelPending)
+        return;
+
+    // from the selection of the image to the first frame showing any of it
+    _isFirstPixelPending = false;
+    _firstPixelNsecs = _switchTimer.nsecsElapsed();
+    _switchTimer.invalidate();
+    LoadProfiler::instance()->record("first pixel", _firstPixelNsecs);
+    updateImageInfoToolTip();
+}
+
+void MainWindow::onAnnotationWriteFailed(QString fileName)
+{
+    statusBar()->showMessage(QString(tr("Cannot write %1")).arg(fileName), 5000);
+}
+
+void MainWindow::onIndexProgress(int indexed, int total)
+{
+    _indexProgress->setMaximum(total);
+    _indexProgress->setValue(indexed);
+    _indexProgress->setHidden(false);
+}
+
+void MainWindow::onIndexReady()
+{
+    _indexProgress->setHidden(true);
+    setJumpActionsEnabled(true);
+}
+
+void MainWindow::onLabelFilesChanged(QStringList labelFiles)
+{
+    // only the changed files are parsed again
+    foreach (const QString &labelFile, labelFiles) {
+        _annotationIndex->reload(labelFile);
+        if (_imageScene)
+            _imageScene->reloadBoxItems(labelFile);
+    }
+}
+
+void MainWindow::onJournalRecovered(int files, int conflicts)
+{
+    if (conflicts > 0)
+        statusBar()->showMessage(QString(tr("Recovered unsaved boxes of %1 label files, %2 files were changed "
+                                            "by other programs and their boxes are kept in .conflict files"))
+                                 .arg(files + conflicts).arg(conflicts), 10000);
+    else
+        statusBar()->showMessage(QString(tr("Recovered unsaved boxes of %1 label files")).arg(files), 5000);
+}
+
+void MainWindow::onLabelConflict(QString labelFile)
+{
+    statusBar()->showMessage(QString(tr("%1 was changed on disk while its boxes were edited, "
+                                        "the version on disk is kept as %1.conflict")).arg(labelFile), 10000);
+}
+
+void MainWindow::onLabelLinesRejected(QString labelFile, int firstLine, int count)
+{
+    statusBar()->showMessage(QString(tr("%1 has %2 lines that are not valid boxes, the first is line %3. "
+                                        "They are kept in the file but not shown"))
+                             .arg(labelFile).arg(count).arg(firstLine), 10000);
+}
+
+void MainWindow::setJumpActionsEnabled(bool enabled)
+{
+    _nextUnlabeledAct->setEnabled(enabled);
+    _previousUnlabeledAct->setEnabled(enabled);
+    _nextTypeAct->setEnabled(enabled);
+    _previousTypeAct->setEnabled(enabled);
+    _nextBoxesAct->setEnabled(enabled);
+    _previousBoxesAct->setEnabled(enabled);
+}
+
+void MainWindow::jumpToRow(int row)
+{
+    if (row < 0) {
+        statusBar()->showMessage(tr("No matching image"), 3000);
+        return;
+    }
+
+    // selecting the row loads the image, the rows in between are never decoded
+    QModelIndex index = _fileListModel->index(row, 0, _fileListView->rootIndex());
+    _fileListView->setCurrentIndex(index);
+    _fileListView->scrollTo(index);
+}
+
+void MainWindow::nextUnlabeled()
+{
+    jumpToRow(_annotationIndex->nextUnlabeled(_fileListView->currentIndex().row(), true));
+}
+
+void MainWindow::previousUnlabeled()
+{
+    jumpToRow(_annotationIndex->nextUnlabeled(_fileListView->currentIndex().row(), false));
+}
+
+void MainWindow::nextWithType()
+{
+    jumpToRow(_annotationIndex->nextWithClass(_typeNameComboBox->currentIndex(),
+                                              _fileListView->currentIndex().row(), true));
+}
+
+void MainWindow::previousWithType()
+{
+    jumpToRow(_annotationIndex->nextWithClass(_typeNameComboBox->currentIndex(),
+                                              _fileListView->currentIndex().row(), false));
+}
+
+void MainWindow::nextWithMoreBoxes()
+{
+    jumpToRow(_annotationIndex->nextWithMoreBoxes(_boxCountSpinBox->value(),
+                                                  _fileListView->currentIndex().row(), true));
+}
+
+void MainWindow::previousWithMoreBoxes()
+{
+    jumpToRow(_annotationIndex->nextWithMoreBoxes(_boxCountSpinBox->value(),
+                                                  _fileListView->currentIndex().row(), false));
+}
+
+void MainWindow::copy()
+{
+    if (_imageScene)
+        _imageScene->copy();
+}
+
+void MainWindow::cut()
+{
+    if (_imageScene)
+        _imageScene->cut();
+}
+
+void MainWindow::paste()
+{
+    if (_imageScene)
+        _imageScene->paste();
+}
+
+void MainWindow::changeBoxTypeName(QString name)
+{
+    if (_imageScene)
+        _imageScene->changeBoxTypeName(name);
+}
+
+void MainWindow::showEvent(QShowEvent* event)
+{
+    fitViewToWindow();
+}
+
+void MainWindow::resizeEvent(QResizeEvent* event)
+{
+    fitViewToWindow();
+}
+
+bool MainWindow::eventFilter(QObject *obj, QEvent *event)
+{
+    if (obj == _imageScene || obj == _typeNameComboBox || obj == this) {
+        if (event->type() == QEvent::KeyPress) {
+            QKeyEvent *keyEvent = static_cast<QKeyEvent*>(event);
+            // use Key_Down and Key_Up received by _viewScene and MainWindow to select image in fileListView
+            if (keyEvent->key() == Qt::Key_Down || keyEvent->key() == Qt::Key_Up ) {
+                int rowCount = _fileListModel->rowCount(_fileListView->rootIndex());
+                int currentRow = _fileListView->currentIndex().row();
+                if (keyEvent->key() == Qt::Key_Down) {
+                    currentRow = qMin(rowCount-1, currentRow+1);
+                } else if (keyEvent->key() == Qt::Key_Up) {
+                    currentRow = qMax(0, currentRow-1);
+                }
+                QModelIndex index = _fileListModel->index(currentRow,  0, _fileListView->rootIndex());
+                _fileListView->setCurrentIndex(index);
+                return true;
+            }
+            // use Key_PageDown and Key_PageUp to step through the pages of a multi-page image
+            if ((keyEvent->key() == Qt::Key_PageDown || keyEvent->key() == Qt::Key_PageUp)
+                    && _imageScene && _imageScene->pageCount() > 1) {
+                int step = keyEvent->key() == Qt::Key_PageDown ? 1 : -1;
+                _imageScene->showPage(qBound(0, _imageScene->page() + step, _imageScene->pageCount() - 1));
+                return true;
+            }
+        }
+        return false;
+    } else {
+        // pass the event on to the parent class
+        return QMainWindow::eventFilter(obj, event);
+    }
+}
+
+void MainWindow::drawBoxItem(bool checked)
+{
+    if (!_isImageLoaded)
+        return;
+
+    if (_panAct->isChecked()) {
+        _panAct->setChecked(false);
+    }
+    _imageView->drawBoxItem(checked);
+    _imageScene->drawBoxItem(checked);
+}
+
+void MainWindow::panImage(bool checked)
+{
+    if (!_isImageLoaded)
+        return;
+
+    if (_fitToWindowAct->isChecked())
+        _fitToWindowAct->setChecked(false);
+
+    if (_drawAct->isChecked())
+        _drawAct->setChecked(false);
+
+    _imageView->panImage(checked);
+    _imageScene->panImage(checked);
+}
+
+void MainWindow::editTypeNameList()
+{
+    TypeEditDialog* d = new TypeEditDialog(this, _typeNameFile, &_translator);
+    int r = d->exec();
+    if (r == QDialog::Accepted) {
+        delete d;
+    }
+}
+
+void MainWindow::updateCopyCutActions()
+{
+    bool op = _imageScene->selectedItems().count() > 0;
+
+    _copyAct->setEnabled(op);
+    _cutAct->setEnabled(op);
+}
+
+void MainWindow::updatePasteAction()
+{
+    _pasteAct->setEnabled(true);
+}
+
+
+void MainWindow::zoomIn()
+{
+    if (!_isImageLoaded)
+        return;
+
+    if (_fitToWindowAct->isChecked())
+        _fitToWindowAct->setChecked(false);
+
+    _imageView->scale(1.2, 1.2);
+}
+
+void MainWindow::zoomOut()
+{
+    if (!_isImageLoaded)
+        return;
+
+    if (_fitToWindowAct->isChecked())
+        _fitToWindowAct->setChecked(false);
+
+    _imageView->scale(0.8, 0.8);
+}
+
+void MainWindow::wheelEvent(QWheelEvent *event)
+{
+    if (!_isImageLoaded)
+        return;
+
+    if (_fitToWindowAct->isChecked())
+        _fitToWindowAct->setChecked(false);
+
+    qreal newZoom = 1 + (event->delta() / 120.0) * 0.05;
+    _imageView->scale(newZoom, newZoom);
+}
+
+void MainWindow::fitViewToWindow()
+{
+    if (!_isImageLoaded)
+        return;
+    if (!_fitToWindowAct->isChecked())
+        return;
+    if (_panAct->isChecked())
+        _panAct->setChecked(false);
+
+    _imageView->fitInView(_imageView->sceneRect(), Qt::KeepAspectRatio);
+}
+
+void MainWindow::fitViewToActual()
+{
+    if (!_isImageLoaded)
+        return;
+
+    if (_fitToWindowAct->isChecked())
+        _fitToWindowAct->setChecked(false);
+
+    _imageView->fitInView(_imageView->rect(), Qt::KeepAspectRatio); // please check this issue.
+}
+
+void MainWindow::fullScreen()
+{
+    auto makeFullscreen = !isFullScreen();
+
+    _fileListView->setVisible(!makeFullscreen);
+    setWindowState(makeFullscreen ? Qt::WindowFullScreen : Qt::WindowMaximized);
+}
+
+void MainWindow::updateLabelImageSize(QSize imageSize)
+{
+    _imageSize = imageSize;
+    _labelImageInfo->setText(QString(tr("Image: %1 Size: %2 x %3"))
+                             .arg(_selectedImageName)
+                             .arg(_imageSize.width())
+                             .arg(_imageSize.height())
+                             .toUtf8());
+}
+
+void MainWindow::updateBoxInfo(QRect rect, QString typeName)
+{
+    if (typeName.isNull() || rect.isNull())
+    {
+        _labelBoxInfo->setText(QString(tr("Box: x- , y- , w- , h- , type: "))
+                   .toUtf8());
+        return;
+    }
+    _boxRect = rect;
+    _boxTypeName = typeName;
+    _labelBoxInfo->setText(QString(tr("Box: x-%1, y-%2, w-%3, h-%4, type: %5"))
+                           .arg(_boxRect.left())
+                           .arg(_boxRect.top())
+                           .arg(_boxRect.width())
+                           .arg(_boxRect.height())
+                           .arg(_boxTypeName)
+                           .toUtf8());
+    _typeNameComboBox->setCurrentText(_boxTypeName);
+}
+
+void MainWindow::updateLabelCursorPos(QPointF cursorPos)
+{
+    _cursorPos = cursorPos;
+    _labelCursorPos->setText(QString(tr("Cursor: %1, %2"))
+                             .arg((int)_cursorPos.x())
+                             .arg((int)_cursorPos.y())
+                             .toUtf8());
+}
@@ -1,206 +1,300 @@
-/****************************************************************************
-**
-** Copyright (C) 2016 The Qt Company Ltd.
-** Contact: https://www.qt.io/licensing/
-**
-** This file is part of the examples of the Qt Toolkit.
-**
-** $QT_BEGIN_LICENSE:BSD$
-** Commercial License Usage
-** Licensees holding valid commercial Qt licenses may use this file in
-** accordance with the commercial license agreement provided with the
-** Software or, alternatively, in accordance with the terms contained in
-** a written agreement between you and The Qt Company. For licensing terms
-** and conditions see https://www.qt.io/terms-conditions. For further
-** information use the contact form at https://www.qt.io/contact-us.
-**
-** BSD License Usage
-** Alternatively, you may use this file under the terms of the BSD license
-** as follows:
-**
-** "Redistribution and use in source and binary forms, with or without
-** modification, are permitted provided that the following conditions are
-** met:
-**   * Redistributions of source code must retain the above copyright
-**     notice, this list of conditions and the following disclaimer.
-**   * Redistributions in binary form must reproduce the above copyright
-**     notice, this list of conditions and the following disclaimer in
-**     the documentation and/or other materials provided with the
-**     distribution.
-**   * Neither the name of The Qt Company Ltd nor the names of its
-**     contributors may be used to endorse or promote products derived
-**     from this software without specific prior written permission.
-**
-**
-** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
-** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
-** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
-** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
-** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
-** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
-** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
-** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
-** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
-** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
-** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
-**
-** $QT_END_LICENSE$
-**
-****************************************************************************/
-
-#ifndef IMAGEVIEWER_H
-#define IMAGEVIEWER_H
-
-#include <QMainWindow>
-#include <QImage>
-#include <QTranslator>
-#ifndef QT_NO_PRINTER
-#include <QTreeView>
-#include <QGraphicsView>
-#include <QFileSystemModel>
-#include <QSplitter>
-#include <QHBoxLayout>
-#include <QImageReader>
-#endif
-#include "customscene.h"
-#include "customview.h"
-#include <QMessageBox>
-#include <QUndoGroup>
-#include <QIntValidator>
-#include <QLineEdit>
-#include "typeeditdialog.h"
-
-QT_BEGIN_NAMESPACE
-class QAction;
-class QLabel;
-class QMenu;
-class QScrollArea;
-class QScrollBar;
-class QDirModel;
-class QComboBox;
-QT_END_NAMESPACE
-
-//! [0]
-class MainWindow : public QMainWindow
-{
-    Q_OBJECT
-
-public:
-    MainWindow();
-
-private slots:
-    void openFolder();
-    void panImage(bool checked);
-    void zoomIn();
-    void zoomOut();
-    void drawBoxItem(bool checked);
-    void editTypeNameList();
-    void fitViewToWindow();
-    void fitViewToActual();
-    void fullScreen();
-    void help();
-    void about();
-    void selectFile();
-    void onFileSelected(const QItemSelection& selected, const QItemSelection& deselected);
-    void updateLabelImageSize(QSize imageSize);
-    void updateLabelCursorPos(QPointF cursorPos);
-    void updateBoxInfo(QRect rect, QString typeName);
-    void switchLanguage();
-    void saveImageNamesToFile(const QString fileName);
-    void updateCopyCutActions();
-    void updatePasteAction();
-
-private:
-    void wheelEvent(QWheelEvent *event);
-    void resizeEvent(QResizeEvent* event);
-    void showEvent(QShowEvent* event);
-    void createActions();
-    void createCentralWindow();
-    void createMenus();
-    void updateActions();
-    void scaleImage(double factor);
-    void closeEvent(QCloseEvent *event);
-    bool eventFilter(QObject *obj, QEvent *event);
-    void retranslate();
-    QStringList loadTypeNameFromFile(QString filePath);
-    void displayImageView(QString imageFilePath);
-
-    QWidget *_centralWidget;
-    QAction *_fitToWindowAct;
-    QHBoxLayout *_horizontalLayout;
-    QSplitter *_mainSplitter;
-    QTreeView *_fileListView;
-    CustomView *_imageView;
-    CustomScene *_imageScene = nullptr;
-    QDirModel *_fileListModel = nullptr;
-    QStringList _filters;
-    QString _typeNameFile;
-    QStringList _typeNameList;
-    QString _languageFile;
-    bool _isImageLoaded =  false;
-    QString _selectedImageName;
-    QLabel *_labelImageInfo, *_labelImageIndex, *_labelCursorPos, *_labelBoxInfo;
-    QLineEdit *_editImageIndex;
-    QPointF _cursorPos;
-    QSize _imageSize;
-    QRect _boxRect;
-    QString _boxTypeName;
-
-    QTranslator _translator;
-
-    QAction *_zhCNAct, *_enUSAct;
-    QMenu *_fileMenu;
-    QToolBar *_fileToolBar;
-    QAction *_openAct;
-    QAction *_exitAct;
-    QMenu *_editMenu;
-    QToolBar *_editToolBar;
-    QAction *_drawAct;
-    QAction *_editAct;
-    QComboBox *_typeNameComboBox;
-    QAction *_undoAct;
-    QAction *_redoAct;
-    QAction *_copyAct;
-    QAction *_cutAct;
-    QAction *_pasteAct;
-    QUndoGroup *_undoGroup;
-    QMenu *_viewMenu;
-    QToolBar *_viewToolBar;
-    QAction *_panAct;
-    QAction *_zoomInAct;
-    QAction *_zoomOutAct;
-    QAction *_actualSizeAct;
-    QAction *_fullscreenAct;
-    QMenu *_helpMenu;
-    QToolBar *_helpToolBar;
-    QMenu *_languageMenu;
-    QAction *_helpAct;
-    QAction *_aboutAct;
-    QMessageBox _helpMessageBox, _aboutMessageBox;
-    const char *_helpText = "<p>"
-                           "Press <b>Right Mouse Button</b> on selected box to change target type.<br />"
-                           "<hr />"
-                           "<b>Ctrl + D:</b> Draw Box<br />"
-                           "<hr />"
-                           "<b>Delete Key:</b> Delete Selected Box<br />"
-                           "<hr />"
-                           "<b>Ctrl + A:</b> Select All Boxes<br />"
-                           "<hr />"
-                           "<b>Up/Down Arrow Key:</b> Switch images</p>";
-    char _aboutText[1024] = {0};// = "<p><b>Image Labeler</b> is based on Qt 5.10.1 and FreeImage 3.18.</p>";
-
-    const QString _trHelpText = tr("<p>"
-                           "Press <b>Right Mouse Button</b> on selected box to change target type.<br />"
-                           "<hr />"
-                           "<b>Ctrl + D:</b> Draw Box<br />"
-                           "<hr />"
-                           "<b>Delete Key:</b> Delete Selected Box<br />"
-                           "<hr />"
-                           "<b>Ctrl + A:</b> Select All Boxes<br />"
-                           "<hr />"
-                           "<b>Up/Down Arrow Key:</b> Switch images</p>");
-    const QString _trAboutText = tr("<p><b>Image Labeler 2.1.0</b> is based on Qt 5.10.1 and FreeImage 3.18.</p>");
-};
-//! [0]
-
-#endif
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the examples of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** BSD License Usage
+** Alternatively, you may use this file under the terms of the BSD license
+** as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of The Qt Company Ltd nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef IMAGEVIEWER_H
+#define IMAGEVIEWER_H
+
+#include <QMainWindow>
+#include <QImage>
+#include <QTranslator>
+#ifndef QT_NO_PRINTER
+#include <QTreeView>
+#include <QGraphicsView>
+#include <QFileSystemModel>
+#include <QSplitter>
+#include <QHBoxLayout>
+#include <QImageReader>
+#endif
+#include "customscene.h"
+#include "customview.h"
+#include "imageloader.h"
+#include "imagecache.h"
+#include "thumbnailstore.h"
+#include "imageprobe.h"
+#include "imagedecoder.h"
+#include "loadprofiler.h"
+#include "boxitempool.h"
+#include "annotationwriter.h"
+#include "editjournal.h"
+#include "annotationindex.h"
+#include "labelwatcher.h"
+#include <QMessageBox>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QUndoGroup>
+#include <QIntValidator>
+#include <QLineEdit>
+#include "typeeditdialog.h"
+
+QT_BEGIN_NAMESPACE
+class QAction;
+class QLabel;
+class QMenu;
+class QScrollArea;
+class QScrollBar;
+class QDirModel;
+class QComboBox;
+class QSlider;
+class QProgressBar;
+class QProgressDialog;
+class QSpinBox;
+QT_END_NAMESPACE
+
+//! [0]
+class MainWindow : public QMainWindow
+{
+    Q_OBJECT
+
+public:
+    MainWindow();
+
+private slots:
+    void openFolder();
+    void panImage(bool checked);
+    void zoomIn();
+    void zoomOut();
+    void drawBoxItem(bool checked);
+    void editTypeNameList();
+    void fitViewToWindow();
+    void fitViewToActual();
+    void fullScreen();
+    void help();
+    void about();
+    void benchmarkDecoders();
+    void cancelBenchmark();
+    void onBenchmarkFinished();
+    void selectFile();
+    void onFileSelected(const QItemSelection& selected, const QItemSelection& deselected);
+    void updateLabelImageSize(QSize imageSize);
+    void updateLabelCursorPos(QPointF cursorPos);
+    void updateBoxInfo(QRect rect, QString typeName);
+    void switchLanguage();
+    void saveImageNamesToFile(const QString fileName);
+    void updateCopyCutActions();
+    void updatePasteAction();
+    void onPreviewLoaded(int serial, QString path, QImage preview, QSize imageSize);
+    void onImageLoaded(int serial, QString path, ImagePyramid image);
+    void onImagePrefetched(QString path, ImagePyramid image);
+    void onThumbnailReady(QString path);
+    void onSamplesLoaded();
+    void changeWindow();
+    void autoWindow();
+    void onPageChanged(int page, int pageCount);
+    void onFramePainted();
+    void onAnnotationWriteFailed(QString fileName);
+    void onIndexProgress(int indexed, int total);
+    void onIndexReady();
+    void onLabelFilesChanged(QStringList labelFiles);
+    void onJournalRecovered(int files, int conflicts);
+    void onLabelConflict(QString labelFile);
+    void onLabelLinesRejected(QString labelFile, int firstLine, int count);
+    void nextUnlabeled();
+    void previousUnlabeled();
+    void nextWithType();
+    void previousWithType();
+    void nextWithMoreBoxes();
+    void previousWithMoreBoxes();
+    void copy();
+    void cut();
+    void paste();
+    void changeBoxTypeName(QString name);
+
+private:
+    void wheelEvent(QWheelEvent *event);
+    void resizeEvent(QResizeEvent* event);
+    void showEvent(QShowEvent* event);
+    void createActions();
+    void createCentralWindow();
+    void createMenus();
+    void updateActions();
+    void scaleImage(double factor);
+    void closeEvent(QCloseEvent *event);
+    bool eventFilter(QObject *obj, QEvent *event);
+    void retranslate();
+    QStringList loadTypeNameFromFile(QString filePath);
+    void displayImageView(QString imageFilePath);
+    void showImage(const QString &imageFilePath, const ImagePyramid &image, QSize imageSize = QSize());
+    CustomScene *createScene();
+    void updateImageInfoToolTip();
+    void prefetchNeighbours(int row);
+    void updateWindowControls();
+    void jumpToRow(int row);
+    void setJumpActionsEnabled(bool enabled);
+
+    QWidget *_centralWidget;
+    QAction *_fitToWindowAct;
+    QHBoxLayout *_horizontalLayout;
+    QSplitter *_mainSplitter;
+    QTreeView *_fileListView;
+    CustomView *_imageView;
+    CustomScene *_imageScene = nullptr;
+    CustomScene *_backScene = nullptr;
+    UndoHistory _undoHistory;
+    QElapsedTimer _switchTimer;
+    bool _isFirstPixelPending = false;
+    qint64 _firstPixelNsecs = -1;
+    ImageLoader *_imageLoader;
+    ImageCache _imageCache;
+    ThumbnailStore *_thumbnailStore;
+    ThumbnailDelegate *_thumbnailDelegate;
+    AnnotationIndex *_annotationIndex;
+    LabelWatcher *_labelWatcher;
+    QFutureWatcher<QVector<DecoderStats> > _benchmarkWatcher;
+    QProgressDialog *_benchmarkProgress = nullptr;
+    QAtomicInt _isBenchmarkCanceled;
+    int _benchmarkSampleCount = 0;
+    int _prefetchCount;
+    QString _pendingImagePath;
+    QDirModel *_fileListModel = nullptr;
+    QStringList _filters;
+    QString _typeNameFile;
+    QStringList _typeNameList;
+    QString _languageFile;
+    bool _isImageLoaded =  false;
+    QString _selectedImageName;
+    QLabel *_labelImageInfo, *_labelImageIndex, *_labelCursorPos, *_labelBoxInfo, *_labelPage;
+    QLineEdit *_editImageIndex;
+    QProgressBar *_indexProgress;
+    QPointF _cursorPos;
+    QSize _imageSize;
+    QRect _boxRect;
+    QString _boxTypeName;
+
+    QTranslator _translator;
+
+    QAction *_zhCNAct, *_enUSAct;
+    QMenu *_fileMenu;
+    QToolBar *_fileToolBar;
+    QAction *_openAct;
+    QAction *_exitAct;
+    QMenu *_editMenu;
+    QToolBar *_editToolBar;
+    QAction *_drawAct;
+    QAction *_editAct;
+    QComboBox *_typeNameComboBox;
+    QAction *_undoAct;
+    QAction *_redoAct;
+    QAction *_copyAct;
+    QAction *_cutAct;
+    QAction *_pasteAct;
+    QUndoGroup *_undoGroup;
+    QMenu *_viewMenu;
+    QToolBar *_viewToolBar;
+    QAction *_panAct;
+    QAction *_zoomInAct;
+    QAction *_zoomOutAct;
+    QAction *_actualSizeAct;
+    QAction *_fullscreenAct;
+    LoadProfilerDock *_profilerDock;
+    QToolBar *_windowToolBar;
+    QAction *_autoWindowAct;
+    QSlider *_levelSlider, *_widthSlider;
+    QLabel *_labelWindow;
+    bool _isWindowSet = false;
+    quint16 _windowLow = 0, _windowHigh = 0xffff;
+    QMenu *_goMenu;
+    QToolBar *_goToolBar;
+    QAction *_nextUnlabeledAct, *_previousUnlabeledAct;
+    QAction *_nextTypeAct, *_previousTypeAct;
+    QAction *_nextBoxesAct, *_previousBoxesAct;
+    QSpinBox *_boxCountSpinBox;
+    QMenu *_helpMenu;
+    QToolBar *_helpToolBar;
+    QMenu *_languageMenu;
+    QAction *_helpAct;
+    QAction *_benchmarkAct;
+    QAction *_profilerAct;
+    QAction *_aboutAct;
+    QMessageBox _helpMessageBox, _aboutMessageBox;
+    const char *_helpText = "<p>"
+                           "Press <b>Right Mouse Button</b> on selected box to change target type.<br />"
+                           "<hr />"
+                           "<b>Ctrl + D:</b> Draw Box<br />"
+                           "<hr />"
+                           "<b>Delete Key:</b> Delete Selected Box<br />"
+                           "<hr />"
+                           "<b>Ctrl + A:</b> Select All Boxes<br />"
+                           "<hr />"
+                           "<b>Up/Down Arrow Key:</b> Switch images<br />"
+                           "<hr />"
+                           "<b>Page Up/Page Down:</b> Switch pages of multi-page images<br />"
+                           "<hr />"
+                           "<b>Ctrl + U/J/K:</b> Go to the next image without boxes, with the selected target type or with more boxes than given, add <b>Shift</b> to go back</p>";
+    char _aboutText[1024] = {0};// = "<p><b>Image Labeler</b> is based on Qt 5.10.1 and FreeImage 3.18.</p>";
+
+    const QString _trHelpText = tr("<p>"
+                           "Press <b>Right Mouse Button</b> on selected box to change target type.<br />"
+                           "<hr />"
+                           "<b>Ctrl + D:</b> Draw Box<br />"
+                           "<hr />"
+                           "<b>Delete Key:</b> Delete Selected Box<br />"
+                           "<hr />"
+                           "<b>Ctrl + A:</b> Select All Boxes<br />"
+                           "<hr />"
+                           "<b>Up/Down Arrow Key:</b> Switch images<br />"
+                           "<hr />"
+                           "<b>Page Up/Page Down:</b> Switch pages of multi-page images<br />"
+                           "<hr />"
+                           "<b>Ctrl + U/J/K:</b> Go to the next image without boxes, with the selected target type or with more boxes than given, add <b>Shift</b> to go back</p>");
+    const QString _trAboutText = tr("<p><b>Image Labeler 2.1.0</b> is based on Qt 5.10.1 and FreeImage 3.18.</p>");
+};
+//! [0]
+
+#endif
@@ -0,0 +1,104 @@
+#include "multipageimage.h"
+#include "imageconverter.h"
+#include "imageprobe.h"
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSettings>
+#include <climits>
+
+class PageLoadTask : public QRunnable
+{
+public:
+    PageLoadTask(MultiPageImage *image, int index):
+        _image(image),
+        _index(index)
+    {
+    }
+
+    void run() override
+    {
+        QImage page = _image->readPage(_index);
+        QMetaObject::invokeMethod(_image, "insertPage", Qt::QueuedConnection,
+                                  Q_ARG(int, _index), Q_ARG(QImage, page));
+    }
+
+private:
+    MultiPageImage *_image;
+    int _index;
+};
+
+MultiPageImage::MultiPageImage(QObject *parent):
+    QObject(parent)
+{
+    QSettings settings;
+    qint64 budget = settings.value("cache/pageBudgetMB", 64).toLongLong() * 1024;
+    _pages.setMaxCost(int(qMin<qint64>(budget, INT_MAX)));
+    _pool.setMaxThreadCount(1);
+}
+
+MultiPageImage::~MultiPageImage()
+{
+    _pool.clear();
+    _pool.waitForDone();
+    if (_bitmap != nullptr)
+        FreeImage_CloseMultiBitmap(_bitmap, 0);
+}
+
+int MultiPageImage::pageCount(const QString &path)
+{
+    QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix != "tif" && suffix != "tiff" && suffix != "gif")
+        return 1;
+
+    return ImageProbe::pageCount(path);
+}
+
+bool MultiPageImage::open(const QString &path)
+{
+    QByteArray fileName = path.toLocal8Bit();
+    FREE_IMAGE_FORMAT fif = FreeImage_GetFileType(fileName, 0);
+    if (fif != FIF_TIFF && fif != FIF_GIF)
+        return false;
+
+    // GIF frames are composited over the previous ones as they would be played
+    int flags = fif == FIF_GIF ? GIF_PLAYBACK : 0;
+    _bitmap = FreeImage_OpenMultiBitmap(fif, fileName, FALSE, TRUE, FALSE, flags);
+    if (_bitmap == nullptr)
+        return false;
+
+    _pageCount = FreeImage_GetPageCount(_bitmap);
+    return _pageCount > 0;
+}
+
+void MultiPageImage::requestPage(int index)
+{
+    if (index < 0 || index >= _pageCount || _pages.contains(index) || _pending.contains(index))
+        return;
+
+    _pending.insert(index);
+    _pool.start(new PageLoadTask(this, index));
+}
+
+void MultiPageImage::insertPage(int index, QImage image)
+{
+    _pending.remove(index);
+    if (image.isNull())
+        return;
+
+    int cost = int(qMax<qint64>(1, image.sizeInBytes() / 1024));
+    _pages.insert(index, new QImage(image), cost);
+    emit pageReady(index);
+}
+
+QImage MultiPageImage::readPage(int index)
+{
+    FIBITMAP *dib = FreeImage_LockPage(_bitmap, index);
+    if (dib == nullptr)
+        return QImage();
+
+    // the locked page belongs to the multipage bitmap, convert a copy
+    FIBITMAP *copy = FreeImage_Clone(dib);
+    FreeImage_UnlockPage(_bitmap, dib, FALSE);
+
+    return ImageConverter::toQImage(copy);
+}
@@ -0,0 +1,58 @@
+#ifndef MULTIPAGEIMAGE_H
+#define MULTIPAGEIMAGE_H
+
+#include <QObject>
+#include <QImage>
+#include <QCache>
+#include <QSet>
+#include <QThreadPool>
+#include "FreeImage.h"
+
+/**
+ * @brief The MultiPageImage class decodes single pages of a multi-page
+ *        TIFF or an animated GIF on demand.
+ *
+ * The file is opened once through FreeImage's multipage API and pages are
+ * decoded on a single worker, since the handle is not thread safe. Decoded
+ * pages are kept in a cache bounded by their size in memory.
+ */
+class MultiPageImage : public QObject
+{
+    Q_OBJECT
+public:
+    MultiPageImage(QObject *parent = 0);
+    ~MultiPageImage();
+
+    // 1 for files that cannot be opened as multi-page images
+    static int pageCount(const QString &path);
+    bool open(const QString &path);
+    int pageCount() const
+    {
+        return _pageCount;
+    }
+
+    QImage *page(int index)
+    {
+        return _pages.object(index);
+    }
+    void requestPage(int index);
+
+signals:
+    void pageReady(int index);
+
+private slots:
+    void insertPage(int index, QImage image);
+
+private:
+    friend class PageLoadTask;
+
+    QImage readPage(int index);
+
+    FIMULTIBITMAP *_bitmap = nullptr;
+    int _pageCount = 0;
+    QCache<int, QImage> _pages;
+    QSet<int> _pending;
+    QThreadPool _pool;
+};
+
+#endif // MULTIPAGEIMAGE_H
@@ -0,0 +1,380 @@
+#include "pixelconverter.h"
+#include <QAtomicInt>
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define PIXELCONVERTER_X86
+#define TARGET_SSE4 __attribute__((target("ssse3,sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+static QAtomicInt currentKernel(-1);
+
+static inline quint32 premultiplyPixel(quint32 p)
+{
+    // per channel (c * a + ((c * a) >> 8) + 0x80) >> 8, the same rounding as qPremultiply()
+    quint32 a = p >> 24;
+    quint32 t = (p & 0xff00ff) * a;
+    t = ((t + ((t >> 8) & 0xff00ff) + 0x800080) >> 8) & 0xff00ff;
+    quint32 g = ((p >> 8) & 0xff) * a;
+    g = (g + (g >> 8) + 0x80) & 0xff00;
+
+    return (a << 24) | g | t;
+}
+
+static inline quint32 scaleFactor(quint16 min, quint16 max)
+{
+    // 16.16 fixed point, (max - min) * scale never exceeds 255 << 16
+    return (255u << 16) / quint32(qMax(1, max - min));
+}
+
+static void bgr24ToRgb32Scalar(const uchar *src, quint32 *dst, int count)
+{
+    for (int i = 0; i < count; i++, src += 3) {
+        dst[i] = 0xff000000 | (quint32(src[2]) << 16) | (quint32(src[1]) << 8) | src[0];
+    }
+}
+
+static void gray8ToRgb32Scalar(const uchar *src, quint32 *dst, int count)
+{
+    for (int i = 0; i < count; i++) {
+        dst[i] = 0xff000000 | (quint32(src[i]) * 0x010101);
+    }
+}
+
+static void premultiplyScalar(const quint32 *src, quint32 *dst, int count)
+{
+    for (int i = 0; i < count; i++) {
+        dst[i] = premultiplyPixel(src[i]);
+    }
+}
+
+static void scale16To8Scalar(const quint16 *src, uchar *dst, int count, quint16 min, quint16 max)
+{
+    quint32 scale = scaleFactor(min, max);
+    for (int i = 0; i < count; i++) {
+        quint32 value = qMin(qMax(src[i], min), max) - min;
+        dst[i] = uchar((value * scale + 0x8000) >> 16);
+    }
+}
+
+static void minMax16Scalar(const quint16 *src, int count, quint16 *min, quint16 *max)
+{
+    for (int i = 0; i < count; i++) {
+        *min = qMin(*min, src[i]);
+        *max = qMax(*max, src[i]);
+    }
+}
+
+#ifdef PIXELCONVERTER_X86
+TARGET_SSE4 static void bgr24ToRgb32SSE4(const uchar *src, quint32 *dst, int count)
+{
+    const __m128i mask = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+    int i = 0;
+    // a 16 byte load covers 4 pixels and spills into the 6th
+    for (; i + 6 <= count; i += 4) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 3 * i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_or_si128(_mm_shuffle_epi8(p, mask), alpha));
+    }
+    bgr24ToRgb32Scalar(src + 3 * i, dst + i, count - i);
+}
+
+TARGET_AVX2 static void bgr24ToRgb32AVX2(const uchar *src, quint32 *dst, int count)
+{
+    const __m256i mask = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                          0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i alpha = _mm256_set1_epi32(int(0xff000000));
+    int i = 0;
+    // two 16 byte loads 12 bytes apart cover 8 pixels and spill into the 10th
+    for (; i + 10 <= count; i += 8) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 3 * i));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 3 * i + 12));
+        __m256i p = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                            _mm256_or_si256(_mm256_shuffle_epi8(p, mask), alpha));
+    }
+    bgr24ToRgb32Scalar(src + 3 * i, dst + i, count - i);
+}
+
+TARGET_SSE4 static void gray8ToRgb32SSE4(const uchar *src, quint32 *dst, int count)
+{
+    const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i lo = _mm_unpacklo_epi8(g, g);
+        __m128i hi = _mm_unpackhi_epi8(g, g);
+        __m128i *d = reinterpret_cast<__m128i *>(dst + i);
+        _mm_storeu_si128(d, _mm_or_si128(_mm_unpacklo_epi16(lo, lo), alpha));
+        _mm_storeu_si128(d + 1, _mm_or_si128(_mm_unpackhi_epi16(lo, lo), alpha));
+        _mm_storeu_si128(d + 2, _mm_or_si128(_mm_unpacklo_epi16(hi, hi), alpha));
+        _mm_storeu_si128(d + 3, _mm_or_si128(_mm_unpackhi_epi16(hi, hi), alpha));
+    }
+    gray8ToRgb32Scalar(src + i, dst + i, count - i);
+}
+
+TARGET_AVX2 static void gray8ToRgb32AVX2(const uchar *src, quint32 *dst, int count)
+{
+    const __m256i mask = _mm256_setr_epi8(0, 0, 0, -1, 4, 4, 4, -1, 8, 8, 8, -1, 12, 12, 12, -1,
+                                          0, 0, 0, -1, 4, 4, 4, -1, 8, 8, 8, -1, 12, 12, 12, -1);
+    const __m256i alpha = _mm256_set1_epi32(int(0xff000000));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i g = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                            _mm256_or_si256(_mm256_shuffle_epi8(g, mask), alpha));
+    }
+    gray8ToRgb32Scalar(src + i, dst + i, count - i);
+}
+
+TARGET_SSE4 static inline __m128i premultiplyHalf(__m128i p)
+{
+    // p holds two pixels as 16-bit channels
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(p, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i t = _mm_mullo_epi16(p, a);
+    t = _mm_add_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), _mm_set1_epi16(0x80));
+    return _mm_srli_epi16(t, 8);
+}
+
+TARGET_SSE4 static void premultiplySSE4(const quint32 *src, quint32 *dst, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32(int(0xff000000));
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i lo = premultiplyHalf(_mm_unpacklo_epi8(p, zero));
+        __m128i hi = premultiplyHalf(_mm_unpackhi_epi8(p, zero));
+        // the alpha channel itself is kept as is
+        __m128i result = _mm_blendv_epi8(_mm_packus_epi16(lo, hi), p, alphaMask);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), result);
+    }
+    premultiplyScalar(src + i, dst + i, count - i);
+}
+
+TARGET_AVX2 static inline __m256i premultiplyHalf(__m256i p)
+{
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(p, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m256i t = _mm256_mullo_epi16(p, a);
+    t = _mm256_add_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), _mm256_set1_epi16(0x80));
+    return _mm256_srli_epi16(t, 8);
+}
+
+TARGET_AVX2 static void premultiplyAVX2(const quint32 *src, quint32 *dst, int count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alphaMask = _mm256_set1_epi32(int(0xff000000));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // unpack and pack both work within 128-bit lanes, so the pixel order is kept
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        __m256i lo = premultiplyHalf(_mm256_unpacklo_epi8(p, zero));
+        __m256i hi = premultiplyHalf(_mm256_unpackhi_epi8(p, zero));
+        __m256i result = _mm256_blendv_epi8(_mm256_packus_epi16(lo, hi), p, alphaMask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), result);
+    }
+    premultiplyScalar(src + i, dst + i, count - i);
+}
+
+TARGET_SSE4 static void scale16To8SSE4(const quint16 *src, uchar *dst, int count, quint16 min, quint16 max)
+{
+    const __m128i vmin = _mm_set1_epi16(short(min));
+    const __m128i vmax = _mm_set1_epi16(short(max));
+    const __m128i scale = _mm_set1_epi32(int(scaleFactor(min, max)));
+    const __m128i round = _mm_set1_epi32(0x8000);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        v = _mm_sub_epi16(_mm_min_epu16(_mm_max_epu16(v, vmin), vmax), vmin);
+        __m128i lo = _mm_cvtepu16_epi32(v);
+        __m128i hi = _mm_cvtepu16_epi32(_mm_srli_si128(v, 8));
+        lo = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(lo, scale), round), 16);
+        hi = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(hi, scale), round), 16);
+        __m128i words = _mm_packus_epi32(lo, hi);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(words, words));
+    }
+    scale16To8Scalar(src + i, dst + i, count - i, min, max);
+}
+
+TARGET_AVX2 static void scale16To8AVX2(const quint16 *src, uchar *dst, int count, quint16 min, quint16 max)
+{
+    const __m256i vmin = _mm256_set1_epi16(short(min));
+    const __m256i vmax = _mm256_set1_epi16(short(max));
+    const __m256i scale = _mm256_set1_epi32(int(scaleFactor(min, max)));
+    const __m256i round = _mm256_set1_epi32(0x8000);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        v = _mm256_sub_epi16(_mm256_min_epu16(_mm256_max_epu16(v, vmin), vmax), vmin);
+        __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(v));
+        __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1));
+        lo = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(lo, scale), round), 16);
+        hi = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(hi, scale), round), 16);
+        // the lane-wise pack interleaves lo and hi, put the quarters back in order
+        __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), bytes);
+    }
+    scale16To8Scalar(src + i, dst + i, count - i, min, max);
+}
+
+TARGET_SSE4 static void minMax16SSE4(const quint16 *src, int count, quint16 *min, quint16 *max)
+{
+    int i = 0;
+    if (count >= 8) {
+        __m128i vmin = _mm_set1_epi16(-1);
+        __m128i vmax = _mm_setzero_si128();
+        for (; i + 8 <= count; i += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            vmin = _mm_min_epu16(vmin, v);
+            vmax = _mm_max_epu16(vmax, v);
+        }
+        // minpos finds the smallest lane, the largest one is the smallest of the complement
+        quint16 laneMin = quint16(_mm_cvtsi128_si32(_mm_minpos_epu16(vmin)));
+        quint16 laneMax = quint16(~_mm_cvtsi128_si32(_mm_minpos_epu16(_mm_xor_si128(vmax, _mm_set1_epi16(-1)))));
+        *min = qMin(*min, laneMin);
+        *max = qMax(*max, laneMax);
+    }
+    minMax16Scalar(src + i, count - i, min, max);
+}
+
+TARGET_AVX2 static void minMax16AVX2(const quint16 *src, int count, quint16 *min, quint16 *max)
+{
+    int i = 0;
+    if (count >= 16) {
+        __m256i vmin = _mm256_set1_epi16(-1);
+        __m256i vmax = _mm256_setzero_si256();
+        for (; i + 16 <= count; i += 16) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+            vmin = _mm256_min_epu16(vmin, v);
+            vmax = _mm256_max_epu16(vmax, v);
+        }
+        __m128i min8 = _mm_min_epu16(_mm256_castsi256_si128(vmin), _mm256_extracti128_si256(vmin, 1));
+        __m128i max8 = _mm_max_epu16(_mm256_castsi256_si128(vmax), _mm256_extracti128_si256(vmax, 1));
+        quint16 laneMin = quint16(_mm_cvtsi128_si32(_mm_minpos_epu16(min8)));
+        quint16 laneMax = quint16(~_mm_cvtsi128_si32(_mm_minpos_epu16(_mm_xor_si128(max8, _mm_set1_epi16(-1)))));
+        *min = qMin(*min, laneMin);
+        *max = qMax(*max, laneMax);
+    }
+    minMax16Scalar(src + i, count - i, min, max);
+}
+#endif
+
+PixelConverter::Kernel PixelConverter::bestKernel()
+{
+#ifdef PIXELCONVERTER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return AVX2;
+    if (__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1"))
+        return SSE4;
+#endif
+    return Scalar;
+}
+
+PixelConverter::Kernel PixelConverter::kernel()
+{
+    int k = currentKernel.load();
+    if (k < 0) {
+        k = bestKernel();
+        currentKernel.store(k);
+    }
+
+    return Kernel(k);
+}
+
+void PixelConverter::setKernel(Kernel kernel)
+{
+    // never hand out a kernel the CPU cannot run
+    currentKernel.store(qMin(kernel, bestKernel()));
+}
+
+void PixelConverter::bgr24ToRgb32(const uchar *src, quint32 *dst, int count)
+{
+    switch (kernel()) {
+#ifdef PIXELCONVERTER_X86
+    case AVX2:
+        bgr24ToRgb32AVX2(src, dst, count);
+        break;
+    case SSE4:
+        bgr24ToRgb32SSE4(src, dst, count);
+        break;
+#endif
+    default:
+        bgr24ToRgb32Scalar(src, dst, count);
+        break;
+    }
+}
+
+void PixelConverter::gray8ToRgb32(const uchar *src, quint32 *dst, int count)
+{
+    switch (kernel()) {
+#ifdef PIXELCONVERTER_X86
+    case AVX2:
+        gray8ToRgb32AVX2(src, dst, count);
+        break;
+    case SSE4:
+        gray8ToRgb32SSE4(src, dst, count);
+        break;
+#endif
+    default:
+        gray8ToRgb32Scalar(src, dst, count);
+        break;
+    }
+}
+
+void PixelConverter::premultiply(const quint32 *src, quint32 *dst, int count)
+{
+    switch (kernel()) {
+#ifdef PIXELCONVERTER_X86
+    case AVX2:
+        premultiplyAVX2(src, dst, count);
+        break;
+    case SSE4:
+        premultiplySSE4(src, dst, count);
+        break;
+#endif
+    default:
+        premultiplyScalar(src, dst, count);
+        break;
+    }
+}
+
+void PixelConverter::scale16To8(const quint16 *src, uchar *dst, int count, quint16 min, quint16 max)
+{
+    max = qMax(min, max);
+    switch (kernel()) {
+#ifdef PIXELCONVERTER_X86
+    case AVX2:
+        scale16To8AVX2(src, dst, count, min, max);
+        break;
+    case SSE4:
+        scale16To8SSE4(src, dst, count, min, max);
+        break;
+#endif
+    default:
+        scale16To8Scalar(src, dst, count, min, max);
+        break;
+    }
+}
+
+void PixelConverter::minMax16(const quint16 *src, int count, quint16 *min, quint16 *max)
+{
+    *min = 0xffff;
+    *max = 0;
+    switch (kernel()) {
+#ifdef PIXELCONVERTER_X86
+    case AVX2:
+        minMax16AVX2(src, count, min, max);
+        break;
+    case SSE4:
+        minMax16SSE4(src, count, min, max);
+        break;
+#endif
+    default:
+        minMax16Scalar(src, count, min, max);
+        break;
+    }
+    if (count <= 0)
+        *min = 0;
+}
@@ -0,0 +1,40 @@
+#ifndef PIXELCONVERTER_H
+#define PIXELCONVERTER_H
+
+#include <QtGlobal>
+
+/**
+ * @brief The PixelConverter class converts rows of pixels between the
+ *        layouts produced by the decoders and the ones Qt displays.
+ *
+ * Every conversion has a scalar reference and, on x86 builds with GCC or
+ * Clang, SSE4.1 and AVX2 kernels compiled with target attributes. The
+ * fastest kernel supported by the CPU is chosen on first use; all kernels
+ * give bit-identical results to the scalar one.
+ */
+class PixelConverter
+{
+public:
+    enum Kernel {
+        Scalar,
+        SSE4,
+        AVX2
+    };
+
+    static Kernel kernel();
+    static Kernel bestKernel();
+    // Forces a kernel, for comparing against the scalar reference.
+    static void setKernel(Kernel kernel);
+
+    // B, G, R bytes to 0xffRRGGBB
+    static void bgr24ToRgb32(const uchar *src, quint32 *dst, int count);
+    // gray bytes to 0xffGGGGGG
+    static void gray8ToRgb32(const uchar *src, quint32 *dst, int count);
+    // 0xAARRGGBB to premultiplied alpha, rounded like qPremultiply()
+    static void premultiply(const quint32 *src, quint32 *dst, int count);
+    // linear map of [min, max] to [0, 255], values outside are clamped
+    static void scale16To8(const quint16 *src, uchar *dst, int count, quint16 min, quint16 max);
+    static void minMax16(const quint16 *src, int count, quint16 *min, quint16 *max);
+};
+
+#endif // PIXELCONVERTER_H
@@ -0,0 +1,163 @@
+#include "sampleimage.h"
+#include "pixelconverter.h"
+#include <QtNumeric>
+#include <climits>
+#include <cstring>
+
+static inline quint16 normalize(float value, double low, double range)
+{
+    if (qIsNaN(value))
+        return 0;
+    if (qIsInf(value))
+        return value < 0 ? 0 : 0xffff;
+    return quint16(qBound(0.0, (value - low) / range * 65535 + 0.5, 65535.0));
+}
+
+bool SampleImage::hasHighDepth(FIBITMAP *dib)
+{
+    switch (FreeImage_GetImageType(dib)) {
+    case FIT_UINT16:
+    case FIT_INT16:
+    case FIT_FLOAT:
+    case FIT_RGB16:
+    case FIT_RGBA16:
+    case FIT_RGBF:
+        return true;
+    default:
+        return false;
+    }
+}
+
+SampleImage SampleImage::fromBitmap(FIBITMAP *dib)
+{
+    SampleImage image;
+    if (dib == nullptr || !hasHighDepth(dib))
+        return image;
+
+    FREE_IMAGE_TYPE type = FreeImage_GetImageType(dib);
+    int width = FreeImage_GetWidth(dib);
+    int height = FreeImage_GetHeight(dib);
+    int channels = (type == FIT_RGB16 || type == FIT_RGBA16 || type == FIT_RGBF) ? 3 : 1;
+    qint64 count = qint64(width) * height * channels;
+    if (count <= 0 || count > INT_MAX)
+        return image;
+
+    // float samples are spread over 16 bits from their finite range
+    double low = 0, range = 1;
+    if (type == FIT_FLOAT || type == FIT_RGBF) {
+        double minimum = 0, maximum = 0;
+        bool found = false;
+        for (int y = 0; y < height; y++) {
+            const float *src = reinterpret_cast<const float *>(FreeImage_GetScanLine(dib, y));
+            for (int x = 0; x < width * channels; x++) {
+                if (!qIsFinite(src[x]))
+                    continue;
+                minimum = found ? qMin(minimum, double(src[x])) : src[x];
+                maximum = found ? qMax(maximum, double(src[x])) : src[x];
+                found = true;
+            }
+        }
+        low = minimum;
+        range = maximum > minimum ? maximum - minimum : 1;
+        image._valueOffset = low;
+        image._valueScale = range / 65535;
+    } else if (type == FIT_INT16) {
+        image._valueOffset = -32768;
+    }
+
+    image._size = QSize(width, height);
+    image._channels = channels;
+    image._samples.resize(int(count));
+    for (int y = 0; y < height; y++) {
+        // FreeImage stores scanlines bottom-up
+        const BYTE *line = FreeImage_GetScanLine(dib, height - 1 - y);
+        quint16 *dst = image._samples.data() + qint64(y) * width * channels;
+        switch (type) {
+        case FIT_UINT16:
+            memcpy(dst, line, width * sizeof(quint16));
+            break;
+        case FIT_INT16: {
+            const qint16 *src = reinterpret_cast<const qint16 *>(line);
+            for (int x = 0; x < width; x++) {
+                dst[x] = quint16(src[x] + 32768);
+            }
+            break;
+        }
+        case FIT_FLOAT: {
+            const float *src = reinterpret_cast<const float *>(line);
+            for (int x = 0; x < width; x++) {
+                dst[x] = normalize(src[x], low, range);
+            }
+            break;
+        }
+        case FIT_RGB16: {
+            const FIRGB16 *src = reinterpret_cast<const FIRGB16 *>(line);
+            for (int x = 0; x < width; x++, dst += 3) {
+                dst[0] = src[x].blue;
+                dst[1] = src[x].green;
+                dst[2] = src[x].red;
+            }
+            break;
+        }
+        case FIT_RGBA16: {
+            const FIRGBA16 *src = reinterpret_cast<const FIRGBA16 *>(line);
+            for (int x = 0; x < width; x++, dst += 3) {
+                dst[0] = src[x].blue;
+                dst[1] = src[x].green;
+                dst[2] = src[x].red;
+            }
+            break;
+        }
+        case FIT_RGBF: {
+            const FIRGBF *src = reinterpret_cast<const FIRGBF *>(line);
+            for (int x = 0; x < width; x++, dst += 3) {
+                dst[0] = normalize(src[x].blue, low, range);
+                dst[1] = normalize(src[x].green, low, range);
+                dst[2] = normalize(src[x].red, low, range);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    PixelConverter::minMax16(image._samples.constData(), image._samples.size(),
+                             &image._minimum, &image._maximum);
+
+    return image;
+}
+
+QImage SampleImage::map(const QRect &rect, int step, quint16 low, quint16 high) const
+{
+    QImage image(rect.size(), QImage::Format_RGB32);
+    if (image.isNull() || isNull())
+        return image;
+
+    int rowLength = rect.width() * _channels;
+    QVector<quint16> gathered(step > 1 ? rowLength : 0);
+    QVector<uchar> bytes(rowLength);
+    for (int y = 0; y < rect.height(); y++) {
+        int sy = qMin((rect.y() + y) * step, _size.height() - 1);
+        const quint16 *line = _samples.constData() + qint64(sy) * _size.width() * _channels;
+        const quint16 *src = line + qint64(rect.x()) * _channels;
+        if (step > 1) {
+            // nearest sample of every step x step block
+            for (int x = 0; x < rect.width(); x++) {
+                int sx = qMin((rect.x() + x) * step, _size.width() - 1);
+                for (int c = 0; c < _channels; c++) {
+                    gathered[x * _channels + c] = line[sx * _channels + c];
+                }
+            }
+            src = gathered.constData();
+        }
+
+        PixelConverter::scale16To8(src, bytes.data(), rowLength, low, high);
+        quint32 *dst = reinterpret_cast<quint32 *>(image.scanLine(y));
+        if (_channels == 1)
+            PixelConverter::gray8ToRgb32(bytes.constData(), dst, rect.width());
+        else
+            PixelConverter::bgr24ToRgb32(bytes.constData(), dst, rect.width());
+    }
+
+    return image;
+}
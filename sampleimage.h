@@ -0,0 +1,71 @@
+#ifndef SAMPLEIMAGE_H
+#define SAMPLEIMAGE_H
+
+#include <QImage>
+#include <QRect>
+#include <QVector>
+#include "FreeImage.h"
+
+/**
+ * @brief The SampleImage class keeps the samples of a 16-bit or float
+ *        image, gray or RGB, so that they can be mapped to the display
+ *        with different windows without decoding the file again.
+ *
+ * Samples are stored top-down as 16-bit values, RGB interleaved in B, G, R
+ * order. Float samples are normalized from their finite range, which
+ * valueAt() maps back for display.
+ */
+class SampleImage
+{
+public:
+    SampleImage()
+    {
+    }
+
+    static bool hasHighDepth(FIBITMAP *dib);
+    // Does not take ownership of dib.
+    static SampleImage fromBitmap(FIBITMAP *dib);
+
+    bool isNull() const
+    {
+        return _samples.isEmpty();
+    }
+    QSize size() const
+    {
+        return _size;
+    }
+    int channels() const
+    {
+        return _channels;
+    }
+    quint16 minimum() const
+    {
+        return _minimum;
+    }
+    quint16 maximum() const
+    {
+        return _maximum;
+    }
+    double valueAt(quint16 sample) const
+    {
+        return _valueOffset + sample * _valueScale;
+    }
+    qint64 sizeInBytes() const
+    {
+        return qint64(_samples.size()) * sizeof(quint16);
+    }
+
+    // Maps rect of the image subsampled by step, window [low, high] to [0, 255].
+    QImage map(const QRect &rect, int step, quint16 low, quint16 high) const;
+
+private:
+    QSize _size;
+    int _channels = 1;
+    QVector<quint16> _samples;
+    quint16 _minimum = 0;
+    quint16 _maximum = 0;
+    double _valueOffset = 0;
+    double _valueScale = 1;
+};
+
+#endif // SAMPLEIMAGE_H
@@ -0,0 +1,72 @@
+#include "sampleimageitem.h"
+#include <QPainter>
+
+static const int TileSize = 256;
+// costs are in KiB
+static const int TileBudget = 64 * 1024;
+
+SampleImageItem::SampleImageItem(const SampleImage &samples, QGraphicsItem *parent):
+    QGraphicsItem(parent),
+    _samples(samples),
+    _low(samples.minimum()),
+    _high(samples.maximum()),
+    _tiles(TileBudget)
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+void SampleImageItem::setWindow(quint16 low, quint16 high)
+{
+    if (low == _low && high == _high)
+        return;
+
+    // only the tiles painted next are mapped again
+    _low = low;
+    _high = high;
+    _tiles.clear();
+    update();
+}
+
+QRectF SampleImageItem::boundingRect() const
+{
+    return QRectF(QPointF(0, 0), _samples.size());
+}
+
+void SampleImageItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+
+    qreal scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    int step = 1;
+    while (step < 64 && step * 2 * scale <= 1)
+        step *= 2;
+
+    QRectF exposed = option->exposedRect.intersected(boundingRect());
+    if (exposed.isEmpty())
+        return;
+
+    QSize size = _samples.size();
+    QRect level(0, 0, (size.width() + step - 1) / step, (size.height() + step - 1) / step);
+    int firstColumn = int(exposed.left() / step) / TileSize;
+    int lastColumn = qMin(int(exposed.right() / step), level.width() - 1) / TileSize;
+    int firstRow = int(exposed.top() / step) / TileSize;
+    int lastRow = qMin(int(exposed.bottom() / step), level.height() - 1) / TileSize;
+
+    painter->save();
+    painter->setClipRect(boundingRect(), Qt::IntersectClip);
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, scale < 1);
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn; column <= lastColumn; column++) {
+            QRect rect = QRect(column * TileSize, row * TileSize, TileSize, TileSize).intersected(level);
+            quint64 key = (quint64(step) << 48) | (quint64(row) << 24) | quint64(column);
+            QImage *tile = _tiles.object(key);
+            if (tile == nullptr) {
+                tile = new QImage(_samples.map(rect, step, _low, _high));
+                _tiles.insert(key, tile, int(qMax<qint64>(1, tile->sizeInBytes() / 1024)));
+            }
+            painter->drawImage(QRectF(rect.x() * step, rect.y() * step,
+                                      rect.width() * step, rect.height() * step), *tile);
+        }
+    }
+    painter->restore();
+}
@@ -0,0 +1,45 @@
+#ifndef SAMPLEIMAGEITEM_H
+#define SAMPLEIMAGEITEM_H
+
+#include <QGraphicsItem>
+#include <QStyleOptionGraphicsItem>
+#include <QCache>
+#include "sampleimage.h"
+
+/**
+ * @brief The SampleImageItem class paints a SampleImage through the current
+ *        window, mapping only the tiles that intersect the exposed area.
+ *
+ * Mapped tiles are cached until the window changes; zoomed out, tiles are
+ * mapped from every n-th sample.
+ */
+class SampleImageItem : public QGraphicsItem
+{
+public:
+    SampleImageItem(const SampleImage &samples, QGraphicsItem *parent = 0);
+
+    const SampleImage &samples() const
+    {
+        return _samples;
+    }
+    void setWindow(quint16 low, quint16 high);
+    quint16 low() const
+    {
+        return _low;
+    }
+    quint16 high() const
+    {
+        return _high;
+    }
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    SampleImage _samples;
+    quint16 _low;
+    quint16 _high;
+    QCache<quint64, QImage> _tiles;
+};
+
+#endif // SAMPLEIMAGEITEM_H
@@ -0,0 +1,12 @@
+TARGET = tst_imageconverter
+include(../tests.pri)
+
+# the benchmarks are only meaningful in a release build:
+# qmake CONFIG+=release && make && ./tst_imageconverter
+HEADERS = \
+    ../../imageconverter.h \
+    ../../pixelconverter.h
+SOURCES = \
+    tst_imageconverter.cpp \
+    ../../imageconverter.cpp \
+    ../../pixelconverter.cpp
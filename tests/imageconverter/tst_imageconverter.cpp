@@ -0,0 +1,153 @@
+#include <QtTest>
+#include "imageconverter.h"
+
+/**
+ * Checks that decoded 24 and 32-bit bitmaps come out of the converter
+ * with their pixels, and measures the conversion of 4K and 20 MP frames
+ * next to the JPEG round trip through memory it replaced.
+ */
+class TestImageConverter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void pixels_data();
+    void pixels();
+    void toQImage_data();
+    void toQImage();
+    void jpegRoundTrip_data();
+    void jpegRoundTrip();
+
+private:
+    static void addFrames();
+    static FIBITMAP *frame(int width, int height, int bpp);
+    static QRgb expectedPixel(int x, int y);
+};
+
+void TestImageConverter::addFrames()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+    QTest::addColumn<int>("bpp");
+
+    QTest::newRow("4K 24-bit") << 3840 << 2160 << 24;
+    QTest::newRow("4K 32-bit") << 3840 << 2160 << 32;
+    QTest::newRow("20MP 24-bit") << 5472 << 3648 << 24;
+    QTest::newRow("20MP 32-bit") << 5472 << 3648 << 32;
+}
+
+QRgb TestImageConverter::expectedPixel(int x, int y)
+{
+    // a gradient with some texture, so the JPEG encoder has work to do
+    return qRgb(x & 0xff, y & 0xff, (x * 7 + y * 13) & 0xff);
+}
+
+FIBITMAP *TestImageConverter::frame(int width, int height, int bpp)
+{
+    FIBITMAP *dib = FreeImage_Allocate(width, height, bpp);
+    if (dib == nullptr)
+        return nullptr;
+
+    int step = bpp / 8;
+    for (int y = 0; y < height; y++) {
+        // scanlines are stored bottom-up
+        BYTE *line = FreeImage_GetScanLine(dib, height - 1 - y);
+        for (int x = 0; x < width; x++, line += step) {
+            QRgb pixel = expectedPixel(x, y);
+            line[FI_RGBA_RED] = BYTE(qRed(pixel));
+            line[FI_RGBA_GREEN] = BYTE(qGreen(pixel));
+            line[FI_RGBA_BLUE] = BYTE(qBlue(pixel));
+            if (bpp == 32)
+                line[FI_RGBA_ALPHA] = 0xff;
+        }
+    }
+    return dib;
+}
+
+void TestImageConverter::pixels_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+    QTest::addColumn<int>("bpp");
+
+    // odd sizes, so a row is not a multiple of any SIMD width
+    QTest::newRow("24-bit") << 67 << 45 << 24;
+    QTest::newRow("32-bit") << 67 << 45 << 32;
+}
+
+void TestImageConverter::pixels()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+    QFETCH(int, bpp);
+
+    QImage image = ImageConverter::toQImage(frame(width, height, bpp));
+    QCOMPARE(image.size(), QSize(width, height));
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            QCOMPARE(image.pixel(x, y), expectedPixel(x, y));
+        }
+    }
+}
+
+void TestImageConverter::toQImage_data()
+{
+    addFrames();
+}
+
+void TestImageConverter::toQImage()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+    QFETCH(int, bpp);
+
+    FIBITMAP *dib = frame(width, height, bpp);
+    QVERIFY(dib != nullptr);
+
+    // the converter takes ownership, every run gets a copy as a decoder would hand it over
+    QImage image;
+    QBENCHMARK {
+        image = ImageConverter::toQImage(FreeImage_Clone(dib));
+    }
+    FreeImage_Unload(dib);
+    QCOMPARE(image.size(), QSize(width, height));
+}
+
+void TestImageConverter::jpegRoundTrip_data()
+{
+    addFrames();
+}
+
+void TestImageConverter::jpegRoundTrip()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+    QFETCH(int, bpp);
+
+    FIBITMAP *dib = frame(width, height, bpp);
+    QVERIFY(dib != nullptr);
+
+    // what CustomScene::loadImage did before the converter, plus the same copy as above
+    QImage image;
+    QBENCHMARK {
+        FIBITMAP *copy = FreeImage_Clone(dib);
+        FIMEMORY *stream = FreeImage_OpenMemory();
+        FIBITMAP *dib24 = FreeImage_ConvertTo24Bits(copy);
+        FreeImage_SaveToMemory(FIF_JPEG, dib24, stream);
+
+        BYTE *buffer = nullptr;
+        DWORD size = 0;
+        FreeImage_AcquireMemory(stream, &buffer, &size);
+        image = QImage();
+        image.loadFromData(QByteArray::fromRawData(reinterpret_cast<char *>(buffer), int(size)));
+
+        FreeImage_CloseMemory(stream);
+        FreeImage_Unload(dib24);
+        FreeImage_Unload(copy);
+    }
+    FreeImage_Unload(dib);
+    QCOMPARE(image.size(), QSize(width, height));
+}
+
+QTEST_MAIN(TestImageConverter)
+#include "tst_imageconverter.moc"
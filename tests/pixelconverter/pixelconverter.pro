@@ -0,0 +1,8 @@
+TARGET = tst_pixelconverter
+include(../tests.pri)
+
+HEADERS = \
+    ../../pixelconverter.h
+SOURCES = \
+    tst_pixelconverter.cpp \
+    ../../pixelconverter.cpp
@@ -0,0 +1,219 @@
+#include <QtTest>
+#include <QColor>
+#include "pixelconverter.h"
+
+Q_DECLARE_METATYPE(PixelConverter::Kernel)
+
+/**
+ * Every SIMD kernel must give the same bytes as the scalar reference, on
+ * random rows whose widths leave a tail after the last full vector and
+ * which start 4 bytes past a 32 byte boundary. Kernels the CPU cannot run
+ * are skipped.
+ */
+class TestPixelConverter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanupTestCase();
+    void bgr24ToRgb32_data();
+    void bgr24ToRgb32();
+    void gray8ToRgb32_data();
+    void gray8ToRgb32();
+    void premultiply_data();
+    void premultiply();
+    void scale16To8_data();
+    void scale16To8();
+    void minMax16_data();
+    void minMax16();
+
+private:
+    static void addRows();
+    static bool useKernel(PixelConverter::Kernel kernel);
+    static QByteArray randomBytes(int count);
+    template<typename T>
+    static T *row(QByteArray &bytes);
+};
+
+void TestPixelConverter::cleanupTestCase()
+{
+    PixelConverter::setKernel(PixelConverter::bestKernel());
+}
+
+void TestPixelConverter::addRows()
+{
+    QTest::addColumn<PixelConverter::Kernel>("kernel");
+    QTest::addColumn<int>("width");
+
+    // around the 16 and 32 byte vectors of both kernels, and a long row
+    static const int widths[] = {0, 1, 3, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 67, 1001};
+    for (int width : widths) {
+        QTest::newRow(QString("sse4 %1").arg(width).toLatin1()) << PixelConverter::SSE4 << width;
+    }
+    for (int width : widths) {
+        QTest::newRow(QString("avx2 %1").arg(width).toLatin1()) << PixelConverter::AVX2 << width;
+    }
+}
+
+bool TestPixelConverter::useKernel(PixelConverter::Kernel kernel)
+{
+    if (kernel > PixelConverter::bestKernel())
+        return false;
+
+    PixelConverter::setKernel(kernel);
+    return PixelConverter::kernel() == kernel;
+}
+
+QByteArray TestPixelConverter::randomBytes(int count)
+{
+    // seeded from the row, so a failure can be reproduced
+    QRandomGenerator random(qHash(QByteArray(QTest::currentDataTag())) ^ qHash(QByteArray(QTest::currentTestFunction())));
+    QByteArray bytes(count + 32, Qt::Uninitialized);
+    for (int i = 0; i < bytes.size(); i++) {
+        bytes[i] = char(random.bounded(256));
+    }
+    return bytes;
+}
+
+template<typename T>
+T *TestPixelConverter::row(QByteArray &bytes)
+{
+    // aligned for T but not for any vector
+    quintptr address = quintptr(bytes.data());
+    return reinterpret_cast<T *>(bytes.data() + (36 - address % 32) % 32);
+}
+
+void TestPixelConverter::bgr24ToRgb32_data()
+{
+    addRows();
+}
+
+void TestPixelConverter::bgr24ToRgb32()
+{
+    QFETCH(PixelConverter::Kernel, kernel);
+    QFETCH(int, width);
+
+    QByteArray src = randomBytes(width * 3);
+    const uchar *pixels = row<uchar>(src);
+    QVector<quint32> expected(width), actual(width);
+
+    PixelConverter::setKernel(PixelConverter::Scalar);
+    PixelConverter::bgr24ToRgb32(pixels, expected.data(), width);
+    if (!useKernel(kernel))
+        QSKIP("The CPU does not support this kernel");
+    PixelConverter::bgr24ToRgb32(pixels, actual.data(), width);
+
+    QCOMPARE(actual, expected);
+}
+
+void TestPixelConverter::gray8ToRgb32_data()
+{
+    addRows();
+}
+
+void TestPixelConverter::gray8ToRgb32()
+{
+    QFETCH(PixelConverter::Kernel, kernel);
+    QFETCH(int, width);
+
+    QByteArray src = randomBytes(width);
+    const uchar *pixels = row<uchar>(src);
+    QVector<quint32> expected(width), actual(width);
+
+    PixelConverter::setKernel(PixelConverter::Scalar);
+    PixelConverter::gray8ToRgb32(pixels, expected.data(), width);
+    if (!useKernel(kernel))
+        QSKIP("The CPU does not support this kernel");
+    PixelConverter::gray8ToRgb32(pixels, actual.data(), width);
+
+    QCOMPARE(actual, expected);
+}
+
+void TestPixelConverter::premultiply_data()
+{
+    addRows();
+}
+
+void TestPixelConverter::premultiply()
+{
+    QFETCH(PixelConverter::Kernel, kernel);
+    QFETCH(int, width);
+
+    QByteArray src = randomBytes(width * 4);
+    quint32 *pixels = row<quint32>(src);
+    // transparent and opaque pixels take their own paths through the rounding
+    for (int x = 0; x < width; x += 5) {
+        pixels[x] &= 0x00ffffff;
+        if (x + 1 < width)
+            pixels[x + 1] |= 0xff000000;
+    }
+    QVector<quint32> expected(width), actual(width);
+
+    PixelConverter::setKernel(PixelConverter::Scalar);
+    PixelConverter::premultiply(pixels, expected.data(), width);
+    for (int x = 0; x < width; x++) {
+        QCOMPARE(expected.at(x), quint32(qPremultiply(pixels[x])));
+    }
+    if (!useKernel(kernel))
+        QSKIP("The CPU does not support this kernel");
+    PixelConverter::premultiply(pixels, actual.data(), width);
+
+    QCOMPARE(actual, expected);
+}
+
+void TestPixelConverter::scale16To8_data()
+{
+    addRows();
+}
+
+void TestPixelConverter::scale16To8()
+{
+    QFETCH(PixelConverter::Kernel, kernel);
+    QFETCH(int, width);
+
+    QByteArray src = randomBytes(width * 2);
+    const quint16 *samples = row<quint16>(src);
+
+    // the full range, a narrow window that clamps most samples, a single value and a reversed window
+    static const quint16 windows[][2] = {{0, 0xffff}, {1000, 1200}, {0x8000, 0x8000}, {5000, 100}};
+    for (const quint16 *window : windows) {
+        QByteArray expected(width, 0), actual(width, 0);
+
+        PixelConverter::setKernel(PixelConverter::Scalar);
+        PixelConverter::scale16To8(samples, reinterpret_cast<uchar *>(expected.data()), width,
+                                   window[0], window[1]);
+        if (!useKernel(kernel))
+            QSKIP("The CPU does not support this kernel");
+        PixelConverter::scale16To8(samples, reinterpret_cast<uchar *>(actual.data()), width,
+                                   window[0], window[1]);
+
+        QCOMPARE(actual, expected);
+    }
+}
+
+void TestPixelConverter::minMax16_data()
+{
+    addRows();
+}
+
+void TestPixelConverter::minMax16()
+{
+    QFETCH(PixelConverter::Kernel, kernel);
+    QFETCH(int, width);
+
+    QByteArray src = randomBytes(width * 2);
+    const quint16 *samples = row<quint16>(src);
+    quint16 expectedMin, expectedMax, actualMin, actualMax;
+
+    PixelConverter::setKernel(PixelConverter::Scalar);
+    PixelConverter::minMax16(samples, width, &expectedMin, &expectedMax);
+    if (!useKernel(kernel))
+        QSKIP("The CPU does not support this kernel");
+    PixelConverter::minMax16(samples, width, &actualMin, &actualMax);
+
+    QCOMPARE(actualMin, expectedMin);
+    QCOMPARE(actualMax, expectedMax);
+}
+
+QTEST_MAIN(TestPixelConverter)
+#include "tst_pixelconverter.moc"
@@ -0,0 +1,51 @@
+TARGET = tst_sampleloading
+include(../tests.pri)
+
+HEADERS = \
+    ../../FreeImage.h \
+    ../../annotationwriter.h \
+    ../../boxitem.h \
+    ../../boxitemmimedata.h \
+    ../../boxitempool.h \
+    ../../commands.h \
+    ../../customscene.h \
+    ../../editjournal.h \
+    ../../imageconverter.h \
+    ../../imagedecoder.h \
+    ../../imageitem.h \
+    ../../imageloader.h \
+    ../../imageprobe.h \
+    ../../imagepyramid.h \
+    ../../loadprofiler.h \
+    ../../multipageimage.h \
+    ../../pixelconverter.h \
+    ../../sampleimage.h \
+    ../../sampleimageitem.h \
+    ../../tiledimage.h \
+    ../../tiledimageitem.h \
+    ../../undohistory.h \
+    ../../yololabel.h
+SOURCES = \
+    tst_sampleloading.cpp \
+    ../../annotationwriter.cpp \
+    ../../boxitem.cpp \
+    ../../boxitemmimedata.cpp \
+    ../../boxitempool.cpp \
+    ../../commands.cpp \
+    ../../customscene.cpp \
+    ../../editjournal.cpp \
+    ../../imageconverter.cpp \
+    ../../imagedecoder.cpp \
+    ../../imageitem.cpp \
+    ../../imageloader.cpp \
+    ../../imageprobe.cpp \
+    ../../imagepyramid.cpp \
+    ../../loadprofiler.cpp \
+    ../../multipageimage.cpp \
+    ../../pixelconverter.cpp \
+    ../../sampleimage.cpp \
+    ../../sampleimageitem.cpp \
+    ../../tiledimage.cpp \
+    ../../tiledimageitem.cpp \
+    ../../undohistory.cpp \
+    ../../yololabel.cpp
@@ -0,0 +1,120 @@
+#include <QtTest>
+#include "customscene.h"
+#include "imageloader.h"
+
+Q_DECLARE_METATYPE(FREE_IMAGE_TYPE)
+
+/**
+ * High bit depth TIFFs must come out of the loader with both an 8-bit
+ * rendering and their samples, and the scene must paint them through a
+ * SampleImageItem.
+ */
+class TestSampleLoading : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void highDepthTiff_data();
+    void highDepthTiff();
+
+private:
+    static FIBITMAP *gradient(FREE_IMAGE_TYPE type, int width, int height);
+
+    QTemporaryDir _dir;
+};
+
+// odd sizes, so a row is not a multiple of any SIMD width
+static const int Width = 67;
+static const int Height = 45;
+
+void TestSampleLoading::initTestCase()
+{
+    QVERIFY(_dir.isValid());
+}
+
+FIBITMAP *TestSampleLoading::gradient(FREE_IMAGE_TYPE type, int width, int height)
+{
+    FIBITMAP *dib = FreeImage_AllocateT(type, width, height);
+    if (dib == nullptr)
+        return nullptr;
+
+    for (int y = 0; y < height; y++) {
+        BYTE *line = FreeImage_GetScanLine(dib, y);
+        for (int x = 0; x < width; x++) {
+            quint16 red = quint16(x * 65535 / (width - 1));
+            quint16 green = quint16(y * 65535 / (height - 1));
+            quint16 blue = quint16(65535 - red);
+            switch (type) {
+            case FIT_RGB16: {
+                FIRGB16 *pixel = reinterpret_cast<FIRGB16 *>(line) + x;
+                pixel->red = red;
+                pixel->green = green;
+                pixel->blue = blue;
+                break;
+            }
+            case FIT_RGBA16: {
+                FIRGBA16 *pixel = reinterpret_cast<FIRGBA16 *>(line) + x;
+                pixel->red = red;
+                pixel->green = green;
+                pixel->blue = blue;
+                pixel->alpha = 0xffff;
+                break;
+            }
+            case FIT_RGBF: {
+                FIRGBF *pixel = reinterpret_cast<FIRGBF *>(line) + x;
+                pixel->red = red / 256.0f;
+                pixel->green = green / 256.0f;
+                pixel->blue = blue / 256.0f;
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+    return dib;
+}
+
+void TestSampleLoading::highDepthTiff_data()
+{
+    QTest::addColumn<FREE_IMAGE_TYPE>("type");
+
+    QTest::newRow("rgb16") << FIT_RGB16;
+    QTest::newRow("rgba16") << FIT_RGBA16;
+    QTest::newRow("rgbf") << FIT_RGBF;
+}
+
+void TestSampleLoading::highDepthTiff()
+{
+    QFETCH(FREE_IMAGE_TYPE, type);
+
+    QString path = _dir.filePath(QString(QTest::currentDataTag()) + ".tif");
+    FIBITMAP *dib = gradient(type, Width, Height);
+    QVERIFY(dib != nullptr);
+    bool isSaved = FreeImage_Save(FIF_TIFF, dib, path.toLocal8Bit(), TIFF_NONE);
+    FreeImage_Unload(dib);
+    QVERIFY(isSaved);
+
+    QSize imageSize;
+    SampleImage samples;
+    QImage image = ImageLoader::decode(path, 0, &imageSize, &samples);
+    QVERIFY(!image.isNull());
+    QCOMPARE(image.size(), QSize(Width, Height));
+    QCOMPARE(imageSize, image.size());
+    QVERIFY(!samples.isNull());
+    QCOMPARE(samples.size(), image.size());
+    QCOMPARE(samples.channels(), 3);
+
+    ImagePyramid pyramid = ImageLoader::pyramid(path, image, QString());
+    pyramid.setSamples(samples);
+
+    CustomScene scene;
+    QSignalSpy samplesLoaded(&scene, SIGNAL(samplesLoaded()));
+    scene.loadImage(path, pyramid, imageSize);
+    QVERIFY(scene.sampleItem() != nullptr);
+    QCOMPARE(samplesLoaded.count(), 1);
+}
+
+QTEST_MAIN(TestSampleLoading)
+#include "tst_sampleloading.moc"
@@ -0,0 +1,15 @@
+# the tests build the sources they exercise straight from the application directory
+QT += widgets testlib
+CONFIG += c++17 testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += $$PWD/..
+DEPENDPATH += $$PWD/..
+
+win32 {
+    LIBS += -L$$PWD/../lib/ -lFreeImage
+}
+unix {
+    LIBS += -L$$PWD/../lib/ -lfreeimage -ltiff
+    DEFINES += HAVE_LIBTIFF
+}
@@ -0,0 +1,145 @@
+#include <QtTest>
+#include "yololabel.h"
+
+/**
+ * Checks that label files survive a parse and serialize round trip, that
+ * broken lines are reported with their text, and measures both directions
+ * on a file of 10k boxes next to the QTextStream parser and the sprintf
+ * writer they replaced.
+ */
+class TestYoloLabel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void roundTrip();
+    void rejectedLines();
+    void parse();
+    void parseTextStream();
+    void serialize();
+    void serializePrintf();
+
+private:
+    QVector<YoloBox> _boxes;
+    QByteArray _data;
+};
+
+static const int BoxCount = 10000;
+static const int ClassCount = 80;
+
+void TestYoloLabel::initTestCase()
+{
+    // the same boxes on every run, so the numbers can be compared
+    QRandomGenerator random(42);
+    _boxes.reserve(BoxCount);
+    for (int i = 0; i < BoxCount; i++) {
+        YoloBox box;
+        box.classIndex = random.bounded(ClassCount);
+        box.x = float(random.generateDouble());
+        box.y = float(random.generateDouble());
+        box.width = float(random.generateDouble() * 0.2);
+        box.height = float(random.generateDouble() * 0.2);
+        _boxes.append(box);
+    }
+    _data = YoloLabel::serialize(_boxes);
+}
+
+void TestYoloLabel::roundTrip()
+{
+    QVector<YoloBox> boxes;
+    QVector<YoloError> errors;
+    QVERIFY(YoloLabel::parse(_data, ClassCount, &boxes, &errors));
+    QVERIFY(errors.isEmpty());
+    QCOMPARE(boxes.count(), _boxes.count());
+
+    // the shortest form written reads back to the very same float
+    for (int i = 0; i < boxes.count(); i++) {
+        QCOMPARE(boxes.at(i).classIndex, _boxes.at(i).classIndex);
+        QCOMPARE(boxes.at(i).x, _boxes.at(i).x);
+        QCOMPARE(boxes.at(i).y, _boxes.at(i).y);
+        QCOMPARE(boxes.at(i).width, _boxes.at(i).width);
+        QCOMPARE(boxes.at(i).height, _boxes.at(i).height);
+    }
+    QCOMPARE(YoloLabel::serialize(boxes), _data);
+}
+
+void TestYoloLabel::rejectedLines()
+{
+    QByteArray data = "0 0.5 0.5 0.1 0.1\n"
+                      "80 0.5 0.5 0.1 0.1\n"
+                      "\n"
+                      "1 0.5 0.5 nan 0.1\n"
+                      "2 0.25 0.25 0.5 0.5\n";
+
+    QVector<YoloBox> boxes;
+    QVector<YoloError> errors;
+    QVERIFY(!YoloLabel::parse(data, ClassCount, &boxes, &errors));
+    QCOMPARE(boxes.count(), 2);
+    QCOMPARE(boxes.at(1).classIndex, 2);
+
+    QCOMPARE(errors.count(), 2);
+    QCOMPARE(errors.at(0).line, 2);
+    QCOMPARE(errors.at(0).text, QByteArray("80 0.5 0.5 0.1 0.1"));
+    QCOMPARE(errors.at(1).line, 4);
+    QCOMPARE(errors.at(1).text, QByteArray("1 0.5 0.5 nan 0.1"));
+}
+
+void TestYoloLabel::parse()
+{
+    QVector<YoloBox> boxes;
+    QBENCHMARK {
+        boxes.clear();
+        YoloLabel::parse(_data, ClassCount, &boxes);
+    }
+    QCOMPARE(boxes.count(), BoxCount);
+}
+
+void TestYoloLabel::parseTextStream()
+{
+    QVector<YoloBox> boxes;
+    QBENCHMARK {
+        boxes.clear();
+        QTextStream in(_data);
+        while (!in.atEnd()) {
+            QStringList info = in.readLine().split(" ");
+            if (info.size() >= 5) {
+                YoloBox box;
+                box.classIndex = info.at(0).toInt();
+                box.x = info.at(1).toFloat();
+                box.y = info.at(2).toFloat();
+                box.width = info.at(3).toFloat();
+                box.height = info.at(4).toFloat();
+                boxes.append(box);
+            }
+        }
+    }
+    QCOMPARE(boxes.count(), BoxCount);
+}
+
+void TestYoloLabel::serialize()
+{
+    QByteArray data;
+    QBENCHMARK {
+        data = YoloLabel::serialize(_boxes);
+    }
+    QCOMPARE(data, _data);
+}
+
+void TestYoloLabel::serializePrintf()
+{
+    QByteArray data;
+    QBENCHMARK {
+        data.clear();
+        char line[256];
+        foreach (const YoloBox &box, _boxes) {
+            int size = snprintf(line, sizeof(line), "%d %f %f %f %f\n",
+                                box.classIndex, box.x, box.y, box.width, box.height);
+            data.append(line, size);
+        }
+    }
+    QVERIFY(!data.isEmpty());
+}
+
+QTEST_MAIN(TestYoloLabel)
+#include "tst_yololabel.moc"
@@ -0,0 +1,10 @@
+TARGET = tst_yololabel
+include(../tests.pri)
+
+# the benchmarks are only meaningful in a release build:
+# qmake CONFIG+=release && make && ./tst_yololabel
+HEADERS = \
+    ../../yololabel.h
+SOURCES = \
+    tst_yololabel.cpp \
+    ../../yololabel.cpp
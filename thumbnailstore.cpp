@@ -0,0 +1,271 @@
+#include "thumbnailstore.h"
+#include "imageloader.h"
+#include "loadprofiler.h"
+#include "tiledimage.h"
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirModel>
+#include <QRunnable>
+#include <QSettings>
+#include <QThread>
+
+static const quint32 IndexMagic = 0x4c495448; // "LITH"
+static const quint32 IndexVersion = 1;
+static const int KeySize = 20;
+
+class ThumbnailFillTask : public QRunnable
+{
+public:
+    ThumbnailFillTask(ThumbnailStore *store, int serial):
+        _store(store),
+        _serial(serial)
+    {
+    }
+
+    void run() override
+    {
+        // thumbnails must not slow down decoding the image on screen,
+        // nor fill the load profile with decodes that are not image switches
+        QThread::currentThread()->setPriority(QThread::LowestPriority);
+        LoadProfiler::setRecording(false);
+
+        int size = _store->thumbnailSize();
+        QString path;
+        while (_store->nextPath(_serial, &path)) {
+            QFileInfo info(path);
+            if (_store->contains(info) || TiledImage::isTiled(path))
+                continue;
+
+            QSize imageSize;
+            QImage image = ImageLoader::decode(path, size, &imageSize);
+            if (image.isNull())
+                continue;
+            if (image.width() > size || image.height() > size)
+                image = image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+            QByteArray data;
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::WriteOnly);
+            if (!image.save(&buffer, "JPG", 85))
+                continue;
+
+            _store->append(ThumbnailStore::key(info), data, imageSize);
+            emit _store->thumbnailReady(path);
+        }
+
+        // the pool thread goes on to run other tasks
+        LoadProfiler::setRecording(true);
+    }
+
+private:
+    ThumbnailStore *_store;
+    int _serial;
+};
+
+ThumbnailStore::ThumbnailStore(QObject *parent):
+    QObject(parent),
+    _serial(0)
+{
+    QSettings settings;
+    _thumbnailSize = settings.value("thumbnails/size", 128).toInt();
+    _pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+}
+
+ThumbnailStore::~ThumbnailStore()
+{
+    cancel();
+    _pool.waitForDone();
+    if (_map != nullptr)
+        _pack.unmap(_map);
+}
+
+bool ThumbnailStore::open(const QString &dir)
+{
+    QMutexLocker locker(&_mutex);
+    QDir().mkpath(dir);
+    _pack.setFileName(QDir(dir).filePath("thumbnails.pack"));
+    _index.setFileName(QDir(dir).filePath("thumbnails.idx"));
+    if (!_pack.open(QIODevice::ReadWrite) || !_index.open(QIODevice::ReadWrite)) {
+        _pack.close();
+        _index.close();
+        return false;
+    }
+
+    QDataStream in(&_index);
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if (magic != IndexMagic || version != IndexVersion) {
+        // unknown or empty store, start over
+        _pack.resize(0);
+        _index.resize(0);
+        _index.seek(0);
+        QDataStream out(&_index);
+        out << IndexMagic << IndexVersion;
+        _index.flush();
+        return true;
+    }
+
+    qint64 packSize = _pack.size();
+    qint64 end = _index.pos();
+    while (!in.atEnd()) {
+        QByteArray key(KeySize, 0);
+        Entry entry;
+        if (in.readRawData(key.data(), KeySize) != KeySize)
+            break;
+        in >> entry.offset >> entry.length >> entry.width >> entry.height;
+        if (in.status() != QDataStream::Ok)
+            break;
+        end = _index.pos();
+
+        // the pack is written first, a record past its end was never completed
+        if (entry.offset + entry.length <= packSize)
+            _entries.insert(key, entry);
+    }
+
+    // cut a record torn by a crash so that appends stay aligned
+    _index.resize(end);
+    return true;
+}
+
+QByteArray ThumbnailStore::key(const QFileInfo &info)
+{
+    QString key = QString("%1|%2|%3")
+            .arg(info.absoluteFilePath())
+            .arg(info.size())
+            .arg(info.lastModified().toMSecsSinceEpoch());
+
+    return QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1);
+}
+
+bool ThumbnailStore::contains(const QFileInfo &info) const
+{
+    QByteArray k = key(info);
+    QMutexLocker locker(&_mutex);
+    return _entries.contains(k);
+}
+
+QImage ThumbnailStore::thumbnail(const QFileInfo &info, QSize *imageSize)
+{
+    QByteArray k = key(info);
+    QByteArray data;
+    {
+        QMutexLocker locker(&_mutex);
+        QHash<QByteArray, Entry>::const_iterator it = _entries.constFind(k);
+        if (it == _entries.constEnd())
+            return QImage();
+
+        const Entry &entry = it.value();
+        if (entry.offset + entry.length > _mappedSize) {
+            // the pack grew since it was mapped
+            if (_map != nullptr)
+                _pack.unmap(_map);
+            _mappedSize = _pack.size();
+            _map = _pack.map(0, _mappedSize);
+            if (_map == nullptr)
+                _mappedSize = 0;
+        }
+
+        // another call may remap the pack once the lock is released, so the
+        // few kilobytes of JPEG are copied out and decoded without the lock
+        if (_map != nullptr) {
+            data = QByteArray(reinterpret_cast<const char *>(_map + entry.offset), entry.length);
+        } else if (_pack.seek(entry.offset)) {
+            data = _pack.read(entry.length);
+        }
+        if (imageSize)
+            *imageSize = QSize(entry.width, entry.height);
+    }
+
+    return QImage::fromData(data, "JPG");
+}
+
+void ThumbnailStore::fill(const QStringList &paths)
+{
+    if (!_pack.isOpen())
+        return;
+
+    cancel();
+    int serial = _serial.load();
+    {
+        QMutexLocker locker(&_mutex);
+        _fillPaths = paths;
+        _fillNext = 0;
+    }
+    for (int i = 0; i < _pool.maxThreadCount(); i++) {
+        _pool.start(new ThumbnailFillTask(this, serial));
+    }
+}
+
+void ThumbnailStore::cancel()
+{
+    _serial.fetchAndAddOrdered(1);
+    _pool.clear();
+}
+
+bool ThumbnailStore::nextPath(int serial, QString *path)
+{
+    QMutexLocker locker(&_mutex);
+    if (serial != _serial.load() || _fillNext >= _fillPaths.count())
+        return false;
+
+    *path = _fillPaths.at(_fillNext++);
+    return true;
+}
+
+void ThumbnailStore::append(const QByteArray &key, const QByteArray &data, QSize imageSize)
+{
+    QMutexLocker locker(&_mutex);
+    if (_entries.contains(key))
+        return;
+
+    Entry entry;
+    entry.offset = _pack.size();
+    entry.length = data.size();
+    entry.width = imageSize.width();
+    entry.height = imageSize.height();
+    if (!_pack.seek(entry.offset) || _pack.write(data) != data.size())
+        return;
+    _pack.flush();
+
+    _index.seek(_index.size());
+    QDataStream out(&_index);
+    out.writeRawData(key.constData(), KeySize);
+    out << entry.offset << entry.length << entry.width << entry.height;
+    _index.flush();
+
+    _entries.insert(key, entry);
+}
+
+ThumbnailDelegate::ThumbnailDelegate(ThumbnailStore *store, QObject *parent):
+    QStyledItemDelegate(parent),
+    _store(store),
+    _icons(1024)
+{
+}
+
+void ThumbnailDelegate::invalidate(const QString &path)
+{
+    _icons.remove(path);
+}
+
+void ThumbnailDelegate::initStyleOption(QStyleOptionViewItem *option, const QModelIndex &index) const
+{
+    QStyledItemDelegate::initStyleOption(option, index);
+    if (index.column() != 0)
+        return;
+
+    QString path = index.data(QDirModel::FilePathRole).toString();
+    QIcon *icon = _icons.object(path);
+    if (icon == nullptr) {
+        QImage thumbnail = _store->thumbnail(QFileInfo(path));
+        icon = new QIcon(thumbnail.isNull() ? QIcon() : QIcon(QPixmap::fromImage(thumbnail)));
+        _icons.insert(path, icon);
+    }
+    if (!icon->isNull()) {
+        option->icon = *icon;
+        option->features |= QStyleOptionViewItem::HasDecoration;
+    }
+}
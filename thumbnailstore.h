@@ -0,0 +1,101 @@
+#ifndef THUMBNAILSTORE_H
+#define THUMBNAILSTORE_H
+
+#include <QObject>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QStringList>
+#include <QThreadPool>
+#include <QCache>
+#include <QIcon>
+#include <QStyledItemDelegate>
+
+/**
+ * @brief The ThumbnailStore class keeps thumbnails of the dataset on disk
+ *        across sessions, in one packed file plus an index.
+ *
+ * Entries are keyed by the source path, size and modification time, so an
+ * edited image gets a new thumbnail. Both files are only ever appended to;
+ * index records pointing past the end of the pack are dropped on open.
+ * Thumbnails are read from a memory mapping of the pack without touching
+ * the original images.
+ *
+ * fill() builds the missing thumbnails of a folder on low priority workers.
+ */
+class ThumbnailStore : public QObject
+{
+    Q_OBJECT
+public:
+    ThumbnailStore(QObject *parent = 0);
+    ~ThumbnailStore();
+
+    bool open(const QString &dir);
+    int thumbnailSize() const
+    {
+        return _thumbnailSize;
+    }
+
+    bool contains(const QFileInfo &info) const;
+    QImage thumbnail(const QFileInfo &info, QSize *imageSize = nullptr);
+
+    void fill(const QStringList &paths);
+    void cancel();
+
+signals:
+    void thumbnailReady(QString path);
+
+private:
+    friend class ThumbnailFillTask;
+
+    struct Entry {
+        qint64 offset;
+        qint32 length;
+        qint32 width;
+        qint32 height;
+    };
+
+    static QByteArray key(const QFileInfo &info);
+    void append(const QByteArray &key, const QByteArray &data, QSize imageSize);
+    bool nextPath(int serial, QString *path);
+
+    QFile _pack;
+    QFile _index;
+    uchar *_map = nullptr;
+    qint64 _mappedSize = 0;
+    QHash<QByteArray, Entry> _entries;
+    mutable QMutex _mutex;
+    int _thumbnailSize;
+
+    QThreadPool _pool;
+    QAtomicInt _serial;
+    QStringList _fillPaths;
+    int _fillNext = 0;
+};
+
+/**
+ * @brief The ThumbnailDelegate class shows stored thumbnails as the icons
+ *        of a file list, keeping the default icon for files without one.
+ */
+class ThumbnailDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    ThumbnailDelegate(ThumbnailStore *store, QObject *parent = 0);
+
+public slots:
+    void invalidate(const QString &path);
+
+protected:
+    void initStyleOption(QStyleOptionViewItem *option, const QModelIndex &index) const override;
+
+private:
+    ThumbnailStore *_store;
+    // null icons are kept too, so files without a thumbnail are not looked up on every paint
+    mutable QCache<QString, QIcon> _icons;
+};
+
+#endif // THUMBNAILSTORE_H
@@ -0,0 +1,336 @@
+#include "tiledimage.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QPainter>
+#include <QRunnable>
+#include <QSettings>
+#include <QThread>
+#include <climits>
+#ifdef HAVE_LIBTIFF
+#include <tiffio.h>
+#endif
+
+// tiled TIFFs below this size are decoded whole like any other image
+static const qint64 MinTiledPixels = qint64(4096) * 4096;
+// the overview is read from at most this many tiles and is at most this large
+static const int MaxOverviewTiles = 256;
+static const int MaxOverviewSize = 2048;
+
+class TileLoadTask : public QRunnable
+{
+public:
+    TileLoadTask(TiledImage *image, int level, int column, int row):
+        _image(image),
+        _level(level),
+        _column(column),
+        _row(row)
+    {
+    }
+
+    void run() override
+    {
+        QImage tile = _image->readTile(_level, _column, _row);
+        QMetaObject::invokeMethod(_image, "insertTile", Qt::QueuedConnection,
+                                  Q_ARG(int, _level), Q_ARG(int, _column), Q_ARG(int, _row),
+                                  Q_ARG(QImage, tile));
+    }
+
+private:
+    TiledImage *_image;
+    int _level;
+    int _column;
+    int _row;
+};
+
+class OverviewLoadTask : public QRunnable
+{
+public:
+    OverviewLoadTask(TiledImage *image):
+        _image(image)
+    {
+    }
+
+    void run() override
+    {
+        // a cancelled request may have been queued again, only one of them builds
+        if (!_image->_overviewState.testAndSetOrdered(TiledImage::OverviewQueued, TiledImage::OverviewStarted))
+            return;
+
+        QImage overview = _image->readOverview();
+        QMetaObject::invokeMethod(_image, "insertOverview", Qt::QueuedConnection,
+                                  Q_ARG(QImage, overview));
+    }
+
+private:
+    TiledImage *_image;
+};
+
+TiledImage::TiledImage(QObject *parent):
+    QObject(parent)
+{
+    QSettings settings;
+    qint64 budget = settings.value("cache/tileBudgetMB", 256).toLongLong() * 1024;
+    _tiles.setMaxCost(int(qMin<qint64>(budget, INT_MAX)));
+    _pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+}
+
+TiledImage::~TiledImage()
+{
+    _isClosing.storeRelease(1);
+    _pool.clear();
+    _pool.waitForDone();
+#ifdef HAVE_LIBTIFF
+    foreach (TIFF *handle, _allHandles) {
+        TIFFClose(handle);
+    }
+#endif
+}
+
+bool TiledImage::isTiled(const QString &path)
+{
+#ifdef HAVE_LIBTIFF
+    QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix != "tif" && suffix != "tiff")
+        return false;
+
+    TIFF *tif = TIFFOpen(QFile::encodeName(path).constData(), "r");
+    if (tif == nullptr)
+        return false;
+
+    quint32 width = 0, height = 0;
+    bool tiled = TIFFIsTiled(tif)
+            && TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width)
+            && TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height)
+            && qint64(width) * height >= MinTiledPixels;
+    TIFFClose(tif);
+
+    return tiled;
+#else
+    Q_UNUSED(path);
+    return false;
+#endif
+}
+
+bool TiledImage::open(const QString &path)
+{
+#ifdef HAVE_LIBTIFF
+    _path = path;
+    _levels.clear();
+
+    TIFF *tif = TIFFOpen(QFile::encodeName(path).constData(), "r");
+    if (tif == nullptr)
+        return false;
+
+    int directory = 0;
+    do {
+        quint32 width = 0, height = 0, tileWidth = 0, tileHeight = 0;
+        if (!TIFFIsTiled(tif)
+                || !TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width)
+                || !TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height)
+                || !TIFFGetField(tif, TIFFTAG_TILEWIDTH, &tileWidth)
+                || !TIFFGetField(tif, TIFFTAG_TILELENGTH, &tileHeight)) {
+            // the full resolution image must be tiled, later untiled pages are thumbnails
+            if (directory == 0)
+                break;
+            continue;
+        }
+
+        Level level;
+        level.directory = directory;
+        level.size = QSize(width, height);
+        level.tileSize = QSize(tileWidth, tileHeight);
+        if (_levels.isEmpty()) {
+            _levels.append(level);
+            continue;
+        }
+
+        // reduced resolution levels are smaller and keep the aspect ratio
+        QSize previous = _levels.last().size;
+        qreal aspect = size().width() * 1.0 / size().height();
+        if (level.size.width() < previous.width() && level.size.height() < previous.height()
+                && qAbs(level.size.width() * 1.0 / level.size.height() - aspect) < aspect * 0.05)
+            _levels.append(level);
+    } while (directory++, TIFFReadDirectory(tif));
+
+    if (_levels.isEmpty()) {
+        TIFFClose(tif);
+        return false;
+    }
+
+    // keep the handle for the first worker
+    _allHandles.append(tif);
+    _handles.append(tif);
+
+    return true;
+#else
+    Q_UNUSED(path);
+    return false;
+#endif
+}
+
+int TiledImage::levelForScale(qreal scale) const
+{
+    // the coarsest level that still has at least one pixel per screen pixel
+    int level = 0;
+    for (int i = 1; i < _levels.count(); i++) {
+        if (_levels.at(i).size.width() >= size().width() * scale)
+            level = i;
+    }
+
+    return level;
+}
+
+void TiledImage::requestTile(int level, int column, int row)
+{
+    quint64 key = tileKey(level, column, row);
+    if (_pending.contains(key))
+        return;
+
+    _pending.insert(key);
+    _pool.start(new TileLoadTask(this, level, column, row));
+}
+
+void TiledImage::cancelPending()
+{
+    _pool.clear();
+    _pending.clear();
+
+    // the overview is still needed whatever the zoom, a request that never started is queued again
+    if (_overviewState.testAndSetOrdered(OverviewQueued, OverviewNone))
+        requestOverview();
+}
+
+void TiledImage::requestOverview()
+{
+    if (_overviewState.testAndSetOrdered(OverviewNone, OverviewQueued))
+        _pool.start(new OverviewLoadTask(this));
+}
+
+void TiledImage::insertTile(int level, int column, int row, QImage image)
+{
+    quint64 key = tileKey(level, column, row);
+    _pending.remove(key);
+    if (image.isNull())
+        return;
+
+    int cost = int(qMax<qint64>(1, image.sizeInBytes() / 1024));
+    _tiles.insert(key, new QPixmap(QPixmap::fromImage(image)), cost);
+    emit tileReady(level, column, row);
+}
+
+void TiledImage::insertOverview(QImage image)
+{
+    if (image.isNull())
+        return;
+
+    _overview = QPixmap::fromImage(image);
+    emit overviewReady();
+}
+
+QImage TiledImage::readOverview()
+{
+    int level = _levels.count() - 1;
+    QSize levelSize = _levels.at(level).size;
+    QSize tileSize = _levels.at(level).tileSize;
+    int columns = (levelSize.width() + tileSize.width() - 1) / tileSize.width();
+    int rows = (levelSize.height() + tileSize.height() - 1) / tileSize.height();
+
+    // every stride-th tile in both directions stands for a stride x stride block
+    int stride = 1;
+    while (qint64((columns + stride - 1) / stride) * ((rows + stride - 1) / stride) > MaxOverviewTiles)
+        stride++;
+
+    qreal scale = qMin(1.0, MaxOverviewSize * 1.0 / qMax(levelSize.width(), levelSize.height()));
+    QImage overview(qMax(1, qRound(levelSize.width() * scale)), qMax(1, qRound(levelSize.height() * scale)),
+                    QImage::Format_ARGB32_Premultiplied);
+    overview.fill(Qt::darkGray);
+
+    QPainter painter(&overview);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    for (int row = 0; row < rows; row += stride) {
+        for (int column = 0; column < columns; column += stride) {
+            if (_isClosing.loadAcquire())
+                return QImage();
+
+            // the middle tile of a block looks most like the rest of it
+            QImage tile = readTile(level, qMin(column + stride / 2, columns - 1), qMin(row + stride / 2, rows - 1));
+            if (tile.isNull())
+                continue;
+
+            QRectF block(column * tileSize.width() * scale, row * tileSize.height() * scale,
+                         stride * tileSize.width() * scale, stride * tileSize.height() * scale);
+            if (stride == 1)
+                block.setSize(QSizeF(tile.size()) * scale);
+            painter.drawImage(block, tile);
+        }
+    }
+    painter.end();
+
+    return overview;
+}
+
+QImage TiledImage::readTile(int level, int column, int row)
+{
+    QImage image;
+#ifdef HAVE_LIBTIFF
+    TIFF *tif = acquireHandle();
+    if (tif == nullptr)
+        return image;
+
+    const Level &l = _levels.at(level);
+    int tileWidth = l.tileSize.width();
+    int tileHeight = l.tileSize.height();
+    if (TIFFCurrentDirectory(tif) == l.directory || TIFFSetDirectory(tif, l.directory)) {
+        QVector<quint32> raster(tileWidth * tileHeight);
+        if (TIFFReadRGBATile(tif, column * tileWidth, row * tileHeight, raster.data())) {
+            // edge tiles are cut to the image area
+            int width = qMin(tileWidth, l.size.width() - column * tileWidth);
+            int height = qMin(tileHeight, l.size.height() - row * tileHeight);
+            image = QImage(width, height, QImage::Format_ARGB32_Premultiplied);
+            for (int y = 0; y < height; y++) {
+                // the raster is stored bottom-up
+                const quint32 *src = raster.constData() + (tileHeight - 1 - y) * tileWidth;
+                QRgb *dst = reinterpret_cast<QRgb *>(image.scanLine(y));
+                // TIFFReadRGBATile gives associated alpha, the raster is premultiplied already
+                for (int x = 0; x < width; x++) {
+                    quint32 p = src[x];
+                    dst[x] = qRgba(TIFFGetR(p), TIFFGetG(p), TIFFGetB(p), TIFFGetA(p));
+                }
+            }
+        }
+    }
+    releaseHandle(tif);
+#else
+    Q_UNUSED(level);
+    Q_UNUSED(column);
+    Q_UNUSED(row);
+#endif
+    return image;
+}
+
+struct tiff *TiledImage::acquireHandle()
+{
+#ifdef HAVE_LIBTIFF
+    {
+        QMutexLocker locker(&_mutex);
+        if (!_handles.isEmpty())
+            return _handles.takeLast();
+    }
+
+    // libtiff handles are not thread safe, every busy worker gets its own
+    TIFF *tif = TIFFOpen(QFile::encodeName(_path).constData(), "r");
+    if (tif != nullptr) {
+        QMutexLocker locker(&_mutex);
+        _allHandles.append(tif);
+    }
+    return tif;
+#else
+    return nullptr;
+#endif
+}
+
+void TiledImage::releaseHandle(struct tiff *handle)
+{
+    QMutexLocker locker(&_mutex);
+    _handles.append(handle);
+}
@@ -0,0 +1,117 @@
+#ifndef TILEDIMAGE_H
+#define TILEDIMAGE_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QImage>
+#include <QPixmap>
+#include <QCache>
+#include <QMutex>
+#include <QSet>
+#include <QVector>
+#include <QThreadPool>
+
+struct tiff;
+
+/**
+ * @brief The TiledImage class streams the tiles of a tiled TIFF through
+ *        libtiff instead of decoding the whole image into memory.
+ *
+ * Every tiled directory that is smaller than the previous one is used as a
+ * reduced resolution level, as found in pyramidal slide scans and GeoTIFFs.
+ * Tiles are decoded on a worker pool, each worker using its own TIFF handle,
+ * and are kept in a cache bounded by their size in memory.
+ *
+ * Zoomed out too far to stream the tiles of even the coarsest level, the
+ * image is painted from an overview. It is built in the background from
+ * every Nth tile of the coarsest level, each one stretched over the block
+ * of tiles it stands for.
+ */
+class TiledImage : public QObject
+{
+    Q_OBJECT
+public:
+    TiledImage(QObject *parent = 0);
+    ~TiledImage();
+
+    static bool isTiled(const QString &path);
+    bool open(const QString &path);
+
+    QSize size() const
+    {
+        return _levels.isEmpty() ? QSize() : _levels.first().size;
+    }
+    int levelCount() const
+    {
+        return _levels.count();
+    }
+    QSize levelSize(int level) const
+    {
+        return _levels.at(level).size;
+    }
+    QSize tileSize(int level) const
+    {
+        return _levels.at(level).tileSize;
+    }
+    int levelForScale(qreal scale) const;
+
+    QPixmap *tile(int level, int column, int row)
+    {
+        return _tiles.object(tileKey(level, column, row));
+    }
+    void requestTile(int level, int column, int row);
+    void cancelPending();
+
+    const QPixmap &overview() const
+    {
+        return _overview;
+    }
+    void requestOverview();
+
+signals:
+    void tileReady(int level, int column, int row);
+    void overviewReady();
+
+private slots:
+    void insertTile(int level, int column, int row, QImage image);
+    void insertOverview(QImage image);
+
+private:
+    friend class TileLoadTask;
+    friend class OverviewLoadTask;
+
+    enum OverviewState {
+        OverviewNone,
+        OverviewQueued,
+        OverviewStarted
+    };
+
+    struct Level {
+        int directory;
+        QSize size;
+        QSize tileSize;
+    };
+
+    static quint64 tileKey(int level, int column, int row)
+    {
+        return (quint64(level) << 48) | (quint64(row) << 24) | quint64(column);
+    }
+    QImage readTile(int level, int column, int row);
+    QImage readOverview();
+    struct tiff *acquireHandle();
+    void releaseHandle(struct tiff *handle);
+
+    QString _path;
+    QVector<Level> _levels;
+    QCache<quint64, QPixmap> _tiles;
+    QSet<quint64> _pending;
+    QPixmap _overview;
+    QAtomicInt _overviewState;
+    QAtomicInt _isClosing;
+    QThreadPool _pool;
+    QMutex _mutex;
+    QList<struct tiff *> _handles;
+    QList<struct tiff *> _allHandles;
+};
+
+#endif // TILEDIMAGE_H
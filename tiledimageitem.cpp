@@ -0,0 +1,131 @@
+#include "tiledimageitem.h"
+#include <QPainter>
+
+// zoomed far out on an image without reduced levels, the overview is painted instead of tiles
+static const int MaxRequestedTiles = 256;
+
+TiledImageItem::TiledImageItem(TiledImage *source, QGraphicsItem *parent):
+    QGraphicsObject(parent),
+    _source(source)
+{
+    _source->setParent(this);
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    connect(_source, SIGNAL(tileReady(int, int, int)), this, SLOT(updateTile(int, int, int)));
+    connect(_source, SIGNAL(overviewReady()), this, SLOT(updateOverview()));
+}
+
+QRectF TiledImageItem::boundingRect() const
+{
+    return QRectF(QPointF(0, 0), _source->size());
+}
+
+QRectF TiledImageItem::tileRect(int level, int column, int row) const
+{
+    // tile area in full resolution image coordinates
+    QSize levelSize = _source->levelSize(level);
+    QSize tileSize = _source->tileSize(level);
+    qreal sx = _source->size().width() * 1.0 / levelSize.width();
+    qreal sy = _source->size().height() * 1.0 / levelSize.height();
+    QRectF rect(column * tileSize.width() * sx, row * tileSize.height() * sy,
+                tileSize.width() * sx, tileSize.height() * sy);
+
+    return rect.intersected(boundingRect());
+}
+
+void TiledImageItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    qreal scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    int level = _source->levelForScale(scale);
+    if (level != _level) {
+        // tiles queued for the previous zoom level are not needed any more
+        _source->cancelPending();
+        _level = level;
+    }
+
+    QRectF exposed = option->exposedRect.intersected(boundingRect());
+    if (exposed.isEmpty())
+        return;
+
+    QSize levelSize = _source->levelSize(level);
+    QSize tileSize = _source->tileSize(level);
+    qreal sx = levelSize.width() * 1.0 / _source->size().width();
+    qreal sy = levelSize.height() * 1.0 / _source->size().height();
+    int firstColumn = int(exposed.left() * sx) / tileSize.width();
+    int lastColumn = qMin(int(exposed.right() * sx), levelSize.width() - 1) / tileSize.width();
+    int firstRow = int(exposed.top() * sy) / tileSize.height();
+    int lastRow = qMin(int(exposed.bottom() * sy), levelSize.height() - 1) / tileSize.height();
+    bool request = (lastColumn - firstColumn + 1) * (lastRow - firstRow + 1) <= MaxRequestedTiles;
+
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, scale < 1);
+    if (!request) {
+        _source->requestOverview();
+        if (!paintOverview(painter, exposed))
+            painter->fillRect(exposed, Qt::darkGray);
+        return;
+    }
+
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn; column <= lastColumn; column++) {
+            QRectF target = tileRect(level, column, row);
+            QPixmap *tile = _source->tile(level, column, row);
+            if (tile) {
+                painter->drawPixmap(target, *tile, tile->rect());
+                continue;
+            }
+
+            _source->requestTile(level, column, row);
+            painter->fillRect(target, Qt::darkGray);
+            paintFallback(painter, level, target);
+        }
+    }
+}
+
+void TiledImageItem::paintFallback(QPainter *painter, int level, const QRectF &target)
+{
+    // stretch the matching part of a cached coarser tile over the missing one
+    for (int l = level + 1; l < _source->levelCount(); l++) {
+        QSize levelSize = _source->levelSize(l);
+        QSize tileSize = _source->tileSize(l);
+        qreal sx = levelSize.width() * 1.0 / _source->size().width();
+        qreal sy = levelSize.height() * 1.0 / _source->size().height();
+        int column = int(target.center().x() * sx) / tileSize.width();
+        int row = int(target.center().y() * sy) / tileSize.height();
+
+        QPixmap *tile = _source->tile(l, column, row);
+        if (tile == nullptr)
+            continue;
+
+        QRectF coarse = tileRect(l, column, row);
+        QRectF part = target.intersected(coarse);
+        QRectF source((part.left() - coarse.left()) * sx, (part.top() - coarse.top()) * sy,
+                      part.width() * sx, part.height() * sy);
+        painter->drawPixmap(part, *tile, source);
+        return;
+    }
+
+    paintOverview(painter, target);
+}
+
+bool TiledImageItem::paintOverview(QPainter *painter, const QRectF &target)
+{
+    const QPixmap &overview = _source->overview();
+    if (overview.isNull())
+        return false;
+
+    qreal sx = overview.width() * 1.0 / _source->size().width();
+    qreal sy = overview.height() * 1.0 / _source->size().height();
+    QRectF source(target.left() * sx, target.top() * sy, target.width() * sx, target.height() * sy);
+    painter->drawPixmap(target, overview, source);
+    return true;
+}
+
+void TiledImageItem::updateTile(int level, int column, int row)
+{
+    if (level == _level || _level < 0)
+        update(tileRect(level, column, row));
+}
+
+void TiledImageItem::updateOverview()
+{
+    update();
+}
@@ -0,0 +1,38 @@
+#ifndef TILEDIMAGEITEM_H
+#define TILEDIMAGEITEM_H
+
+#include <QGraphicsObject>
+#include <QStyleOptionGraphicsItem>
+#include "tiledimage.h"
+
+/**
+ * @brief The TiledImageItem class paints the tiles of a TiledImage that
+ *        intersect the exposed area, at the level matching the view scale.
+ *
+ * Missing tiles are requested from the source and drawn from a coarser
+ * cached level, or from the overview, until they arrive. Zoomed out too far
+ * to stream tiles, only the overview is painted.
+ */
+class TiledImageItem : public QGraphicsObject
+{
+    Q_OBJECT
+public:
+    TiledImageItem(TiledImage *source, QGraphicsItem *parent = 0);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private slots:
+    void updateTile(int level, int column, int row);
+    void updateOverview();
+
+private:
+    QRectF tileRect(int level, int column, int row) const;
+    void paintFallback(QPainter *painter, int level, const QRectF &target);
+    bool paintOverview(QPainter *painter, const QRectF &target);
+
+    TiledImage *_source;
+    int _level = -1;
+};
+
+#endif // TILEDIMAGEITEM_H
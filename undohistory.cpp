@@ -0,0 +1,30 @@
+#include "undohistory.h"
+#include <QSettings>
+#include <climits>
+
+qint64 UndoHistoryEntry::sizeInBytes() const
+{
+    qint64 bytes = sizeof(*this) + fileIds.count() * sizeof(int) + fileHash.size();
+    foreach (const BoxCommand *command, commands) {
+        bytes += command->sizeInBytes();
+    }
+    return bytes;
+}
+
+UndoHistory::UndoHistory()
+{
+    QSettings settings;
+    qint64 budget = settings.value("undo/historyBudgetMB", 16).toLongLong() * 1024 * 1024;
+    _entries.setMaxCost(int(qBound<qint64>(0, budget, INT_MAX)));
+}
+
+void UndoHistory::insert(const QString &fileName, UndoHistoryEntry *entry)
+{
+    // an entry larger than the whole budget is deleted right away by QCache
+    _entries.insert(fileName, entry, int(qMin<qint64>(entry->sizeInBytes(), INT_MAX)));
+}
+
+UndoHistoryEntry *UndoHistory::take(const QString &fileName)
+{
+    return _entries.take(fileName);
+}
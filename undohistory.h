@@ -0,0 +1,62 @@
+#ifndef UNDOHISTORY_H
+#define UNDOHISTORY_H
+
+#include <QCache>
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include "commands.h"
+
+/**
+ * @brief The UndoHistoryEntry struct is the undo history of one label file
+ *        together with the content of the file it applies to.
+ */
+struct UndoHistoryEntry
+{
+    ~UndoHistoryEntry()
+    {
+        qDeleteAll(commands);
+    }
+    qint64 sizeInBytes() const;
+
+    QList<BoxCommand *> commands;
+    int index = 0;
+    // box ids in the order they were written to the label file
+    QVector<int> fileIds;
+    int nextId = 1;
+    // SHA-1 of the label file content the history applies to
+    QByteArray fileHash;
+};
+
+/**
+ * @brief The UndoHistory class keeps the undo histories of label files that
+ *        are no longer shown, least recently used first out once their total
+ *        size exceeds the budget.
+ */
+class UndoHistory
+{
+public:
+    UndoHistory();
+
+    void insert(const QString &fileName, UndoHistoryEntry *entry);
+    UndoHistoryEntry *take(const QString &fileName);
+    void remove(const QString &fileName)
+    {
+        _entries.remove(fileName);
+    }
+
+    qint64 bytes() const
+    {
+        return _entries.totalCost();
+    }
+    qint64 budget() const
+    {
+        return _entries.maxCost();
+    }
+
+private:
+    QCache<QString, UndoHistoryEntry> _entries;
+};
+
+#endif // UNDOHISTORY_H
@@ -0,0 +1,109 @@
+#include "yololabel.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+static inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char *skipBlanks(const char *p, const char *end)
+{
+    while (p < end && isBlank(*p))
+        p++;
+    return p;
+}
+
+// a field must be followed by a blank or the end of the line
+static inline bool endOfField(const char *p, const char *end)
+{
+    return p == end || isBlank(*p);
+}
+
+static const char *parseLine(const char *p, const char *end, int classCount, YoloBox *box)
+{
+    p = skipBlanks(p, end);
+    std::from_chars_result result = std::from_chars(p, end, box->classIndex);
+    if (result.ec != std::errc() || !endOfField(result.ptr, end))
+        return "invalid class index";
+    if (box->classIndex < 0 || box->classIndex >= classCount)
+        return "class index out of range";
+    p = result.ptr;
+
+    float *fields[4] = { &box->x, &box->y, &box->width, &box->height };
+    for (float *field : fields) {
+        p = skipBlanks(p, end);
+        if (p == end)
+            return "missing field";
+        result = std::from_chars(p, end, *field);
+        if (result.ec != std::errc() || !endOfField(result.ptr, end) || !std::isfinite(*field))
+            return "invalid number";
+        p = result.ptr;
+    }
+
+    if (skipBlanks(p, end) != end)
+        return "unexpected field";
+    return nullptr;
+}
+
+bool YoloLabel::parse(const QByteArray &data, int classCount, QVector<YoloBox> *boxes,
+                      QVector<YoloError> *errors)
+{
+    const char *p = data.constData();
+    const char *end = p + data.size();
+    bool ok = true;
+    int line = 0;
+
+    boxes->reserve(boxes->size() + int(data.count('\n')) + 1);
+    while (p < end) {
+        const char *lineEnd = static_cast<const char *>(memchr(p, '\n', size_t(end - p)));
+        if (lineEnd == nullptr)
+            lineEnd = end;
+        line++;
+
+        // blank lines are allowed, a file usually ends with one
+        if (skipBlanks(p, lineEnd) != lineEnd) {
+            YoloBox box;
+            const char *message = parseLine(p, lineEnd, classCount, &box);
+            if (message == nullptr) {
+                boxes->append(box);
+            } else {
+                ok = false;
+                if (errors) {
+                    YoloError error;
+                    error.line = line;
+                    error.message = message;
+                    error.text = QByteArray(p, int(lineEnd - p));
+                    errors->append(error);
+                }
+            }
+        }
+        p = lineEnd + 1;
+    }
+
+    return ok;
+}
+
+QByteArray YoloLabel::serialize(const QVector<YoloBox> &boxes)
+{
+    // an int and four floats in shortest fixed notation stay below this, even the extreme ones
+    static const int MaxLineSize = 256;
+
+    QByteArray data;
+    data.resize(boxes.size() * MaxLineSize);
+    char *begin = data.data();
+    char *p = begin;
+    for (const YoloBox &box : boxes) {
+        char *end = p + MaxLineSize;
+        p = std::to_chars(p, end, box.classIndex).ptr;
+        for (float value : { box.x, box.y, box.width, box.height }) {
+            *p++ = ' ';
+            p = std::to_chars(p, end, value, std::chars_format::fixed).ptr;
+        }
+        *p++ = '\n';
+    }
+    data.resize(int(p - begin));
+
+    return data;
+}
@@ -0,0 +1,42 @@
+#ifndef YOLOLABEL_H
+#define YOLOLABEL_H
+
+#include <QByteArray>
+#include <QVector>
+
+// one line of a label file, the box center and size are relative to the image size
+struct YoloBox
+{
+    int classIndex = 0;
+    float x = 0;
+    float y = 0;
+    float width = 0;
+    float height = 0;
+};
+
+struct YoloError
+{
+    int line = 0;
+    const char *message = nullptr;
+    // the line as it was read, without its line break
+    QByteArray text;
+};
+
+/**
+ * @brief The YoloLabel class reads and writes YOLO label files, one
+ *        "class x y width height" line per box.
+ *
+ * Both directions work on the raw bytes with std::from_chars and
+ * std::to_chars, without a temporary string per line or field. Numbers are
+ * written in the shortest form that reads back to the same float.
+ */
+class YoloLabel
+{
+public:
+    // lines that fail are reported with their text and skipped, the others are still returned
+    static bool parse(const QByteArray &data, int classCount, QVector<YoloBox> *boxes,
+                      QVector<YoloError> *errors = nullptr);
+    static QByteArray serialize(const QVector<YoloBox> &boxes);
+};
+
+#endif // YOLOLABEL_H